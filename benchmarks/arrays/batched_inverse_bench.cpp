@@ -0,0 +1,37 @@
+// Inversion of a batch of small matrices : batched_inverse_in_place vs one matrix at a time with lapack.
+// Usage : batched_inverse_bench [n_mat]
+// Built by make benchmarks, not run by ctest.
+#include <triqs/arrays.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+// A batch of invertible matrices, which need pivoting (small diagonal elements)
+array<dcomplex, 3> make_batch(int n_mat, int n) {
+ array<dcomplex, 3> a(n_mat, n, n);
+ for (int i = 0; i < n_mat; ++i)
+  for (int j = 0; j < n; ++j)
+   for (int k = 0; k < n; ++k) a(i, j, k) = 1 / (1.0 + i + j + 2 * k) + 0.01 * (j == k) + 0.3 * ((j * 7 + k * 3 + i) % 5);
+ return a;
+}
+
+int main(int argc, char *argv[]) {
+ int n_mat = (argc > 1 ? std::atoi(argv[1]) : 20000);
+ for (int n : {2, 4, 6, 8}) {
+  auto a = make_batch(n_mat, n), b = a;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n_mat; ++i) {
+   auto v = make_matrix_view(a(i, range(), range()));
+   v = inverse(v);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  batched_inverse_in_place(b);
+  auto t2 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> t_loop = t1 - t0, t_batch = t2 - t1;
+  std::cout << n << "x" << n << " : one by one " << t_loop.count() << " s, batched " << t_batch.count() << " s, speedup "
+            << t_loop.count() / t_batch.count() << ", max diff " << max_element(abs(a - b)) << std::endl;
+ }
+}
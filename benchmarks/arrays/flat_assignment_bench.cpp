@@ -0,0 +1,40 @@
+// The typical update of the data of a matrix valued gf : flat loop of the assignment vs foreach.
+// Usage : flat_assignment_bench [n_rep] [n_iw]
+// Built by make benchmarks, not run by ctest.
+#include <triqs/gfs.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace triqs::gfs;
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+int main(int argc, char *argv[]) {
+ int n_rep = (argc > 1 ? std::atoi(argv[1]) : 200);
+ int n_iw = (argc > 2 ? std::atoi(argv[2]) : 1000);
+ double beta = 10;
+ for (int n : {1, 2, 4, 8}) {
+  auto G = gf<imfreq>{{beta, Fermion, n_iw}, {n, n}}, G_ref = G, G0 = G, S = G;
+  for (auto const &om : G0.mesh()) {
+   for (int j = 0; j < n; ++j)
+    for (int k = 0; k < n; ++k) {
+     G0[om](j, k) = 1 / (dcomplex(om) - j * k);
+     S[om](j, k) = 0.1 * j - dcomplex(0, 0.01) * k;
+    }
+  }
+  G.data()() = 0;
+  G_ref.data()() = 0;
+  auto &g = G.data(), &g_ref = G_ref.data(), &g0 = G0.data(), &s = S.data();
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < n_rep; ++r) foreach(g_ref, [&](long i, long j, long k) { g_ref(i, j, k) += 0.5 * g0(i, j, k) - s(i, j, k); });
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < n_rep; ++r) g += 0.5 * g0 - s;
+  auto t2 = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> t_foreach = t1 - t0, t_flat = t2 - t1;
+  std::cout << n << "x" << n << " : foreach " << t_foreach.count() << " s, flat " << t_flat.count() << " s, speedup "
+            << t_foreach.count() / t_flat.count() << ", max diff " << max_element(abs(g - g_ref)) << std::endl;
+ }
+}
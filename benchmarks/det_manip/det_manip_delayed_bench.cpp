@@ -0,0 +1,61 @@
+// Throughput of det_manip with delayed updates, as a function of the size N and of the number of delayed updates k.
+// Usage : det_manip_delayed_bench [n_moves] [N1 N2 ...]
+// Built by make benchmarks, not run by ctest.
+#include <triqs/det_manip/det_manip.hpp>
+#include <triqs/mc_tools/random_generator.hpp>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using triqs::det_manip::det_manip;
+
+struct fun {
+ double operator()(double x, double y) const { return std::sin(13 * x * y + 3 * x - y); }
+};
+
+// A Metropolis random walk of insert/remove/change_col moves, around size N, with weight |det|.
+// Returns the number of moves per second.
+double run(int N, int k, long n_moves) {
+ det_manip<fun> D(fun{}, N + 10);
+ D.set_n_delayed_updates(k);
+ D.set_n_operations_before_check(1000000); // measure only the updates, not the periodic O(N^3) check
+ triqs::mc_tools::random_generator RNG("mt19937", 2134);
+ while (D.size() < N) {
+  size_t s = D.size();
+  if (RNG(1.0) < std::abs(D.try_insert(s, s, RNG(10.0), RNG(10.0)))) D.complete_operation();
+ }
+
+ auto t0 = std::chrono::steady_clock::now();
+ for (long n = 0; n < n_moves; ++n) {
+  size_t s = D.size();
+  double r = 0;
+  switch (RNG(3)) {
+   case 0:
+    if (s < N + 5) r = D.try_insert(RNG(s + 1), RNG(s + 1), RNG(10.0), RNG(10.0));
+    break;
+   case 1:
+    if (s > N - 5) r = D.try_remove(RNG(s), RNG(s));
+    break;
+   case 2: r = D.try_change_col(RNG(s), RNG(10.0)); break;
+  }
+  if (RNG(1.0) < std::abs(r)) D.complete_operation();
+ }
+ std::chrono::duration<double> t = std::chrono::steady_clock::now() - t0;
+ return n_moves / t.count();
+}
+
+int main(int argc, char **argv) {
+ long n_moves = (argc > 1 ? std::atol(argv[1]) : 2000);
+ std::vector<int> Ns;
+ for (int i = 2; i < argc; ++i) Ns.push_back(std::atoi(argv[i]));
+ if (Ns.empty()) Ns = {20, 100};
+
+ std::cout << std::setw(6) << "N" << std::setw(6) << "k" << std::setw(16) << "moves/s" << std::setw(10) << "speedup" << std::endl;
+ for (auto N : Ns) {
+  double r0 = run(N, 0, n_moves);
+  for (int k : {0, 2, 4, 8, 16, 32}) {
+   double r = (k == 0 ? r0 : run(N, k, n_moves));
+   std::cout << std::setw(6) << N << std::setw(6) << k << std::setw(16) << r << std::setw(10) << r / r0 << std::endl;
+  }
+ }
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "start.hpp"
+#include <triqs/arrays/storages/allocators.hpp>
+#include <thread>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+
+using namespace triqs::arrays::storages;
+
+bool is_aligned(void const* p) { return reinterpret_cast<std::uintptr_t>(p) % allocators::alignment == 0; }
+
+TEST(Allocators, Alignment) {
+ for (size_t s : {1, 3, 17, 100, 1000, 100000, 10000000}) {
+  array<double, 1> a(s);
+  array<dcomplex, 2> b(s, 2);
+  EXPECT_TRUE(is_aligned(a.data_start()));
+  EXPECT_TRUE(is_aligned(b.data_start()));
+ }
+ void* p = allocators::aligned::allocate(24);
+ EXPECT_TRUE(is_aligned(p));
+ allocators::aligned::deallocate(p, 24);
+}
+
+TEST(Allocators, PoolReuse) {
+ // a freed block is given back to the next allocation of the same size class in the same thread
+ void* p1 = allocators::pooled::allocate(1000);
+ allocators::pooled::deallocate(p1, 1000);
+ void* p2 = allocators::pooled::allocate(1020);
+ EXPECT_EQ(p1, p2);
+ allocators::pooled::deallocate(p2, 1020);
+
+ // typical temporaries, if the arrays use the pool (cmake option USE_ARRAYS_POOL)
+ if (!std::is_same<mem_block<double>::allocator, allocators::pooled>::value) return;
+ array<double, 2> A(10, 10);
+ A() = 1;
+ double const* p = nullptr;
+ for (int i = 0; i < 10; ++i) {
+  array<double, 2> B = 2 * A;
+  if (i > 0) {
+   EXPECT_TRUE(B.data_start() == p);
+  }
+  p = B.data_start();
+  EXPECT_ARRAY_NEAR(B, 2 * A);
+ }
+ allocators::pooled::release_thread_cache();
+}
+
+TEST(Allocators, NonTrivialElements) {
+ // elements are default constructed, copied and destroyed properly
+ array<std::string, 1> a(50);
+ for (int i = 0; i < 50; ++i) {
+  EXPECT_TRUE(a(i).empty());
+  a(i) = std::string(100, 'a' + i % 26);
+ }
+ array<std::string, 1> b = a;
+ for (int i = 0; i < 50; ++i) EXPECT_EQ(b(i), a(i));
+
+ array<array<double, 1>, 1> c(5);
+ for (int i = 0; i < 5; ++i) {
+  c(i) = array<double, 1>(i + 1);
+  c(i)() = i;
+ }
+ auto d = c;
+ for (int i = 0; i < 5; ++i) EXPECT_ARRAY_NEAR(d(i), c(i));
+
+ // complex are zero initialized, as with new[]
+ array<dcomplex, 1> z(100);
+ for (int i = 0; i < 100; ++i) EXPECT_EQ(z(i), dcomplex(0));
+}
+
+TEST(Allocators, Threads) {
+ // blocks allocated in a thread and freed in another one
+ std::vector<array<double, 1>> v;
+ for (int i = 0; i < 100; ++i) v.emplace_back(100 + i);
+ std::thread t([&v]() {
+  v.clear();
+  for (int i = 0; i < 100; ++i) {
+   array<double, 1> a(100 + i);
+   a() = i;
+   EXPECT_EQ(a(99), i);
+  }
+ });
+ t.join();
+ for (int i = 0; i < 100; ++i) v.emplace_back(100 + i);
+ EXPECT_EQ(v.size(), 100);
+}
+
+TEST(Allocators, HugePages) {
+ allocators::pooled::enable_huge_pages(true);
+ EXPECT_TRUE(allocators::pooled::huge_pages_enabled());
+ size_t n = allocators::pooled::huge_page_min_size / sizeof(double) + 1;
+ auto p = static_cast<double*>(allocators::pooled::allocate(n * sizeof(double)));
+ EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(p) % allocators::pooled::huge_page_size == 0);
+ p[0] = 1;
+ p[n - 1] = 2;
+ EXPECT_EQ(p[n - 1], 2);
+ allocators::pooled::deallocate(p, n * sizeof(double));
+ allocators::pooled::enable_huge_pages(false);
+}
+
+MAKE_MAIN;
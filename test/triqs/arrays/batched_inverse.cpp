@@ -0,0 +1,92 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "start.hpp"
+
+// A batch of invertible matrices, which need pivoting (small diagonal elements)
+template <typename T> array<T, 3> make_batch(int n_mat, int n, memory_layout<3> ml = memory_layout<3>{}) {
+ array<T, 3> a(n_mat, n, n, ml);
+ for (int i = 0; i < n_mat; ++i)
+  for (int j = 0; j < n; ++j)
+   for (int k = 0; k < n; ++k)
+    a(i, j, k) = 1 / (1.0 + i + j + 2 * k) + 0.01 * (j == k) + T(0.3 * ((j * 7 + k * 3 + i) % 5));
+ return a;
+}
+
+// Inversion one matrix at a time, with lapack
+template <typename A> array<typename A::value_type, 3> reference_inverse(A const &a) {
+ array<typename A::value_type, 3> r = a;
+ for (size_t i = 0; i < first_dim(r); ++i) {
+  auto v = make_matrix_view(r(i, range(), range()));
+  v = inverse(v);
+ }
+ return r;
+}
+
+template <typename T> void check_all_sizes(memory_layout<3> ml) {
+ for (int n = 1; n <= 11; ++n) { // closed forms, Gauss-Jordan, lapack
+  auto a = make_batch<T>(30, n, ml);
+  auto r = reference_inverse(a);
+  batched_inverse_in_place(a);
+  EXPECT_ARRAY_NEAR(a, r, 1.e-9) << " n = " << n;
+ }
+}
+
+TEST(BatchedInverse, Double) { check_all_sizes<double>(memory_layout<3>{}); }
+TEST(BatchedInverse, Complex) { check_all_sizes<dcomplex>(memory_layout<3>{}); }
+TEST(BatchedInverse, Fortran) { check_all_sizes<dcomplex>(FORTRAN_LAYOUT); }
+
+TEST(BatchedInverse, Views) {
+ // strided batch and matrices : contiguous matrices or fallback
+ array<dcomplex, 3> a = make_batch<dcomplex>(20, 6);
+ auto r = reference_inverse(a(range(0, 20, 2), range(), range()));
+ batched_inverse_in_place(a(range(0, 20, 2), range(), range()));
+ EXPECT_ARRAY_NEAR(a(range(0, 20, 2), range(), range()), r, 1.e-9);
+
+ array<dcomplex, 3> b = make_batch<dcomplex>(20, 6);
+ auto r2 = reference_inverse(b(range(), range(0, 3), range(0, 3)));
+ batched_inverse_in_place(b(range(), range(0, 3), range(0, 3)));
+ EXPECT_ARRAY_NEAR(b(range(), range(0, 3), range(0, 3)), r2, 1.e-9);
+}
+
+TEST(BatchedInverse, Singular) {
+ for (int n : {2, 4, 6, 10}) {
+  auto a = make_batch<double>(10, n);
+  a(7, 1, range()) = 0;
+  try {
+   batched_inverse_in_place(a);
+   ADD_FAILURE() << "no exception for n = " << n;
+  } catch (triqs::runtime_error const &e) {
+   EXPECT_TRUE(std::string(e.what()).find("matrix 7 ") != std::string::npos) << e.what();
+  }
+ }
+ array<double, 3> ns(3, 2, 3);
+ EXPECT_THROW(batched_inverse_in_place(ns), triqs::runtime_error);
+}
+
+// min_size = 1 forces the parallel split (without OpenMP : serial)
+TEST(BatchedInverse, Parallel) {
+ auto a = make_batch<dcomplex>(101, 3);
+ auto r = reference_inverse(a);
+ batched_inverse_in_place(a, parallel_policy(1));
+ EXPECT_ARRAY_NEAR(a, r, 1.e-9);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "start.hpp"
+
+placeholder<0> i_;
+placeholder<1> j_;
+placeholder<2> k_;
+
+// The assignments of contiguous arrays with the same layout are done with a flat loop,
+// the others with foreach. Both must give the same result.
+TEST(Array, FlatAssignment) {
+ array<double, 3> A(4, 3, 5), B(4, 3, 5), Bf(4, 3, 5, FORTRAN_LAYOUT);
+ A(i_, j_, k_) << i_ + 10 * j_ - k_;
+ B(i_, j_, k_) << 2 * i_ - j_ * k_;
+ Bf = B;
+ array<dcomplex, 3> G(4, 3, 5), R(4, 3, 5);
+
+ // flat
+ G = 2 * A + B;
+ G += dcomplex(0, 1) * A / 2.0 - B;
+ G -= -A;
+ G *= 3;
+ R(i_, j_, k_) << 3 * (2 * A(i_, j_, k_) + B(i_, j_, k_) + dcomplex(0, 1) * A(i_, j_, k_) / 2.0 - B(i_, j_, k_) + A(i_, j_, k_));
+ EXPECT_ARRAY_NEAR(G, R);
+
+ // same expression with a different layout in the RHS : foreach
+ array<dcomplex, 3> G2(4, 3, 5);
+ G2 = 2 * A + Bf;
+ G2 += dcomplex(0, 1) * A / 2.0 - Bf;
+ G2 -= -A;
+ G2 *= 3;
+ EXPECT_ARRAY_NEAR(G2, R);
+
+ // views : the contiguous ones are flat, the others not
+ G2() = 0;
+ G2(range(), range(), range()) += 2 * A(range(), range(), range()) + Bf;
+ G2(1, range(), range()) -= B(0, range(), range());
+ R() = 2 * A + B;
+ for (int j = 0; j < 3; ++j)
+  for (int k = 0; k < 5; ++k) R(1, j, k) -= B(0, j, k);
+ EXPECT_ARRAY_NEAR(G2, R);
+
+ // aliasing
+ array<double, 3> C = A;
+ C = C + 2 * C;
+ EXPECT_ARRAY_NEAR(C, 3 * A);
+ C -= C;
+ EXPECT_ARRAY_NEAR(C, 0 * A);
+}
+
+// The typical update of the data of a gf : flat loop vs foreach
+TEST(Array, FlatAssignmentGfUpdate) {
+ int n_iw = 100, n = 4;
+ array<dcomplex, 3> G(n_iw, n, n), G0(n_iw, n, n), S(n_iw, n, n), G_ref(n_iw, n, n);
+ G0(i_, j_, k_) << 1 / (dcomplex(0, 1) * (2 * i_ + 1) - j_ * k_);
+ S(i_, j_, k_) << 0.1 * j_ - dcomplex(0, 0.01) * k_;
+ G() = 0;
+ G_ref() = 0;
+ for (int r = 0; r < 2; ++r) foreach(G_ref, [&](long i, long j, long k) { G_ref(i, j, k) += 0.5 * G0(i, j, k) - S(i, j, k); });
+ for (int r = 0; r < 2; ++r) G += 0.5 * G0 - S;
+ EXPECT_ARRAY_NEAR(G, G_ref);
+}
+
+MAKE_MAIN;
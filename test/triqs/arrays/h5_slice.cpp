@@ -0,0 +1,114 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+using namespace triqs::arrays;
+namespace h5 = triqs::h5;
+
+class H5Slice : public ::testing::Test {
+ protected:
+ array<dcomplex, 3> G;
+ array<double, 2> D;
+
+ void SetUp() override {
+  G = array<dcomplex, 3>(50, 3, 4);
+  for (int w = 0; w < 50; ++w)
+   for (int a = 0; a < 3; ++a)
+    for (int b = 0; b < 4; ++b) G(w, a, b) = dcomplex(w + 0.1 * a, b);
+  D = array<double, 2>(7, 9);
+  for (int i = 0; i < 7; ++i)
+   for (int j = 0; j < 9; ++j) D(i, j) = 10 * i + j;
+  h5::file file("h5_slice.h5", 'w');
+  h5::group top(file);
+  h5_write(top, "G", G);
+  h5_write(top, "D", D);
+  h5_write(top.with_storage(h5::compressed_storage(4, 1024)), "Gz", G);
+ }
+};
+
+TEST_F(H5Slice, Ranges) {
+ h5::file file("h5_slice.h5", 'r');
+ h5::group top(file);
+
+ // a window in the first dimension
+ array<dcomplex, 3> A;
+ h5_read_slice(top, "G", A, range(10, 20), range(), range());
+ EXPECT_ARRAY_NEAR(A, G(range(10, 20), range(), range()));
+
+ // with steps
+ h5_read_slice(top, "G", A, range(1, 50, 7), range(0, 3, 2), range(1, 4));
+ EXPECT_ARRAY_NEAR(A, G(range(1, 50, 7), range(0, 3, 2), range(1, 4)));
+
+ // from a chunked, compressed dataset
+ h5_read_slice(top, "Gz", A, range(33, 45), range(), range(2, 4));
+ EXPECT_ARRAY_NEAR(A, G(range(33, 45), range(), range(2, 4)));
+
+ array<double, 2> B;
+ h5_read_slice(top, "D", B, range(2, 5), range(3, 9, 3));
+ EXPECT_ARRAY_NEAR(B, D(range(2, 5), range(3, 9, 3)));
+}
+
+TEST_F(H5Slice, Indices) {
+ h5::file file("h5_slice.h5", 'r');
+ h5::group top(file);
+
+ // an integer drops the dimension
+ matrix<dcomplex> M;
+ h5_read_slice(top, "G", M, 17, range(), range());
+ EXPECT_ARRAY_NEAR(M, G(17, range(), range()));
+
+ array<dcomplex, 1> w;
+ h5_read_slice(top, "G", w, range(), 2, 1);
+ EXPECT_ARRAY_NEAR(w, G(range(), 2, 1));
+
+ // real data in the file, read into a complex array
+ array<dcomplex, 1> c;
+ h5_read_slice(top, "D", c, 3, range());
+ EXPECT_ARRAY_NEAR(c, D(3, range()));
+}
+
+TEST_F(H5Slice, IntoView) {
+ h5::file file("h5_slice.h5", 'r');
+ h5::group top(file);
+
+ // directly into a view of a larger array, in Fortran order
+ array<dcomplex, 3> big(20, 3, 4, FORTRAN_LAYOUT);
+ big() = 0;
+ h5_read_slice(top, "G", big(range(5, 15), range(), range()), range(30, 40), range(), range());
+ EXPECT_ARRAY_NEAR(big(range(5, 15), range(), range()), G(range(30, 40), range(), range()));
+ EXPECT_ARRAY_NEAR(big(range(0, 5), range(), range()), array<dcomplex, 3>(5, 3, 4, FORTRAN_LAYOUT) * 0);
+
+ // the view must have the size of the slice
+ EXPECT_THROW(h5_read_slice(top, "G", big(range(0, 5), range(), range()), range(30, 40), range(), range()), triqs::runtime_error);
+}
+
+TEST_F(H5Slice, Errors) {
+ h5::file file("h5_slice.h5", 'r');
+ h5::group top(file);
+ array<dcomplex, 3> A;
+ EXPECT_THROW(h5_read_slice(top, "G", A, range(40, 60), range(), range()), triqs::runtime_error);
+ EXPECT_THROW(h5_read_slice(top, "G", A, range(), range(), range(-1, 2)), triqs::runtime_error);
+ matrix<dcomplex> M;
+ EXPECT_THROW(h5_read_slice(top, "G", M, 50, range(), range()), triqs::runtime_error);
+ EXPECT_THROW(h5_read_slice(top, "G", M, range(), range()), triqs::runtime_error); // rank mismatch
+}
+
+MAKE_MAIN;
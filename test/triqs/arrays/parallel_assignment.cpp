@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "start.hpp"
+#include <thread>
+
+placeholder<0> i_;
+placeholder<1> j_;
+placeholder<2> k_;
+
+// Without OpenMP, the policy is ignored : the test then only checks the serial code.
+// min_size = 1 forces the parallel code even for small arrays
+TEST(Array, ParallelAssignment) {
+ array<dcomplex, 3> A(7, 3, 5), B(7, 3, 5), Bf(7, 3, 5, FORTRAN_LAYOUT), R(7, 3, 5), R2(7, 3, 5);
+ A(i_, j_, k_) << i_ + 10 * j_ - k_;
+ B(i_, j_, k_) << 2 * i_ - dcomplex(0, 1) * j_ * k_;
+ Bf = B;
+ R(i_, j_, k_) << 2 * A(i_, j_, k_) + B(i_, j_, k_) * A(i_, j_, k_);
+ R2(i_, j_, k_) << 3 * (2 * A(i_, j_, k_) + B(i_, j_, k_)) - 1;
+
+ execution_policy_guard guard(parallel_policy(1));
+
+ array<dcomplex, 3> C(7, 3, 5), Cf(7, 3, 5, FORTRAN_LAYOUT);
+ // flat
+ C = 2 * A + B * A;
+ EXPECT_ARRAY_NEAR(C, R);
+ // foreach : different layouts
+ Cf = 2 * A + Bf * A;
+ EXPECT_ARRAY_NEAR(Cf, R);
+ Cf() = 0;
+ Cf += 2 * A + B;
+ Cf *= 3;
+ Cf -= 1;
+ EXPECT_ARRAY_NEAR(Cf, R2);
+ // non contiguous view
+ C() = 0;
+ C(range(), 1, range()) = 2 * A(range(), 1, range()) + Bf(range(), 1, range()) * A(range(), 1, range());
+ EXPECT_ARRAY_NEAR(C(range(), 1, range()), R(range(), 1, range()));
+ // clef
+ C(i_, j_, k_) << 2 * A(i_, j_, k_) + B(i_, j_, k_) * A(i_, j_, k_);
+ EXPECT_ARRAY_NEAR(C, R);
+ // map
+ auto sq = map([](dcomplex x) { return x * x; });
+ C = sq(Bf);
+ EXPECT_ARRAY_NEAR(C, B * B);
+
+ // foreach with an explicit policy, with an outer dimension smaller than the number of threads
+ array<long, 2> D(2, 1000), Df(2, 1000, FORTRAN_LAYOUT);
+ foreach(D, [&D](long i, long j) { D(i, j) = i * 1000 + j; }, parallel_policy(1));
+ foreach(Df, [&Df](long i, long j) { Df(i, j) = i * 1000 + j; }, parallel_policy(1));
+ for (int i = 0; i < 2; ++i)
+  for (int j = 0; j < 1000; ++j) {
+   EXPECT_EQ(D(i, j), i * 1000 + j);
+   EXPECT_EQ(Df(i, j), i * 1000 + j);
+  }
+}
+
+// The policy is restored by the guard. Below min_size, the operation is serial.
+TEST(Array, ExecutionPolicy) {
+ EXPECT_EQ(get_execution_policy().n_threads, 1);
+ {
+  execution_policy_guard guard(parallel_policy(100));
+  EXPECT_EQ(get_execution_policy().n_threads, 0);
+  EXPECT_EQ(n_threads_for(get_execution_policy(), 99), 1);
+ }
+ EXPECT_EQ(get_execution_policy().n_threads, 1);
+ EXPECT_EQ(n_threads_for(get_execution_policy(), 1000000), 1);
+}
+
+// The policy is per thread : another thread keeps the default serial policy
+TEST(Array, ExecutionPolicyPerThread) {
+ execution_policy_guard guard(parallel_policy(100));
+ int n_threads_other = -1;
+ std::thread([&n_threads_other]() { n_threads_other = get_execution_policy().n_threads; }).join();
+ EXPECT_EQ(n_threads_other, 1);
+ EXPECT_EQ(get_execution_policy().n_threads, 0);
+}
+
+// Dyson-like update on arrays above the default min_size, serial vs parallel
+TEST(Array, ParallelAssignmentDyson) {
+ int n_iw = 4000, n = 4;
+ array<dcomplex, 3> G(n_iw, n, n), G0(n_iw, n, n), S(n_iw, n, n), G_ref(n_iw, n, n);
+ G0(i_, j_, k_) << 1 / (dcomplex(0, 1) * (2 * i_ + 1) - j_ * k_);
+ S(i_, j_, k_) << 0.1 * j_ - dcomplex(0, 0.01) * k_;
+ G_ref = G0 + G0 * S * G0;
+ {
+  execution_policy_guard guard(parallel_policy());
+  G = G0 + G0 * S * G0;
+ }
+ EXPECT_ARRAY_NEAR(G, G_ref);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,70 @@
+#include "./det_manip_test_tools.hpp"
+
+// Run the same random sequence of moves with and without delayed updates
+void run_and_compare(int k) {
+ det_manip<fun> D1(fun{}, 10), D2(fun{}, 10);
+ D2.set_n_delayed_updates(k);
+ triqs::mc_tools::random_generator RNG("mt19937", 23432);
+
+ for (int n = 0; n < 400; ++n) {
+  size_t s = D1.size();
+  double r1 = 1, r2 = 1;
+  int move = RNG(n > 20 ? 6 : 1);
+  if ((move == 1 || move == 4 || move == 5) && s == 0) continue;
+  if (move == 3 && s < 2) continue;
+  double x = RNG(10.0), y = RNG(10.0), x1 = RNG(10.0), y1 = RNG(10.0);
+  size_t i = RNG(s + 1), j = RNG(s + 1), i1 = RNG(s + 2), j1 = RNG(s + 2);
+  switch (move) {
+   case 0:
+    r1 = D1.try_insert(i, j, x, y);
+    r2 = D2.try_insert(i, j, x, y);
+    break;
+   case 1:
+    i = RNG(s), j = RNG(s);
+    r1 = D1.try_remove(i, j);
+    r2 = D2.try_remove(i, j);
+    break;
+   case 2:
+    if (i == i1 || j == j1) continue;
+    r1 = D1.try_insert2(i, i1, j, j1, x, x1, y, y1);
+    r2 = D2.try_insert2(i, i1, j, j1, x, x1, y, y1);
+    break;
+   case 3:
+    i = RNG(s), j = RNG(s), i1 = RNG(s), j1 = RNG(s);
+    if (i == i1 || j == j1) continue;
+    r1 = D1.try_remove2(i, i1, j, j1);
+    r2 = D2.try_remove2(i, i1, j, j1);
+    break;
+   case 4:
+    j = RNG(s);
+    r1 = D1.try_change_col(j, y);
+    r2 = D2.try_change_col(j, y);
+    break;
+   case 5:
+    i = RNG(s);
+    r1 = D1.try_change_row(i, x);
+    r2 = D2.try_change_row(i, x);
+    break;
+  }
+  EXPECT_NEAR(r1, r2, 1.e-8 * std::abs(r1));
+  // accept half of the moves
+  if (RNG(2) == 0) continue;
+  D1.complete_operation();
+  D2.complete_operation();
+  if (D1.size() == 0) continue;
+  EXPECT_NEAR(D1.determinant(), D2.determinant(), 1.e-8 * std::abs(D1.determinant()));
+  auto M1 = D1.inverse_matrix();
+  EXPECT_ARRAY_NEAR(M1, D2.inverse_matrix(), 1.e-9 * max_element(abs(M1)));
+ }
+ // the pending updates are not lost by the flush
+ D2.flush_delayed_updates();
+ auto M1 = D1.inverse_matrix();
+ EXPECT_ARRAY_NEAR(M1, D2.inverse_matrix(), 1.e-9 * max_element(abs(M1)));
+}
+
+TEST(det_manip, delayed_1) { run_and_compare(1); }
+TEST(det_manip, delayed_2) { run_and_compare(2); }
+TEST(det_manip, delayed_5) { run_and_compare(5); }
+TEST(det_manip, delayed_16) { run_and_compare(16); }
+
+MAKE_MAIN;
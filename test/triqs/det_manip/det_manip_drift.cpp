@@ -0,0 +1,39 @@
+#include "./det_manip_test_tools.hpp"
+
+// A Metropolis walk with a periodic check every 10 moves
+det_manip<fun> run(int n_probes, double threshold) {
+ det_manip<fun> D(fun{}, 10);
+ D.set_n_drift_probes(n_probes);
+ D.set_drift_threshold(threshold);
+ D.set_n_operations_before_check(10);
+ metropolis_walk walk;
+ walk.min_size = 10;
+ walk.max_size = 30;
+ walk.change_col = true;
+ walk(D, 1000);
+ check_inverse(D);
+ EXPECT_GT(D.get_drift_statistics().n_checks, 10u);
+ return D;
+}
+
+TEST(det_manip, drift_full_check) {
+ auto D = run(0, 1.e-8);
+ auto const &st = D.get_drift_statistics();
+ EXPECT_EQ(st.n_regenerations, st.n_checks);
+}
+
+TEST(det_manip, drift_probes) {
+ auto D = run(2, 1.e-8);
+ auto const &st = D.get_drift_statistics();
+ EXPECT_EQ(st.n_regenerations, 0u);
+ EXPECT_GT(st.max_drift, 0);
+ EXPECT_LT(st.max_drift, 1.e-8);
+}
+
+TEST(det_manip, drift_probes_threshold) {
+ auto D = run(3, 0); // any rounding error triggers the regeneration
+ auto const &st = D.get_drift_statistics();
+ EXPECT_EQ(st.n_regenerations, st.n_checks);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,63 @@
+#include "./det_manip_test_tools.hpp"
+
+// k distinct random positions in [0, n)
+std::vector<size_t> positions(triqs::mc_tools::random_generator &RNG, size_t k, size_t n) {
+ std::vector<size_t> r;
+ while (r.size() < k) {
+  size_t p = RNG(n);
+  if (std::find(r.begin(), r.end(), p) == r.end()) r.push_back(p);
+ }
+ return r;
+}
+
+// Random insert_k/remove_k moves, checked against the direct computation of the det and inverse
+void run(int n_delayed) {
+ det_manip<fun> D(fun{}, 4);
+ D.set_n_delayed_updates(n_delayed);
+ triqs::mc_tools::random_generator RNG("mt19937", 23432);
+
+ for (int n = 0; n < 300; ++n) {
+  size_t s = D.size(), k = 1 + RNG(6);
+  double r = 0;
+  bool insert = (s < k || s < 12 || (s < 30 && RNG(2) == 0));
+  if (insert) {
+   std::vector<double> x(k), y(k);
+   for (auto &u : x) u = RNG(10.0);
+   for (auto &u : y) u = RNG(10.0);
+   r = D.try_insert_k(positions(RNG, k, s + k), positions(RNG, k, s + k), x, y);
+  } else
+   r = D.try_remove_k(positions(RNG, k, s), positions(RNG, k, s));
+
+  // Metropolis, to keep the matrix well conditioned
+  if (RNG(1.0) > std::abs(r)) continue;
+  double det_old = D.determinant();
+  D.complete_operation();
+  if (D.size() == 0) continue;
+  auto M = D.matrix();
+  double det = triqs::arrays::determinant(M);
+  EXPECT_NEAR(det, D.determinant(), 1.e-8 * std::abs(det));
+  EXPECT_NEAR(r, D.determinant() / det_old, 1.e-8 * std::abs(r));
+  check_inverse(D);
+ }
+}
+
+TEST(det_manip, insert_remove_k) { run(0); }
+TEST(det_manip, insert_remove_k_delayed) { run(4); } // some of the moves are larger than the delay queue
+
+// insert_k with k=2 is insert2
+TEST(det_manip, insert_k_vs_insert2) {
+ det_manip<fun> D1(fun{}, 10), D2(fun{}, 10);
+ for (int i = 0; i < 5; ++i) {
+  D1.insert_at_end(0.1 * i, 0.3 * i + 0.05);
+  D2.insert_at_end(0.1 * i, 0.3 * i + 0.05);
+ }
+ auto r1 = D1.try_insert2(1, 4, 3, 0, 0.7, 0.2, 0.9, 0.4);
+ auto r2 = D2.try_insert_k(std::vector<size_t>{4, 1}, std::vector<size_t>{3, 0}, std::vector<double>{0.2, 0.7}, std::vector<double>{0.9, 0.4});
+ EXPECT_NEAR(r1, r2, 1.e-10 * std::abs(r1));
+ D1.complete_operation();
+ D2.complete_operation();
+ EXPECT_ARRAY_NEAR(D1.matrix(), D2.matrix(), 1.e-14);
+ EXPECT_ARRAY_NEAR(D1.inverse_matrix(), D2.inverse_matrix(), 1.e-10);
+}
+
+MAKE_MAIN;
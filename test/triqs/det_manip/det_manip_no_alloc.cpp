@@ -0,0 +1,44 @@
+#include "./det_manip_test_tools.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts all the allocations done with new, in every build.
+// Each array/matrix block is created with new mem_block, so this also counts the arrays allocations.
+std::atomic<size_t> n_new{0};
+size_t n_allocations() { return n_new; }
+
+void *operator new(std::size_t n) {
+ ++n_new;
+ if (void *p = std::malloc(n ? n : 1)) return p;
+ throw std::bad_alloc{};
+}
+void *operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+// insert2/remove2 moves do not allocate any memory once the det_manip has been reserved.
+void run(int n_delayed) {
+ det_manip<fun> D(fun{}, 100);
+ D.set_n_delayed_updates(n_delayed);
+ D.set_n_operations_before_check(1000000); // the check regenerates the matrix, which allocates
+ metropolis_walk walk;
+ walk.pairs = true;
+ walk.max_size = 42;
+
+ auto n0 = n_allocations();
+ walk(D, 1000);
+ EXPECT_EQ(n0, n_allocations());
+
+ D.flush_delayed_updates();
+ if (D.size() > 0) {
+  check_inverse(D, 1.e-8);
+ }
+}
+
+TEST(det_manip, no_alloc) { run(0); }
+TEST(det_manip, no_alloc_delayed) { run(8); }
+
+MAKE_MAIN;
@@ -0,0 +1,52 @@
+#include "./det_manip_test_tools.hpp"
+
+// log|det| of the N x N matrix, computed with scale = 1.
+double log_abs_det_unscaled(det_manip<fun> const &D) {
+ det_manip<fun> D1(fun{1}, 10);
+ std::vector<double> x, y;
+ for (size_t i = 0; i < D.size(); ++i) {
+  x.push_back(D.get_x(i));
+  y.push_back(D.get_y(i));
+ }
+ D1.try_refill(x, y);
+ D1.complete_operation();
+ return std::log(std::abs(D1.determinant()));
+}
+
+// The det overflows (resp. underflows) a double, but the moves go on without any regeneration.
+void run(double scale) {
+ det_manip<fun> D(fun{scale}, 100);
+ D.set_n_operations_before_check(1000000);
+ metropolis_walk walk;
+ walk.ratio_scale = scale;
+ walk.min_size = 60;
+ while (D.size() < 60) walk.step(D);
+ walk.min_size = 0;
+ walk(D, 200);
+
+ EXPECT_TRUE(D.size() > 40);
+ EXPECT_TRUE(std::isinf(D.determinant()) || D.determinant() == 0);
+ EXPECT_NEAR(D.log_abs_determinant(), log_abs_det_unscaled(D) + D.size() * std::log(scale), 1.e-8 * D.size());
+ EXPECT_NEAR(std::abs(D.determinant_phase()), 1, 1.e-14);
+ // the inverse is still accurate
+ check_inverse(D);
+
+ // change_one_row_and_one_col keeps the scaled det
+ for (int n = 0; n < 100; ++n) {
+  size_t s = D.size();
+  D.change_one_row_and_one_col(walk.RNG(s), walk.RNG(s), walk.RNG(10.0), walk.RNG(10.0));
+ }
+ EXPECT_NEAR(D.log_abs_determinant(), log_abs_det_unscaled(D) + D.size() * std::log(scale), 1.e-8 * D.size());
+
+ // regeneration keeps the scaled det
+ double l = D.log_abs_determinant();
+ auto p = D.determinant_phase();
+ D.regenerate();
+ EXPECT_NEAR(D.log_abs_determinant(), l, 1.e-8 * D.size());
+ EXPECT_EQ(D.determinant_phase(), p);
+}
+
+TEST(det_manip, scaled_det_overflow) { run(1.e10); }
+TEST(det_manip, scaled_det_underflow) { run(1.e-10); }
+
+MAKE_MAIN;
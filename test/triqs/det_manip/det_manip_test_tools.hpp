@@ -0,0 +1,67 @@
+#pragma once
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/det_manip/det_manip.hpp>
+#include <triqs/mc_tools/random_generator.hpp>
+#include <triqs/arrays/algorithms.hpp>
+
+using triqs::det_manip::det_manip;
+
+// a pseudo random, well conditioned matrix, times a scale
+struct fun {
+ double scale = 1;
+ double operator()(double x, double y) const { return scale * std::sin(13 * x * y + 3 * x - y); }
+};
+
+// The inverse kept by D is the inverse of its matrix
+template <typename DetManip> void check_inverse(DetManip const &D, double precision = 1.e-9) {
+ auto Minv = triqs::arrays::matrix<double>(inverse(D.matrix()));
+ EXPECT_ARRAY_NEAR(Minv, D.inverse_matrix(), precision * max_element(abs(Minv)));
+}
+
+// A Metropolis walk of random insert/remove moves on a det_manip.
+// Below min_size, only insertions are proposed; there is no insertion above max_size.
+// The ratio of an insertion is divided by ratio_scale and the one of a removal multiplied by it,
+// so that the size of the matrix stays stable when fun is rescaled.
+struct metropolis_walk {
+ triqs::mc_tools::random_generator RNG{"mt19937", 2134};
+ size_t min_size = 0, max_size = 1000;
+ double ratio_scale = 1;
+ bool pairs = false;      // insert2/remove2 instead of insert/remove
+ bool change_col = false; // also propose try_change_col
+
+ // One move. Returns true iif it is accepted
+ template <typename DetManip> bool step(DetManip &D) {
+  size_t s = D.size();
+  int move = (s < min_size || s < (pairs ? 2 : 1)) ? 0 : RNG(change_col ? 3 : 2);
+  double r = 0;
+  switch (move) {
+   case 0: {
+    if (s + (pairs ? 2 : 1) > max_size) return false;
+    if (!pairs) {
+     r = D.try_insert(RNG(s + 1), RNG(s + 1), RNG(10.0), RNG(10.0)) / ratio_scale;
+     break;
+    }
+    size_t i0 = RNG(s + 1), i1 = RNG(s + 2), j0 = RNG(s + 1), j1 = RNG(s + 2);
+    if ((i0 == i1) || (j0 == j1)) return false;
+    r = D.try_insert2(i0, i1, j0, j1, RNG(10.0), RNG(10.0), RNG(10.0), RNG(10.0)) / (ratio_scale * ratio_scale);
+   } break;
+   case 1: {
+    if (!pairs) {
+     r = D.try_remove(RNG(s), RNG(s)) * ratio_scale;
+     break;
+    }
+    size_t i0 = RNG(s), i1 = RNG(s), j0 = RNG(s), j1 = RNG(s);
+    if ((i0 == i1) || (j0 == j1)) return false;
+    r = D.try_remove2(i0, i1, j0, j1) * ratio_scale * ratio_scale;
+   } break;
+   case 2: r = D.try_change_col(RNG(s), RNG(10.0)); break;
+  }
+  if (RNG(1.0) >= std::abs(r)) return false;
+  D.complete_operation();
+  return true;
+ }
+
+ template <typename DetManip> void operator()(DetManip &D, int n_moves) {
+  for (int n = 0; n < n_moves; ++n) step(D);
+ }
+};
@@ -0,0 +1,71 @@
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs.hpp>
+#include <triqs/gfs/transform/fftw_plan_cache.hpp>
+#include <cstdio>
+using namespace triqs::gfs;
+using namespace triqs::arrays;
+
+// G(tau) for one level at energy a
+gf<imtime> make_gt(double beta, int n_tau) {
+ double a = 1;
+ auto gt = gf<imtime>{{beta, Fermion, n_tau}, {2, 2}};
+ for (auto const &t : gt.mesh()) gt[t] = -exp(-a * t) / (1 + exp(-beta * a));
+ gt.singularity()(1) = 1;
+ return gt;
+}
+
+TEST(FFTW, PlanCache) {
+ double beta = 10;
+ auto gt = make_gt(beta, 801);
+ auto gw = gf<imfreq>{{beta, Fermion, 200}, {2, 2}};
+
+ fftw_clear_plan_cache();
+ gw() = fourier(gt);
+ auto gw_estimate = gw;
+ // one plan for the direct transformation, reused by the next calls
+ EXPECT_EQ(fftw_plan_cache_size(), 1);
+ gw() = fourier(gt);
+ EXPECT_EQ(fftw_plan_cache_size(), 1);
+ EXPECT_GF_NEAR(gw, gw_estimate);
+
+ // the inverse transform has another plan
+ auto gt2 = gt;
+ gt2() = inverse_fourier(gw);
+ EXPECT_EQ(fftw_plan_cache_size(), 2);
+
+ // a measured plan gives the same result
+ set_fftw_planning(fftw_planning::measure);
+ EXPECT_EQ(fftw_plan_cache_size(), 0);
+ gw() = fourier(gt);
+ EXPECT_GF_NEAR(gw, gw_estimate);
+ set_fftw_planning(fftw_planning::estimate);
+}
+
+TEST(FFTW, PlanCacheMaxSize) {
+ double beta = 10;
+ auto gt = make_gt(beta, 801);
+ auto gw = gf<imfreq>{{beta, Fermion, 200}, {2, 2}};
+
+ fftw_clear_plan_cache();
+ gw() = fourier(gt);
+ auto gw_ref = gw;
+ set_fftw_plan_cache_max_size(1);
+ EXPECT_EQ(fftw_plan_cache_size(), 1);
+ // the plan of the direct transform is evicted by the plan of the inverse one, and made again
+ gt() = inverse_fourier(gw);
+ EXPECT_EQ(fftw_plan_cache_size(), 1);
+ gw() = fourier(gt);
+ EXPECT_EQ(fftw_plan_cache_size(), 1);
+ EXPECT_GF_NEAR(gw, gw_ref);
+ set_fftw_plan_cache_max_size(64);
+ EXPECT_THROW(set_fftw_plan_cache_max_size(0), triqs::runtime_error);
+}
+
+TEST(FFTW, Wisdom) {
+ std::remove("fftw_wisdom_test.dat");
+ EXPECT_FALSE(fftw_import_wisdom("fftw_wisdom_test.dat"));
+ fftw_export_wisdom("fftw_wisdom_test.dat");
+ EXPECT_TRUE(fftw_import_wisdom("fftw_wisdom_test.dat"));
+}
+
+MAKE_MAIN;
@@ -99,5 +99,41 @@ TEST(Gf, FitTail3) {
  triqs::arrays::array<dcomplex, 1> c{0.0, 0.0, 1.0, 1.0, 0.999251, 0.998655};
  EXPECT_ARRAY_NEAR(c, gw.singularity().data()(range(0, 6), 0, 0), 1.e-6);
 }
+
+// ------------------------------------------------------------------------------
+
+TEST(Gf, FitTailMatrix) {
+
+ // all the elements are fitted at once : same result as the fit of each element alone
+ double beta = 10;
+ int N = 200;
+ matrix<double> H(2, 2);
+ H(0, 0) = 1;
+ H(0, 1) = H(1, 0) = 0.5;
+ H(1, 1) = -0.3;
+
+ auto gw = gf<imfreq>{{beta, Fermion, N}, {2, 2}};
+ for (auto const &w : gw.mesh()) gw[w] = inverse(dcomplex(w) - H);
+ auto gw_c = gw;
+
+ auto known_moments = tail(make_shape(2, 2), 1, 1);
+ known_moments(1) = 1.;
+ fit_tail(gw, known_moments, 4, 50, 90);
+ fit_tail(gw_c, known_moments, 4, -91, -51, 50, 90);
+
+ for (int i = 0; i < 2; i++)
+  for (int j = 0; j < 2; j++) {
+   auto g = gf<imfreq>{slice_target(gw, range(i, i + 1), range(j, j + 1))};
+   auto km = tail(make_shape(1, 1), 1, 1);
+   km(1) = (i == j ? 1 : 0);
+   fit_tail(g, km, 4, 50, 90);
+   EXPECT_ARRAY_NEAR(g.singularity().data()(range(0, 6), 0, 0), gw.singularity().data()(range(0, 6), i, j), 1.e-10);
+   fit_tail(g, km, 4, -91, -51, 50, 90);
+   EXPECT_ARRAY_NEAR(g.singularity().data()(range(0, 6), 0, 0), gw_c.singularity().data()(range(0, 6), i, j), 1.e-10);
+  }
+ // the second moment is H
+ EXPECT_ARRAY_NEAR(gw.singularity()(2), H, 1.e-6);
+ EXPECT_ARRAY_NEAR(gw_c.singularity()(2), H, 1.e-5);
+}
 MAKE_MAIN;
 
@@ -0,0 +1,52 @@
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs.hpp>
+using namespace triqs::gfs;
+using namespace triqs::arrays;
+
+// G(tau) of a 3x3 matrix of levels, with different energies and tails
+gf<imtime> make_gt(double beta, int n_tau, statistic_enum stat) {
+ auto gt = gf<imtime>{{beta, stat, n_tau}, {3, 3}};
+ double s = (stat == Fermion ? 1 : -1);
+ for (auto const &t : gt.mesh())
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 3; ++j) {
+    double a = 0.3 + i + 0.5 * j;
+    gt[t](i, j) = (i + 1) * (-exp(-a * t) / (1 + s * exp(-beta * a)));
+    gt.singularity()(1)(i, j) = i + 1;
+   }
+ return gt;
+}
+
+// The matrix transform (all elements at once) is the transform of each element
+void check(statistic_enum stat) {
+ double beta = 10;
+ auto gt = make_gt(beta, 1001, stat);
+ auto gw = gf<imfreq>{{beta, stat, 100}, {3, 3}};
+ gw() = fourier(gt);
+ auto gt2 = gt;
+ gt2() = inverse_fourier(gw);
+
+ for (int i = 0; i < 3; ++i)
+  for (int j = 0; j < 3; ++j) {
+   auto gw_s = gf<imfreq, scalar_valued>{gw.mesh()};
+   gw_s() = fourier(slice_target_to_scalar(gt, i, j));
+   EXPECT_ARRAY_NEAR(gw_s.data(), gw.data()(range(), i, j), 1.e-12);
+   auto gt_s = gf<imtime, scalar_valued>{gt.mesh()};
+   gt_s() = inverse_fourier(gw_s);
+   EXPECT_ARRAY_NEAR(gt_s.data(), gt2.data()(range(), i, j), 1.e-12);
+  }
+
+ // a slice of the target is not contiguous
+ auto gw_sl = gf<imfreq>{gw.mesh(), {2, 2}};
+ gw_sl() = fourier(slice_target(gt, range(1, 3), range(0, 2)));
+ EXPECT_ARRAY_NEAR(gw_sl.data(), gw.data()(range(), range(1, 3), range(0, 2)), 1.e-12);
+ auto gt_sl = gt2;
+ slice_target(gt_sl, range(1, 3), range(0, 2)).data() = 0;
+ slice_target(gt_sl, range(1, 3), range(0, 2))() = inverse_fourier(gw_sl);
+ EXPECT_ARRAY_NEAR(gt_sl.data(), gt2.data(), 1.e-12);
+}
+
+TEST(Fourier, MatrixFermion) { check(Fermion); }
+TEST(Fourier, MatrixBoson) { check(Boson); }
+
+MAKE_MAIN;
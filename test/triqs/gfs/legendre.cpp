@@ -0,0 +1,134 @@
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs.hpp>
+#include <triqs/utility/legendre.hpp>
+using namespace triqs::gfs;
+using namespace triqs::arrays;
+
+// Two levels at energies eps, G(tau) = -exp(-eps tau) / (1 + exp(-beta eps))
+double beta = 10;
+double eps[2] = {0.3, -1.2};
+
+// G_l = sqrt(2l+1) int_0^beta dtau P_l(2tau/beta - 1) G(tau), by Simpson
+array<dcomplex, 3> reference_gl(int n_l) {
+ array<dcomplex, 3> r(n_l, 2, 2);
+ r() = dcomplex(0);
+ int N = 20000;
+ triqs::utility::legendre_generator L;
+ for (int k = 0; k <= N; ++k) {
+  double tau = beta * k / N, w = (k == 0 || k == N ? 1 : (k % 2 == 1 ? 4 : 2)) * beta / N / 3;
+  L.reset(2 * tau / beta - 1);
+  for (int l = 0; l < n_l; ++l) {
+   double p = std::sqrt(2 * l + 1) * L.next() * w;
+   for (int a = 0; a < 2; ++a) r(l, a, a) += -p * std::exp(-eps[a] * tau) / (1 + std::exp(-beta * eps[a]));
+  }
+ }
+ return r;
+}
+
+gf<imfreq> make_gw(int n_iw) {
+ auto gw = gf<imfreq>{{beta, Fermion, n_iw}, {2, 2}};
+ gw.data()() = 0;
+ for (auto const &w : gw.mesh())
+  for (int a = 0; a < 2; ++a) gw[w](a, a) = 1 / (dcomplex(w) - eps[a]);
+ gw.singularity().data()() = 0;
+ for (int a = 0; a < 2; ++a) {
+  gw.singularity()(1)(a, a) = 1;
+  gw.singularity()(2)(a, a) = eps[a];
+  gw.singularity()(3)(a, a) = eps[a] * eps[a];
+ }
+ return gw;
+}
+
+TEST(Legendre, ImfreqToLegendre) {
+ int n_l = 30;
+ auto gl = gf<legendre>{{beta, Fermion, size_t(n_l)}, {2, 2}};
+ gl() = imfreq_to_legendre(make_gw(1000));
+ EXPECT_ARRAY_NEAR(gl.data(), reference_gl(n_l), 1.e-7);
+
+ // back to Matsubara
+ auto gw = make_gw(100);
+ auto gw2 = gw;
+ gw2() = legendre_to_imfreq(gl);
+ EXPECT_ARRAY_NEAR(gw2.data(), gw.data(), 1.e-6);
+}
+
+TEST(Legendre, ImtimeToLegendre) {
+ int n_l = 40;
+ auto gt = gf<imtime>{{beta, Fermion, 10001}, {2, 2}};
+ gt.data()() = 0;
+ for (auto const &t : gt.mesh())
+  for (int a = 0; a < 2; ++a) gt[t](a, a) = -std::exp(-eps[a] * t) / (1 + std::exp(-beta * eps[a]));
+ auto gl = gf<legendre>{{beta, Fermion, size_t(n_l)}, {2, 2}};
+ gl() = imtime_to_legendre(gt);
+ // trapezoidal rule : the error grows like l^2 delta_tau^2
+ EXPECT_ARRAY_NEAR(gl.data(), reference_gl(n_l), 2.e-4);
+
+ auto gt2 = gt;
+ gt2() = legendre_to_imtime(gl);
+ EXPECT_ARRAY_NEAR(gt2.data(), gt.data(), 2.e-3);
+}
+
+TEST(Legendre, TnlMatrix) {
+ auto T = details::legendre_T_matrix(-5, 7, 6);
+ for (int n = -5; n <= 7; ++n)
+  for (int l = 0; l < 6; ++l) EXPECT_CLOSE((*T)(n + 5, l), triqs::utility::legendre_T(n, l));
+ // computed once
+ EXPECT_EQ(T.get(), details::legendre_T_matrix(-5, 7, 6).get());
+
+ // Legendre -> imfreq, for a full matrix and a slice of its target, against the sum over T_nl
+ int n_l = 12;
+ auto gl = gf<legendre>{{beta, Fermion, size_t(n_l)}, {3, 3}};
+ for (int l = 0; l < n_l; ++l)
+  for (int a = 0; a < 3; ++a)
+   for (int b = 0; b < 3; ++b) gl.data()(l, a, b) = dcomplex(std::sin(l + 3 * a + b), std::cos(2 * l - a * b)) / (1 + l * l);
+ auto gw = gf<imfreq>{{beta, Fermion, 40}, {3, 3}};
+ gw() = legendre_to_imfreq(gl);
+ auto gw_sl = gf<imfreq>{{beta, Fermion, 40}, {3, 3}};
+ gw_sl.data()() = 0;
+ slice_target(gw_sl, range(1, 3), range(0, 2))() = legendre_to_imfreq(slice_target(gl, range(1, 3), range(0, 2)));
+ auto _ = range{};
+ for (auto const &om : gw.mesh()) {
+  matrix<dcomplex> r(3, 3);
+  r() = 0;
+  for (int l = 0; l < n_l; ++l) r += triqs::utility::legendre_T(om.index(), l) * matrix<dcomplex>(gl.data()(l, _, _));
+  array<dcomplex, 2> w = gw.data()(om.linear_index(), _, _), w_sl = gw_sl.data()(om.linear_index(), range(1, 3), range(0, 2));
+  EXPECT_ARRAY_NEAR(w, r, 1.e-12);
+  EXPECT_ARRAY_NEAR(w_sl, r(range(1, 3), range(0, 2)), 1.e-12);
+ }
+}
+
+TEST(Legendre, Basis) {
+ int n = 37, n_l = 50;
+ std::vector<double> x(n), p(n * n_l);
+ for (int k = 0; k < n; ++k) x[k] = -1 + 2.0 * k / (n - 1);
+ triqs::utility::legendre_basis(x.data(), n, n_l, p.data());
+ triqs::utility::legendre_generator L;
+ for (int k = 0; k < n; ++k) {
+  L.reset(x[k]);
+  for (int l = 0; l < n_l; ++l) EXPECT_NEAR(p[l * n + k], L.next(), 1.e-13);
+ }
+
+ // Legendre -> imtime, for a full matrix and a slice of its target, against the sum over the P_l
+ int n_l2 = 12;
+ auto gl = gf<legendre>{{beta, Fermion, size_t(n_l2)}, {3, 3}};
+ for (int l = 0; l < n_l2; ++l)
+  for (int a = 0; a < 3; ++a)
+   for (int b = 0; b < 3; ++b) gl.data()(l, a, b) = dcomplex(std::sin(l + 3 * a + b), std::cos(2 * l - a * b)) / (1 + l * l);
+ auto gt = gf<imtime>{{beta, Fermion, 601}, {3, 3}};
+ gt() = legendre_to_imtime(gl);
+ auto gt_sl = gf<imtime>{{beta, Fermion, 601}, {3, 3}};
+ gt_sl.data()() = 0;
+ slice_target(gt_sl, range(1, 3), range(0, 2))() = legendre_to_imtime(slice_target(gl, range(1, 3), range(0, 2)));
+ auto _ = range{};
+ for (auto const &t : gt.mesh()) {
+  matrix<dcomplex> r(3, 3);
+  r() = 0;
+  L.reset(2 * t / beta - 1);
+  for (int l = 0; l < n_l2; ++l) r += std::sqrt(2 * l + 1) / beta * L.next() * matrix<dcomplex>(gl.data()(l, _, _));
+  array<dcomplex, 2> v = gt.data()(t.index(), _, _), v_sl = gt_sl.data()(t.index(), range(1, 3), range(0, 2));
+  EXPECT_ARRAY_NEAR(v, r, 1.e-12);
+  EXPECT_ARRAY_NEAR(v_sl, r(range(1, 3), range(0, 2)), 1.e-12);
+ }
+}
+
+MAKE_MAIN;
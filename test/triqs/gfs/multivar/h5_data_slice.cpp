@@ -0,0 +1,45 @@
+#include <triqs/test_tools/gfs.hpp>
+using namespace triqs::clef;
+using namespace triqs::lattice;
+using triqs::clef::placeholder;
+
+// Read one k point, and a frequency window of one orbital, of a G(k, iw) stored in a file
+TEST(Gf, H5DataSlice) {
+
+ double beta = 1;
+ auto bz = brillouin_zone{bravais_lattice{{{1, 0}, {0, 1}}}};
+ int n_bz = 8, n_iw = 50;
+
+ auto G = gf<cartesian_product<brillouin_zone, imfreq>, matrix_valued, no_tail>{{{bz, n_bz}, {beta, Fermion, n_iw}}, {2, 2}};
+
+ placeholder<0> k_;
+ placeholder<1> w_;
+ placeholder<2> a_;
+ placeholder<3> b_;
+ G(k_, w_)(a_, b_) << 1 / (w_ + 2 * (cos(k_(0)) + cos(k_(1))) - a_ - 0.1 * b_);
+
+ {
+  h5::file file("g_k_om_slice.h5", 'w');
+  h5_write(h5::group(file), "G", G);
+ }
+
+ h5::file file("g_k_om_slice.h5", 'r');
+ h5::group top(file);
+
+ // G(k = 5, iw)
+ array<dcomplex, 3> gk;
+ h5_read_data_slice(top, "G", gk, 5, range(), range(), range());
+ EXPECT_ARRAY_NEAR(gk, G.data()(5, range(), range(), range()));
+
+ // a window of frequencies for all k, orbital (1,1)
+ array<dcomplex, 2> g11;
+ h5_read_data_slice(top, "G", g11, range(), range(40, 60), 1, 1);
+ EXPECT_ARRAY_NEAR(g11, G.data()(range(), range(40, 60), 1, 1));
+
+ // directly into the data of another gf
+ auto G2 = gf<cartesian_product<brillouin_zone, imfreq>, matrix_valued, no_tail>{{{bz, n_bz}, {beta, Fermion, n_iw}}, {2, 2}};
+ h5_read_data_slice(top, "G", G2.data()(range(0, 3), range(), range(), range()), range(0, 3), range(), range(), range());
+ EXPECT_ARRAY_NEAR(G2.data()(range(0, 3), range(), range(), range()), G.data()(range(0, 3), range(), range(), range()));
+}
+
+MAKE_MAIN;
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+#include <hdf5.h>
+using namespace triqs::arrays;
+namespace h5 = triqs::h5;
+
+// layout, chunk and number of filters of a dataset
+struct ds_info {
+ H5D_layout_t layout;
+ std::vector<hsize_t> chunk;
+ int n_filters;
+};
+
+ds_info get_info(h5::group g, std::string const &name) {
+ h5::dataset ds = g.open_dataset(name);
+ h5::proplist pl = H5Dget_create_plist(ds);
+ ds_info r{H5Pget_layout(pl), {}, H5Pget_nfilters(pl)};
+ if (r.layout == H5D_CHUNKED) {
+  r.chunk.resize(H5Sget_simple_extent_ndims(h5::dataspace{H5Dget_space(ds)}));
+  H5Pget_chunk(pl, r.chunk.size(), r.chunk.data());
+ }
+ return r;
+}
+
+hsize_t file_size(std::string const &name) {
+ h5::file f(name, 'r');
+ hsize_t s;
+ H5Fget_filesize(f, &s);
+ return s;
+}
+
+// A G(iw) like array : diagonal in the target space
+array<dcomplex, 3> make_g(int n_iw, int n) {
+ array<dcomplex, 3> g(n_iw, n, n);
+ g() = 0;
+ for (int w = 0; w < n_iw; ++w)
+  for (int a = 0; a < n; ++a) g(w, a, a) = 1 / (dcomplex(0, 2 * w + 1) - a);
+ return g;
+}
+
+TEST(H5Storage, ChunkShape) {
+ // the last dimensions are whole, the first one is cut
+ EXPECT_EQ(h5::chunk_shape({10000, 4, 4, 2}, 8, 1 << 14), (std::vector<hsize_t>{64, 4, 4, 2}));
+ EXPECT_EQ(h5::chunk_shape({10, 4, 4, 2}, 8, 1 << 14), (std::vector<hsize_t>{10, 4, 4, 2}));
+ EXPECT_EQ(h5::chunk_shape({100, 100, 100}, 8, 1 << 14), (std::vector<hsize_t>{1, 20, 100}));
+ EXPECT_EQ(h5::chunk_shape({100000}, 8, 100), (std::vector<hsize_t>{12}));
+ EXPECT_EQ(h5::chunk_shape({5, 100000}, 8, 8), (std::vector<hsize_t>{1, 1}));
+}
+
+TEST(H5Storage, WriteRead) {
+ auto g = make_g(20000, 4);
+ array<double, 2> d(300, 50);
+ for (int i = 0; i < 300; ++i)
+  for (int j = 0; j < 50; ++j) d(i, j) = i + 0.1 * j;
+ array<long, 1> small(10);
+ small() = 3;
+
+ {
+  h5::file file("h5_storage.h5", 'w');
+  h5::group top(file);
+  h5_write(top, "g_contiguous", g);
+  h5_write(top.with_storage(h5::compressed_storage()), "g", g);
+
+  // the policy is inherited by the subgroups
+  auto sub = top.with_storage(h5::compressed_storage(6, 1 << 16)).create_group("sub");
+  h5_write(sub, "d", d);
+  h5_write(sub, "small", small);
+  h5_write(sub, "x", 2.5);
+  h5_write(sub, "s", std::string("a string"));
+  h5_write(sub, "empty", array<double, 2>(0, 10));
+  h5_write(sub, "g_f", array<dcomplex, 3>(g, FORTRAN_LAYOUT));
+
+  auto c = get_info(top, "g_contiguous");
+  EXPECT_EQ(c.layout, H5D_CONTIGUOUS);
+  auto i = get_info(top, "g");
+  EXPECT_EQ(i.layout, H5D_CHUNKED);
+  EXPECT_EQ(i.chunk, (std::vector<hsize_t>{4096, 4, 4, 2}));
+  EXPECT_EQ(i.n_filters, 2);
+  EXPECT_EQ(get_info(sub, "d").layout, H5D_CHUNKED);
+  EXPECT_EQ(get_info(sub, "small").layout, H5D_CONTIGUOUS); // below min_bytes
+ }
+
+ // read back with the usual h5_read
+ {
+  h5::file file("h5_storage.h5", 'r');
+  h5::group top(file);
+  array<dcomplex, 3> g1, g2, g3;
+  array<double, 2> d1, e1;
+  array<long, 1> s1;
+  h5_read(top, "g_contiguous", g1);
+  h5_read(top, "g", g2);
+  h5_read(top, "sub/d", d1);
+  h5_read(top, "sub/small", s1);
+  h5_read(top, "sub/empty", e1);
+  h5_read(top, "sub/g_f", g3);
+  EXPECT_ARRAY_NEAR(g1, g);
+  EXPECT_ARRAY_NEAR(g2, g);
+  EXPECT_ARRAY_NEAR(g3, g);
+  EXPECT_ARRAY_NEAR(d1, d);
+  EXPECT_ARRAY_NEAR(s1, small);
+  EXPECT_EQ(first_dim(e1), 0);
+  double x;
+  std::string s;
+  h5_read(top, "sub/x", x);
+  h5_read(top, "sub/s", s);
+  EXPECT_EQ(x, 2.5);
+  EXPECT_EQ(s, "a string");
+ }
+}
+
+TEST(H5Storage, Size) {
+ auto g = make_g(20000, 4);
+ {
+  h5::file file("h5_storage_c.h5", 'w');
+  h5_write(h5::group(file), "g", g);
+ }
+ {
+  h5::file file("h5_storage_z.h5", 'w');
+  h5::group top(file);
+  top.set_storage(h5::compressed_storage());
+  h5_write(top, "g", g);
+ }
+ auto s_c = file_size("h5_storage_c.h5"), s_z = file_size("h5_storage_z.h5");
+ EXPECT_LT(s_z, s_c);
+}
+
+MAKE_MAIN;
@@ -214,4 +214,18 @@ TEST(hilbert_space, StateProjection) {
  check_state(proj_st, {{4,0.3},{6,0.4}}); // projected state
 }
 
+TEST(hilbert_space, ManyModesSign) {
+ // the sign of an operator counts the occupied modes beyond the 16 first ones
+ fundamental_operator_set fops;
+ for (int i = 0; i < 18; ++i) fops.insert(i);
+ using triqs::hilbert_space::hilbert_space;
+ hilbert_space hs(fops);
+
+ using triqs::operators::c;
+ state<hilbert_space, double, true> st(hs);
+ st(1 + (1 << 16) + (1 << 17)) = 1.0;
+ check_state(imperative_operator<hilbert_space>(c(17), fops)(st), {{1 + (1 << 16), 1.0}});
+ check_state(imperative_operator<hilbert_space>(c(16), fops)(st), {{1 + (1 << 17), -1.0}});
+}
+
 MAKE_MAIN;
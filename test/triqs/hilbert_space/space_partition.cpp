@@ -350,3 +350,87 @@ TEST(space_partition, Phase2) {
 
 }
 
+// An operator which can only act on states : the partition is built from the full states
+struct dense_op_t {
+ imp_op_t op;
+ state_t operator()(state_t const& st) const { return op(st); }
+};
+
+// Same partition and matrix elements from the terms of the operator and from the states
+TEST(space_partition, ConnectionsVsStates) {
+
+ static_assert(details::has_foreach_connection<imp_op_t, hilbert_space>::value, "");
+ static_assert(!details::has_foreach_connection<dense_op_t, hilbert_space>::value, "");
+
+ hilbert_space hs(fops);
+ state_t st(hs);
+
+ space_partition<state_t, imp_op_t> SP1(st, imp_op_t(H, fops));
+ space_partition<state_t, dense_op_t> SP2(st, dense_op_t{imp_op_t(H, fops)});
+ EXPECT_EQ(SP1.get_matrix_elements(), SP2.get_matrix_elements());
+
+ auto classification = [](auto& SP) {
+  std::vector<std::set<int>> v_cl(SP.n_subspaces());
+  foreach(SP, [&v_cl](int st, int spn) { v_cl[spn].insert(st); });
+  return std::set<std::set<int>>{v_cl.cbegin(), v_cl.cend()};
+ };
+ EXPECT_EQ(classification(SP1), classification(SP2));
+
+ for (int o = 0; o < 3; ++o)
+  for (auto spin : {"up", "dn"}) {
+   imp_op_t Cd(c_dag(spin, o), fops), C(c(spin, o), fops);
+   auto m1 = SP1.merge_subspaces(Cd, C);
+   auto m2 = SP2.merge_subspaces(dense_op_t{Cd}, dense_op_t{C});
+   EXPECT_EQ(m1, m2);
+   EXPECT_EQ(SP1.find_mappings(Cd), SP2.find_mappings(dense_op_t{Cd}));
+  }
+ EXPECT_EQ(classification(SP1), classification(SP2));
+}
+
+// The compiled operators act as the operators
+TEST(space_partition, CompiledOperator) {
+
+ hilbert_space hs(fops);
+ state_t st(hs);
+ imp_op_t Hop(H, fops);
+ space_partition<state_t, imp_op_t> SP(st, Hop);
+ imp_op_t Cd(c_dag("up", 1), fops), C(c("up", 1), fops);
+ SP.merge_subspaces(Cd, C);
+
+ auto fill = [](auto& psi) {
+  for (int i = 0; i < psi.size(); ++i) psi(i) = std::sin(3.0 * i + 1);
+ };
+ auto check = [](auto const& psi1, auto const& psi2) {
+  EXPECT_EQ(psi1.size(), psi2.size());
+  for (int i = 0; i < psi1.size(); ++i) EXPECT_NEAR(psi1(i), psi2(i), 1.e-12);
+ };
+
+ // On the full Hilbert space
+ state<hilbert_space, double, false> psi(hs);
+ fill(psi);
+ auto Hop_c = Hop;
+ Hop_c.compile(hs);
+ EXPECT_TRUE(Hop_c.is_compiled());
+ check(Hop(psi), Hop_c(psi));
+
+ // Between subspaces
+ std::vector<sub_hilbert_space> subspaces;
+ for (size_t n = 0; n < SP.n_subspaces(); ++n) subspaces.emplace_back(n);
+ foreach(SP, [&](int s, int spn) { subspaces[spn].add_fock_state(hs.get_fock_state(s)); });
+
+ std::vector<int> Cd_map(subspaces.size(), -1);
+ for (auto const& conn : SP.find_mappings(Cd)) Cd_map[conn.first] = conn.second;
+ using sub_op_t = imperative_operator<sub_hilbert_space, double, true>;
+ sub_op_t Cd_sub(c_dag("up", 1), fops, Cd_map, &subspaces), Cd_sub_c = Cd_sub;
+ Cd_sub_c.compile();
+ for (size_t n = 0; n < subspaces.size(); ++n) {
+  if (Cd_map[n] == -1) continue;
+  state<sub_hilbert_space, double, false> phi(subspaces[n]);
+  fill(phi);
+  check(Cd_sub(phi), Cd_sub_c(phi));
+ }
+
+ // The coefficients change : the matrices are discarded
+ Hop_c.update_coeffs([](double& x) { x *= 2; });
+ EXPECT_FALSE(Hop_c.is_compiled());
+}
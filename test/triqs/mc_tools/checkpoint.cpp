@@ -0,0 +1,215 @@
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools/mc_generic.hpp>
+#include <triqs/mc_tools/static_move_set.hpp>
+#include <chrono>
+#include <csignal>
+
+using namespace triqs::mc_tools;
+using triqs::arrays::array;
+
+// A walker on a ring of L sites, with weight 1 + x at site x (cf static_move_set)
+const int L = 8;
+
+struct configuration {
+ int x = 0;
+};
+
+// If > 0, the number of attempts before a SIGTERM (sent in the middle of a cycle)
+long attempts_before_signal = 0;
+
+template <int Step> struct move_step {
+ configuration *config;
+ int new_x;
+ double attempt() {
+  if ((attempts_before_signal > 0) && (--attempts_before_signal == 0)) std::raise(SIGTERM);
+  new_x = (config->x + Step + L) % L;
+  return (1.0 + new_x) / (1.0 + config->x);
+ }
+ double accept() {
+  config->x = new_x;
+  return 1;
+ }
+ void reject() {}
+ int snapshot() const { return config->x; } // checkpoints in the background
+};
+
+// The configuration is saved by a move
+template <int Step> void h5_write(triqs::h5::group g, std::string const &name, move_step<Step> const &m) {
+ h5_write(g, name, m.config->x);
+}
+template <int Step> void h5_read(triqs::h5::group g, std::string const &name, move_step<Step> &m) { h5_read(g, name, m.config->x); }
+
+struct measure_histo {
+ configuration *config;
+ array<double, 1> &H;
+ measure_histo(configuration *config, array<double, 1> &H) : config(config), H(H) { H() = 0; }
+ void accumulate(double sign) { H(config->x) += sign * (1 + config->x); }
+ void collect_results(triqs::mpi::communicator c) {}
+};
+void h5_write(triqs::h5::group g, std::string const &name, measure_histo const &m) { h5_write(g, name, m.H); }
+void h5_read(triqs::h5::group g, std::string const &name, measure_histo &m) { h5_read(g, name, m.H); }
+
+// The same, with a snapshot : the checkpoints are written in the background
+struct measure_histo_copy : measure_histo {
+ using measure_histo::measure_histo;
+ array<double, 1> snapshot() const { return H; }
+};
+
+struct result {
+ array<double, 1> H;
+ std::map<std::string, double> rates;
+ uint64_t config_id, cycle_number;
+ bool background;
+};
+
+const uint64_t n_warmup = 50, n_acc = 3000, length_cycle = 7;
+
+// A new Monte Carlo, with static moves or not. If file is not empty, it resumes from the checkpoint in file.
+// stop_at : the run stops after this number of cycles and writes a checkpoint in file_out.
+// checkpoint_every : if > 0, checkpoints are written in file_out during the run, in the background if background.
+result run(std::string rng, bool static_moves, std::string const &file_in, int stop_at, std::string const &file_out,
+           int &status, int checkpoint_every = 0, bool background = true) {
+ mc_generic<double> mc(rng, 1234, 1.0, 0);
+ configuration config;
+ result r;
+ r.H = array<double, 1>(L);
+ if (static_moves)
+  mc.set_static_move_set(
+      make_static_move_set<double>(mc.get_rng(), {"left", "right"}, {1, 3}, move_step<-1>{&config}, move_step<1>{&config}));
+ else {
+  mc.add_move(move_step<-1>{&config}, "left", 1);
+  mc.add_move(move_step<1>{&config}, "right", 3);
+ }
+ if (background)
+  mc.add_measure(measure_histo_copy{&config, r.H}, "histo");
+ else
+  mc.add_measure(measure_histo{&config, r.H}, "histo");
+ r.background = mc.checkpoints_in_background();
+
+ if (checkpoint_every > 0) mc.set_checkpoint(file_out, checkpoint_every);
+
+ int n = 0;
+ auto stop = [&n, stop_at]() { return (stop_at > 0) && (++n >= stop_at); };
+ if (file_in.empty())
+  status = mc.warmup_and_accumulate(n_warmup, n_acc, length_cycle, stop);
+ else {
+  triqs::h5::file f(file_in, 'r');
+  h5_read(f, "mc", mc);
+  status = mc.resume(n_warmup, n_acc, length_cycle, stop);
+ }
+ if (!file_out.empty() && (checkpoint_every == 0)) {
+  triqs::h5::file f(file_out, 'w');
+  h5_write(f, "mc", mc);
+ }
+ mc.collect_results(triqs::mpi::communicator{});
+ r.rates = mc.get_acceptance_rates();
+ r.config_id = mc.get_config_id();
+ r.cycle_number = mc.get_current_cycle_number();
+ return r;
+}
+
+void check_restart(std::string rng, bool static_moves) {
+ int status;
+ auto r0 = run(rng, static_moves, "", 0, "", status);
+ EXPECT_EQ(status, 0);
+
+ // stopped during the warmup, then during the accumulation, then resumed until the end
+ run(rng, static_moves, "", 20, "checkpoint1.h5", status);
+ EXPECT_EQ(status, 1);
+ run(rng, static_moves, "checkpoint1.h5", 1000, "checkpoint2.h5", status);
+ EXPECT_EQ(status, 1);
+ auto r1 = run(rng, static_moves, "checkpoint2.h5", 0, "", status);
+ EXPECT_EQ(status, 0);
+
+ // exactly the same run
+ EXPECT_ARRAY_EQ(r1.H, r0.H);
+ EXPECT_EQ(r1.rates, r0.rates);
+ EXPECT_EQ(r1.config_id, r0.config_id);
+ EXPECT_EQ(r1.cycle_number, r0.cycle_number);
+ EXPECT_EQ(r0.config_id, (n_warmup + n_acc) * length_cycle);
+}
+
+TEST(checkpoint, mt19937) { check_restart("mt19937", false); }
+TEST(checkpoint, philox) { check_restart("philox4x32", false); }
+TEST(checkpoint, static_move_set) { check_restart("mt19937", true); }
+
+void check_periodic(bool static_moves, bool background) {
+ int status;
+ auto r0 = run("mt19937", static_moves, "", 0, "", status);
+
+ // a crash after 1234 cycles : the last checkpoint is at cycle 1200
+ auto r = run("mt19937", static_moves, "", 1234, "checkpoint_p.h5", status, 100, background);
+ EXPECT_EQ(status, 1);
+ EXPECT_EQ(r.background, background);
+ {
+  triqs::h5::file f("checkpoint_p.h5", 'r');
+  uint64_t n;
+  h5_read(f, "mc/number_cycle_done", n);
+  EXPECT_EQ(n, 1200u);
+ }
+ auto r1 = run("mt19937", static_moves, "checkpoint_p.h5", 0, "", status);
+ EXPECT_EQ(status, 0);
+ EXPECT_ARRAY_EQ(r1.H, r0.H);
+ EXPECT_EQ(r1.rates, r0.rates);
+ EXPECT_EQ(r1.config_id, r0.config_id);
+}
+
+// A SIGTERM in the middle of a cycle : the cycle is finished, then the run stops
+TEST(checkpoint, signal) {
+ int status;
+ auto r0 = run("mt19937", false, "", 0, "", status);
+
+ attempts_before_signal = 1000 * length_cycle + 3;
+ run("mt19937", false, "", 0, "checkpoint_s.h5", status);
+ EXPECT_EQ(status, 2);
+ {
+  triqs::h5::file f("checkpoint_s.h5", 'r');
+  uint64_t n;
+  h5_read(f, "mc/config_id", n);
+  EXPECT_EQ(n, 1001 * length_cycle);
+ }
+ auto r1 = run("mt19937", false, "checkpoint_s.h5", 0, "", status);
+ EXPECT_EQ(status, 0);
+ EXPECT_ARRAY_EQ(r1.H, r0.H);
+ EXPECT_EQ(r1.rates, r0.rates);
+ EXPECT_EQ(r1.config_id, r0.config_id);
+}
+
+TEST(checkpoint, periodic) { check_periodic(false, true); }
+TEST(checkpoint, periodic_static_move_set) { check_periodic(true, true); }
+TEST(checkpoint, periodic_no_snapshot) { check_periodic(false, false); }
+
+TEST(checkpoint, every_seconds) {
+ mc_generic<double> mc("mt19937", 1234, 1.0, 0);
+ configuration config;
+ mc.add_move(move_step<1>{&config}, "right", 1);
+ mc.set_checkpoint("checkpoint_t.h5", 0, 0.01);
+ auto t0 = std::chrono::steady_clock::now();
+ mc.warmup_and_accumulate(0, 1000000000, 10, [t0]() { return std::chrono::steady_clock::now() - t0 > std::chrono::milliseconds(100); });
+ EXPECT_GE(mc.get_n_checkpoints(), 2u);
+ EXPECT_LE(mc.get_n_checkpoints(), 11u);
+ EXPECT_NO_THROW(triqs::h5::file("checkpoint_t.h5", 'r'));
+}
+
+TEST(checkpoint, random_generator_state) {
+ for (auto name : random_generator_names_list()) {
+  random_generator r1(name, 23), r2(name, 48);
+  for (int i = 0; i < 1500; ++i) r1();
+  {
+   triqs::h5::file f("rng.h5", 'w');
+   h5_write(f, "rng", r1);
+  }
+  triqs::h5::file f("rng.h5", 'r');
+  h5_read(f, "rng", r2);
+  EXPECT_EQ(r2.name(), name);
+  for (int i = 0; i < 3000; ++i) ASSERT_EQ(r1(), r2()) << name;
+ }
+ // the generator of the Mersenne Twister ""
+ random_generator r1("", 23), r2("", 48);
+ for (int i = 0; i < 1500; ++i) r1();
+ r2.set_state(r1.get_state());
+ for (int i = 0; i < 3000; ++i) ASSERT_EQ(r1(), r2());
+ EXPECT_THROW(random_generator("philox4x32", 1).set_state(r1.get_state()), triqs::runtime_error);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,178 @@
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools/mc_multi_walker.hpp>
+#include <csignal>
+
+using namespace triqs::mc_tools;
+using triqs::arrays::array;
+
+// A walker on a ring of L sites, with weight 1 + x at site x
+const int L = 8;
+
+struct configuration {
+ int x = 0;
+};
+
+struct move_step {
+ configuration *config;
+ random_generator &RNG;
+ int new_x;
+ double attempt() {
+  new_x = (config->x + (RNG(2) == 0 ? 1 : L - 1)) % L;
+  return (1.0 + new_x) / (1.0 + config->x);
+ }
+ double accept() {
+  config->x = new_x;
+  return 1;
+ }
+ void reject() {}
+};
+
+struct measure_histo {
+ configuration *config;
+ array<double, 1> &H_result; // the result, after collect_results
+ array<double, 1> H = array<double, 1>(L);
+ double Z = 0;
+ measure_histo(configuration *config, array<double, 1> &H_result) : config(config), H_result(H_result) { H() = 0; }
+ void accumulate(double sign) {
+  H(config->x) += sign;
+  Z += sign;
+ }
+ void merge(measure_histo const &m) {
+  H += m.H;
+  Z += m.Z;
+ }
+ void collect_results(triqs::mpi::communicator c) {
+  H_result = H;
+  H_result /= Z;
+ }
+};
+
+TEST(mc_multi_walker, histogram) {
+ int n_walkers = 4;
+ mc_multi_walker<double> MC(n_walkers, "", 1234, 1.0, 0);
+ std::vector<configuration> configs(n_walkers);
+ array<double, 1> H_merged(L), H_0(L);
+ for (int w = 0; w < n_walkers; ++w) {
+  auto &mc = MC.walker(w);
+  mc.add_move(move_step{&configs[w], mc.get_rng(), 0}, "step");
+  mc.add_measure(measure_histo{&configs[w], (w == 0 ? H_merged : H_0)}, "histo");
+ }
+ MC.warmup_and_accumulate(100, 20000, 10, []() { return false; });
+ MC.collect_results(triqs::mpi::communicator{});
+
+ // the walkers do not run the same chain
+ EXPECT_NE(configs[0].x + 10 * configs[1].x + 100 * configs[2].x + 1000 * configs[3].x,
+           configs[0].x * 1111);
+
+ // the merged histogram is the exact distribution, (1 + x) / sum
+ array<double, 1> H_exact(L);
+ for (int x = 0; x < L; ++x) H_exact(x) = (1.0 + x) / (L * (L + 1) / 2);
+ EXPECT_ARRAY_NEAR(H_merged, H_exact, 0.01);
+ EXPECT_NEAR(MC.get_acceptance_rates()["step"], MC.walker(0).get_acceptance_rates()["step"], 1.e-14);
+ EXPECT_GT(MC.get_acceptance_rates()["step"], 0.5);
+}
+
+// A move of one step in a fixed direction, for the static_move_set
+template <int Step> struct move_dir {
+ configuration *config;
+ int new_x;
+ double attempt() {
+  new_x = (config->x + Step + L) % L;
+  return (1.0 + new_x) / (1.0 + config->x);
+ }
+ double accept() {
+  config->x = new_x;
+  return 1;
+ }
+ void reject() {}
+};
+
+TEST(mc_multi_walker, static_move_set) {
+ int n_walkers = 3;
+ mc_multi_walker<double> MC(n_walkers, "", 1234, 1.0, 0);
+ std::vector<configuration> configs(n_walkers);
+ array<double, 1> H_merged(L), H_0(L);
+ std::vector<std::map<std::string, double>> rates;
+ for (int w = 0; w < n_walkers; ++w) {
+  auto &mc = MC.walker(w);
+  mc.set_static_move_set(make_static_move_set<double>(mc.get_rng(), {"left", "right"}, {1, 1}, move_dir<-1>{&configs[w]},
+                                                      move_dir<1>{&configs[w]}));
+  mc.add_measure(measure_histo{&configs[w], (w == 0 ? H_merged : H_0)}, "histo");
+ }
+ MC.warmup_and_accumulate(100, 20000, 10, []() { return false; });
+
+ // the rates of each walker alone
+ for (int w = 0; w < n_walkers; ++w) {
+  MC.walker(w).collect_results(triqs::mpi::communicator{});
+  rates.push_back(MC.walker(w).get_acceptance_rates());
+ }
+ MC.collect_results(triqs::mpi::communicator{});
+
+ array<double, 1> H_exact(L);
+ for (int x = 0; x < L; ++x) H_exact(x) = (1.0 + x) / (L * (L + 1) / 2);
+ EXPECT_ARRAY_NEAR(H_merged, H_exact, 0.01);
+
+ // the rates are merged over all walkers : they are between the rates of the walkers, and not the rate of walker 0
+ auto r = MC.get_acceptance_rates();
+ EXPECT_EQ(r.size(), 2);
+ for (auto name : {"left", "right"}) {
+  double r_min = 1, r_max = 0;
+  for (auto const &rw : rates) {
+   r_min = std::min(r_min, rw.at(name));
+   r_max = std::max(r_max, rw.at(name));
+  }
+  EXPECT_NE(r[name], rates[0].at(name));
+  EXPECT_GE(r[name], r_min);
+  EXPECT_LE(r[name], r_max);
+ }
+ EXPECT_GT(r["left"], 0.5);
+ EXPECT_GT(r["right"], 0.5);
+}
+
+// A move which raises a SIGTERM after n attempts
+struct move_signal {
+ long n;
+ double attempt() {
+  if (--n == 0) std::raise(SIGTERM);
+  return 1;
+ }
+ double accept() { return 1; }
+ void reject() {}
+};
+
+// A signal received by one walker stops all of them
+TEST(mc_multi_walker, signal) {
+ int n_walkers = 4;
+ mc_multi_walker<double> MC(n_walkers, "", 1234, 1.0, 0);
+ std::vector<configuration> configs(n_walkers);
+ for (int w = 0; w < n_walkers; ++w) {
+  auto &mc = MC.walker(w);
+  if (w == 2)
+   mc.add_move(move_signal{1000}, "signal");
+  else
+   mc.add_move(move_step{&configs[w], mc.get_rng(), 0}, "step");
+ }
+ int status = MC.run(1000000000, 10, []() { return false; });
+ EXPECT_EQ(status, 2);
+ for (int w = 0; w < n_walkers; ++w) EXPECT_LT(MC.walker(w).get_current_cycle_number(), 1000000000);
+}
+
+// A measure without merge can not be used with several walkers
+struct measure_no_merge {
+ void accumulate(double) {}
+ void collect_results(triqs::mpi::communicator) {}
+};
+
+TEST(mc_multi_walker, no_merge) {
+ mc_multi_walker<double> MC(2, "", 1234, 1.0, 0);
+ std::vector<configuration> configs(2);
+ for (int w = 0; w < 2; ++w) {
+  auto &mc = MC.walker(w);
+  mc.add_move(move_step{&configs[w], mc.get_rng(), 0}, "step");
+  mc.add_measure(measure_no_merge{}, "m");
+ }
+ MC.run(10, 10, []() { return false; });
+ EXPECT_THROW(MC.collect_results(triqs::mpi::communicator{}), triqs::runtime_error);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,87 @@
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools/random_generator.hpp>
+#include <triqs/mc_tools/philox.hpp>
+#include <algorithm>
+
+using namespace triqs::mc_tools;
+using RandomGenerators::philox4x32;
+
+// Known answers of Random123 (kat_vectors) for philox4x32-10
+TEST(philox, known_answers) {
+ uint32_t r[4];
+ philox4x32(0, 0).block_at(0, r);
+ EXPECT_EQ(r[0], 0x6627e8d5);
+ EXPECT_EQ(r[1], 0xe169c58d);
+ EXPECT_EQ(r[2], 0xbc57ac4c);
+ EXPECT_EQ(r[3], 0x9b00dbd8);
+ philox4x32(0xffffffffffffffff, 0xffffffffffffffff).block_at(0xffffffffffffffff, r);
+ EXPECT_EQ(r[0], 0x408f276d);
+ EXPECT_EQ(r[1], 0x41c83b0e);
+ EXPECT_EQ(r[2], 0xa20bc7c6);
+ EXPECT_EQ(r[3], 0x6d5451fd);
+ philox4x32(0x299f31d0a4093822, 0x0370734413198a2e).block_at(0x85a308d3243f6a88, r);
+ EXPECT_EQ(r[0], 0xd16cfe09);
+ EXPECT_EQ(r[1], 0x94fdcceb);
+ EXPECT_EQ(r[2], 0x5001e420);
+ EXPECT_EQ(r[3], 0x24126ea1);
+}
+
+// fill gives the blocks in order
+TEST(philox, fill) {
+ philox4x32 g(1234, 5);
+ std::vector<double> x(40);
+ g.fill(x.data(), x.size());
+ for (int n = 0; n < 20; ++n) {
+  uint32_t r[4];
+  g.block_at(n, r);
+  EXPECT_EQ(x[2 * n], double((uint64_t(r[0] >> 5) << 26) | (r[1] >> 6)) / 9007199254740992.0);
+  EXPECT_EQ(x[2 * n + 1], double((uint64_t(r[2] >> 5) << 26) | (r[3] >> 6)) / 9007199254740992.0);
+ }
+}
+
+std::vector<double> draw(random_generator &RNG, int n) {
+ std::vector<double> r(n);
+ for (auto &x : r) x = RNG();
+ return r;
+}
+
+TEST(philox, streams) {
+ random_generator RNG("philox4x32", 2345);
+ EXPECT_TRUE(RNG.has_streams());
+ auto R3 = RNG.split(3);
+ EXPECT_EQ(R3.stream_id(), 3);
+ random_generator RNG3("philox4x32", 2345, 3);
+ auto R0 = RNG.split(0);
+ int n = 5000;
+ auto x0 = draw(RNG, n), x3 = draw(R3, n);
+ // reproducible, and split(3) is the stream 3
+ EXPECT_EQ(x3, draw(RNG3, n));
+ EXPECT_EQ(x0, draw(R0, n));
+ // the streams are different
+ std::sort(x0.begin(), x0.end());
+ std::sort(x3.begin(), x3.end());
+ std::vector<double> common;
+ std::set_intersection(x0.begin(), x0.end(), x3.begin(), x3.end(), std::back_inserter(common));
+ EXPECT_EQ(common.size(), 0);
+ // uniform on [0,1[
+ for (auto const &x : {x0, x3}) {
+  double m = 0, m2 = 0;
+  for (auto y : x) {
+   EXPECT_TRUE(y >= 0 && y < 1);
+   m += y / n;
+   m2 += y * y / n;
+  }
+  EXPECT_NEAR(m, 0.5, 0.02);
+  EXPECT_NEAR(m2 - m * m, 1.0 / 12, 0.01);
+ }
+}
+
+TEST(philox, no_streams) {
+ random_generator RNG("mt19937", 2345);
+ EXPECT_FALSE(RNG.has_streams());
+ EXPECT_THROW(RNG.split(1), triqs::runtime_error);
+ auto names = random_generator_names_list();
+ EXPECT_TRUE(std::find(names.begin(), names.end(), "philox4x32") != names.end());
+}
+
+MAKE_MAIN;
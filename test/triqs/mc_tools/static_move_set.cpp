@@ -0,0 +1,85 @@
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools/mc_generic.hpp>
+#include <triqs/mc_tools/static_move_set.hpp>
+
+using namespace triqs::mc_tools;
+using triqs::arrays::array;
+
+TEST(alias_table, frequencies) {
+ std::vector<double> w = {1, 0, 3, 0.5, 5.5};
+ alias_table T(w);
+ random_generator RNG("mt19937", 2343);
+ std::vector<double> count(w.size(), 0);
+ int n = 1000000;
+ for (int i = 0; i < n; ++i) count[T(RNG())] += 1;
+ for (size_t i = 0; i < w.size(); ++i) EXPECT_NEAR(count[i] / n, w[i] / 10, 0.002);
+ EXPECT_EQ(count[1], 0);
+}
+
+// A walker on a ring of L sites, with weight 1 + x at site x
+const int L = 8;
+
+struct configuration {
+ int x = 0;
+};
+
+template <int Step> struct move_step {
+ configuration *config;
+ int new_x;
+ double attempt() {
+  new_x = (config->x + Step + L) % L;
+  return (1.0 + new_x) / (1.0 + config->x);
+ }
+ double accept() {
+  config->x = new_x;
+  return 1;
+ }
+ void reject() {}
+};
+
+struct measure_histo {
+ configuration *config;
+ array<double, 1> &H;
+ measure_histo(configuration *config, array<double, 1> &H) : config(config), H(H) { H() = 0; }
+ void accumulate(double sign) { H(config->x) += sign; }
+ void collect_results(triqs::mpi::communicator c) { H /= sum(H); }
+};
+
+// Run the walk with the moves : 0 : added one by one (type erased), 1 : in a static_move_set, 2 : static_move_set added as a move
+array<double, 1> run(int mode, std::map<std::string, double> &rates) {
+ mc_generic<double> mc("mt19937", 1234, 1.0, 0);
+ configuration config;
+ array<double, 1> H(L);
+ auto ms = make_static_move_set<double>(mc.get_rng(), {"left", "right"}, {1, 3}, move_step<-1>{&config}, move_step<1>{&config});
+ switch (mode) {
+  case 0:
+   mc.add_move(move_step<-1>{&config}, "left", 1);
+   mc.add_move(move_step<1>{&config}, "right", 3);
+   break;
+  case 1: mc.set_static_move_set(std::move(ms)); break;
+  case 2: mc.add_move(std::move(ms), "all moves"); break;
+ }
+ mc.add_measure(measure_histo{&config, H}, "histo");
+ mc.warmup_and_accumulate(100, 20000, 50, []() { return false; });
+ mc.collect_results(triqs::mpi::communicator{});
+ rates = mc.get_acceptance_rates();
+ return H;
+}
+
+TEST(static_move_set, histogram) {
+ // the moves are not symmetric, the walk is biased by the proposition probabilities (right : 3/4)
+ // but the histogram is the same with all move sets
+ std::map<std::string, double> rates_d, rates_s, rates_n;
+ auto Hd = run(0, rates_d);
+ auto Hs = run(1, rates_s);
+ auto Hn = run(2, rates_n);
+ EXPECT_ARRAY_NEAR(Hs, Hd, 0.01);
+ EXPECT_ARRAY_NEAR(Hn, Hd, 0.01);
+ for (auto r : {rates_s, rates_n}) {
+  EXPECT_NEAR(r["left"], rates_d["left"], 0.01);
+  EXPECT_NEAR(r["right"], rates_d["right"], 0.01);
+ }
+ EXPECT_EQ(rates_n.count("all moves"), 1u);
+}
+
+MAKE_MAIN;
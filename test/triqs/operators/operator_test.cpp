@@ -235,4 +235,41 @@ TEST(Operator, RealOrComplex) {
            fundamental_operator_set::reduction_t(fs2));
 }
 
+TEST(Operator, LargeProduct) {
+ // A product with many terms (accumulated in a hash map) vs the same product term by term
+ many_body_operator A, B;
+ for (int i = 0; i < 4; i++) {
+  A += (i + 1) * c_dag(i, "up") * c(i, "dn") + 0.5 * n(i, "up");
+  for (int j = 0; j < 4; j++) B += (i - j + 0.5) * c_dag(j, "dn") * c(i, "up");
+ }
+ auto AB = A * B;
+ many_body_operator AB_ref;
+ for (auto const& a : A)
+  for (auto const& b : B) {
+   many_body_operator x(a.coef), y(b.coef);
+   for (auto const& o : a.monomial) x *= many_body_operator::make_canonical(o.dagger, o.indices);
+   for (auto const& o : b.monomial) y *= many_body_operator::make_canonical(o.dagger, o.indices);
+   AB_ref += x * y;
+  }
+ EXPECT_TRUE((AB - AB_ref).is_zero());
+ EXPECT_FALSE(AB.is_zero());
+
+ // Different operators may use indices of different kinds
+ auto X = c_dag(0, 1) * c(0, 1), Y = c_dag("a") * c("a");
+ EXPECT_PRINT("1*C^+(0,1)C(0,1)", X);
+ EXPECT_PRINT("1*C^+(a)C(a)", Y);
+}
+
+TEST(Operator, Monomials) {
+ auto X = 2 * c_dag(0, "up") * c(1, "dn") + 3 * n(1, "dn");
+ // the map of the monomials, and the monomials seen by the iterators, converted to monomial_t
+ auto m = X.get_monomials();
+ EXPECT_EQ(m.size(), 2);
+ std::map<monomial_t, real_or_complex> m2;
+ for (auto const& x : X) m2.insert({monomial_t(x.monomial), x.coef});
+ EXPECT_TRUE(m == m2);
+ monomial_t m0{{true, {0, "up"}}, {false, {1, "dn"}}};
+ EXPECT_EQ(double(m[m0]), 2);
+}
+
 MAKE_MAIN;
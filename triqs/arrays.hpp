@@ -43,6 +43,7 @@
 
 // Linear algebra ?? Keep here ?
 #include <triqs/arrays/linalg/det_and_inverse.hpp>
+#include <triqs/arrays/linalg/batched_inverse.hpp>
 
 #include <triqs/arrays/mpi.hpp>
 
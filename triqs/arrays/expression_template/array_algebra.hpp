@@ -119,6 +119,44 @@ namespace triqs { namespace arrays {
    >::type
    operator - (A1 && a1) { return {std::forward<A1>(a1)};} 
  
+ // Flat evaluation of the expressions (Cf assignment.hpp)
+ namespace assignment {
+
+  template <typename S> struct flat_evaluator<_scalar_wrap<S, false>> {
+   static constexpr bool is_flat = true;
+   using value_type = typename _scalar_wrap<S, false>::value_type;
+   value_type s;
+   flat_evaluator(_scalar_wrap<S, false> const& x) : s(x.s) {}
+   template <typename IM> static bool possible(_scalar_wrap<S, false> const&, IM const&) { return true; }
+   FORCEINLINE value_type const& operator[](size_t) const { return s; }
+  };
+
+  template <typename Tag, typename L, typename R> struct flat_evaluator<array_expr<Tag, L, R>> {
+   using E = array_expr<Tag, L, R>;
+   using L_ev = flat_evaluator<std14::decay_t<L>>;
+   using R_ev = flat_evaluator<std14::decay_t<R>>;
+   static constexpr bool is_flat = L_ev::is_flat && R_ev::is_flat;
+   L_ev l;
+   R_ev r;
+   flat_evaluator(E const& x) : l(x.l), r(x.r) {}
+   template <typename IM> static bool possible(E const& x, IM const& lhs_map) {
+    return L_ev::possible(x.l, lhs_map) && R_ev::possible(x.r, lhs_map);
+   }
+   FORCEINLINE auto operator[](size_t i) const { return utility::operation<Tag>()(l[i], r[i]); }
+  };
+
+  template <typename L> struct flat_evaluator<array_unary_m_expr<L>> {
+   using L_ev = flat_evaluator<std14::decay_t<L>>;
+   static constexpr bool is_flat = L_ev::is_flat;
+   L_ev l;
+   flat_evaluator(array_unary_m_expr<L> const& x) : l(x.l) {}
+   template <typename IM> static bool possible(array_unary_m_expr<L> const& x, IM const& lhs_map) {
+    return L_ev::possible(x.l, lhs_map);
+   }
+   FORCEINLINE auto operator[](size_t i) const { return -l[i]; }
+  };
+ }
+
  // Fix for compatibility with Intel Compiler (17)
  template<typename Tag, typename L, typename R> 
  inline array_const_view<typename array_expr<Tag, L, R>::value_type, array_expr<Tag, L, R>::domain_type::rank> make_const_view(array_expr<Tag, L, R> const &x) { return make_array(x); }
@@ -114,6 +114,36 @@ namespace arrays {
   template void read_array_impl<double>(h5::group g, std::string const& name, double* start, array_stride_info info);
   template void read_array_impl<dcomplex>(h5::group g, std::string const& name, dcomplex* start, array_stride_info info);
 
+  template <typename T>
+  void read_array_slice_impl(h5::group g, std::string const& name, T* start, array_stride_info info, h5_slice const& sl) {
+   bool is_complex = triqs::is_complex<T>::value;
+   h5::dataset ds = g.open_dataset(name);
+   h5::dataspace d_space = H5Dget_space(ds);
+
+   // select the hyperslab in the file (and the real/imaginary part for complex)
+   std::vector<hsize_t> offset(sl.offset), stride(sl.stride), count(sl.count);
+   if (is_complex) {
+    offset.push_back(0);
+    stride.push_back(1);
+    count.push_back(2);
+   }
+   if (H5Sselect_hyperslab(d_space, H5S_SELECT_SET, offset.data(), stride.data(), count.data(), NULL) < 0)
+    TRIQS_RUNTIME_ERROR << "Cannot select the hyperslab in the dataset " << name << " in the group" << g.name();
+
+   if (H5Sget_select_npoints(d_space) > 0) {
+    herr_t err =
+        H5Dread(ds, h5::data_type_memory<T>(), data_space_impl(info, is_complex), d_space, H5P_DEFAULT, h5::get_data_ptr(start));
+    if (err < 0) TRIQS_RUNTIME_ERROR << "Error reading a slice of the dataset " << name << " in the group" << g.name();
+   }
+  }
+
+  template void read_array_slice_impl<int>(h5::group g, std::string const& name, int* start, array_stride_info info, h5_slice const& sl);
+  template void read_array_slice_impl<long>(h5::group g, std::string const& name, long* start, array_stride_info info, h5_slice const& sl);
+  template void read_array_slice_impl<double>(h5::group g, std::string const& name, double* start, array_stride_info info,
+                                              h5_slice const& sl);
+  template void read_array_slice_impl<dcomplex>(h5::group g, std::string const& name, dcomplex* start, array_stride_info info,
+                                                h5_slice const& sl);
+
   void read_array(h5::group g, std::string const& name, arrays::vector<std::string>& V) {
    std::vector<std::string> tmp;
    h5_read(g, name, tmp);
@@ -103,6 +103,69 @@ namespace arrays {
   void read_array(h5::group g, std::string const& name, arrays::vector<std::string>& V);
   void read_array(h5::group f, std::string const& name, arrays::array<std::string, 1>& V);
 
+  /*********************************** READ a slice of an array ***************************************************/
+
+  // The hyperslab of the dataset in the file, and the lengths of the result (the dimensions selected by a range)
+  struct h5_slice {
+   std::vector<hsize_t> offset, stride, count;
+   std::vector<size_t> lengths;
+  };
+
+  // L : the length of the dimension in the file
+  inline void add_to_slice(h5_slice& sl, size_t L, range const& r) {
+   std::ptrdiff_t last = (r.last() == -1 ? L : r.last());
+   if ((r.first() < 0) || (r.step() <= 0) || (last > std::ptrdiff_t(L)) || (r.first() > last))
+    TRIQS_RUNTIME_ERROR << "h5_read_slice : range(" << r.first() << "," << r.last() << "," << r.step()
+                        << ") out of the dimension of length " << L << " in the file";
+   size_t n = (last - r.first() + r.step() - 1) / r.step();
+   sl.offset.push_back(r.first());
+   sl.stride.push_back(r.step());
+   sl.count.push_back(n);
+   sl.lengths.push_back(n);
+  }
+
+  inline void add_to_slice(h5_slice& sl, size_t L, std::ptrdiff_t i) {
+   if ((i < 0) || (i >= std::ptrdiff_t(L)))
+    TRIQS_RUNTIME_ERROR << "h5_read_slice : index " << i << " out of the dimension of length " << L << " in the file";
+   sl.offset.push_back(i);
+   sl.stride.push_back(1);
+   sl.count.push_back(1);
+  }
+
+  template <typename... S> h5_slice make_h5_slice(std::vector<size_t> const& file_lengths, S const&... s) {
+   h5_slice sl;
+   int u = 0;
+   auto l = {(add_to_slice(sl, file_lengths[u++], s), 0)...}; // in order
+   (void)l;
+   return sl;
+  }
+
+  template <typename T>
+  void read_array_slice_impl(h5::group g, std::string const& name, T* start, array_stride_info info, h5_slice const& sl);
+
+  // the number of ranges in S...
+  template <typename... S> struct n_ranges : std::integral_constant<int, 0> {};
+  template <typename S0, typename... S>
+  struct n_ranges<S0, S...> : std::integral_constant<int, std::is_same<S0, range>::value + n_ranges<S...>::value> {};
+
+  template <typename A, typename... S> void read_array_slice(h5::group g, std::string const& name, A& a, S const&... s) {
+   constexpr bool is_complex = triqs::is_complex<typename A::value_type>::value;
+   static_assert(n_ranges<S...>::value == A::rank, "h5_read_slice : the rank of the array must be the number of ranges");
+
+   if (is_complex && !is_dataset_complex(g, name)) { // if not complex in file, we load in real and assign
+    array<double, A::rank> tmp;
+    read_array_slice(g, name, tmp, s...);
+    resize_or_check(a, tmp.shape());
+    a = tmp;
+    return;
+   }
+
+   auto sl = make_h5_slice(get_array_lengths(sizeof...(S), g, name, is_complex), s...);
+   resize_or_check(a, mini_vector<size_t, A::rank>(sl.lengths));
+   auto b = make_cache(a);
+   read_array_slice_impl(g, name, b.view().data_start(), array_stride_info{b.view()}, sl);
+  }
+
  } // namespace h5_impl
 
  // a trait to detect if A::value_type exists and is a scalar or a string
@@ -135,6 +198,21 @@ namespace arrays {
   h5_impl::read_array(g, name, A);
  }
 
+ /**
+  * Read a slice of an array stored in an hdf5 file, without reading the rest of the dataset.
+  * g The h5 group
+  * name The name of the hdf5 array in the group
+  * A The result : an array (resized) or a view (of the size of the slice)
+  * s... For each dimension of the array in the file, a range, or an integer which drops the dimension, as in A(s...)
+  *
+  * E.g. h5_read_slice(g, "G", A, range(10, 20), 0, range()) reads G(range(10, 20), 0, range()) into a matrix A.
+  */
+ template <typename ArrayType, typename... S>
+ ENABLE_IFC(is_amv_value_or_view_class<std14::decay_t<ArrayType>>::value)
+ h5_read_slice(h5::group g, std::string const& name, ArrayType&& A, S const&... s) {
+  h5_impl::read_array_slice(g, name, A, s...);
+ }
+
  /*
   * Write an array or a view into an hdf5 file
   * ArrayType The type of the array/matrix/vector, etc..
@@ -67,6 +67,67 @@ namespace triqs { namespace arrays {
   template<typename A,typename B> struct _ops_ <A,B,'M'> { static void invoke (A & a, B const & b) { a*=b;} };
   template<typename A,typename B> struct _ops_ <A,B,'D'> { static void invoke (A & a, B const & b) { a/=b;} };
 
+  // -----------------    flat evaluation --------------------------------------------------
+  // When the LHS and all the arrays in the RHS are contiguous, with the same lengths and memory layout,
+  // an element has the same position in the memory of all of them : the assignment is then a single loop
+  // over the linear memory, that the compiler can vectorize, instead of a foreach with multi-indices.
+  // flat_evaluator<RHS> computes the element of RHS at a linear position.
+  // It is specialized for the arrays here, for the scalars and the array expressions in array_algebra.hpp.
+  template<typename T, typename Enable = void> struct flat_evaluator { static constexpr bool is_flat = false; };
+
+  template <typename M1, typename M2> bool same_flat_layout(M1 const&, M2 const&) { return false; }
+  template <int R, typename To1, typename To2>
+  bool same_flat_layout(indexmaps::cuboid::map<R, To1> const& X1, indexmaps::cuboid::map<R, To2> const& X2) {
+   return (X1.get_memory_layout() == X2.get_memory_layout()) && X1.is_contiguous() && X2.is_contiguous() &&
+          (X1.lengths() == X2.lengths());
+  }
+
+  template <typename T> struct flat_evaluator<T, std14::enable_if_t<std::is_base_of<Tag::indexmap_storage_pair, T>::value>> {
+   static constexpr bool is_flat = true;
+   typename std::remove_cv<typename T::value_type>::type const* p;
+   flat_evaluator(T const& x) : p(x.data_start()) {}
+   template <typename IM> static bool possible(T const& x, IM const& lhs_map) { return same_flat_layout(x.indexmap(), lhs_map); }
+   FORCEINLINE auto const& operator[](size_t i) const { return p[i]; }
+  };
+
+  template <typename S> struct flat_scalar {
+   S const& s;
+   FORCEINLINE S const& operator[](size_t) const { return s; }
+  };
+
+  // The loop itself, on [b,e)
+  template <char OP, typename T, typename Ev> void flat_assign_range(T* p, Ev const& ev, std::ptrdiff_t b, std::ptrdiff_t e) {
+   for (std::ptrdiff_t i = b; i < e; ++i) _ops_<T, std14::decay_t<decltype(ev[i])>, OP>::invoke(p[i], ev[i]);
+  }
+
+  // The LHS is contiguous. The range is split among the threads according to the global execution policy
+  template <char OP, typename LHS, typename Ev> void flat_assign(LHS& lhs, Ev const& ev) {
+   using v_t = typename std::remove_cv<typename LHS::value_type>::type;
+   v_t* p = lhs.data_start();
+   const std::ptrdiff_t n = lhs.domain().number_of_elements();
+   const int n_threads = n_threads_for(get_execution_policy(), n);
+   if (n_threads == 1) {
+    flat_assign_range<OP>(p, ev, 0, n);
+    return;
+   }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+   for (int c = 0; c < n_threads; ++c) flat_assign_range<OP>(p, ev, n * c / n_threads, n * (c + 1) / n_threads);
+  }
+
+  // Returns false if the flat evaluation is not possible, and nothing was done
+  template <char OP, typename LHS, typename RHS> bool try_flat_assign(LHS& lhs, RHS const& rhs, std::true_type) {
+   if (!lhs.indexmap().is_contiguous() || !flat_evaluator<RHS>::possible(rhs, lhs.indexmap())) return false;
+   flat_assign<OP>(lhs, flat_evaluator<RHS>(rhs));
+   return true;
+  }
+  template <char OP, typename LHS, typename RHS> bool try_flat_assign(LHS&, RHS const&, std::false_type) { return false; }
+
+  template <char OP, typename LHS, typename RHS> bool try_flat_assign(LHS& lhs, RHS const& rhs) {
+   return try_flat_assign<OP>(lhs, rhs, std::integral_constant<bool, flat_evaluator<RHS>::is_flat>{});
+  }
+
   // RHS is considered to be an indexmap_storage_pair if it is one, ... except if it is the scalar type of hte LHS
   // think about an Array< Array<T,2> > e.g.
   template<class RHS,class LHS> struct is_isp :
@@ -106,7 +167,7 @@ namespace triqs { namespace arrays {
       if (( (OP=='E') && indexmaps::raw_copy_possible(lhs.indexmap(), rhs.indexmap()))) {
        storages::memcopy(lhs.data_start(), rhs.data_start(), rhs.indexmap().domain().number_of_elements());
       }
-      else { foreach(lhs,*this); }
+      else if (!try_flat_assign<OP>(lhs, rhs)) { foreach(lhs, *this, get_execution_policy()); }
      }
     };
 
@@ -119,7 +180,7 @@ namespace triqs { namespace arrays {
       LHS & lhs; const RHS & rhs; 
       impl(LHS & lhs_, const RHS & rhs_): lhs(lhs_), rhs(rhs_) {}
       template<typename ... Args> void operator()(Args const & ... args) const { _ops_<value_type, typename RHS::value_type, OP>::invoke(lhs(args...),rhs(args...));}
-      FORCEINLINE void invoke() { foreach(lhs,*this); }
+      FORCEINLINE void invoke() { if (!try_flat_assign<OP>(lhs, rhs)) foreach(lhs, *this, get_execution_policy()); }
      };
 
      // help compiler : in the most common case, less things to inline..
@@ -129,7 +190,7 @@ namespace triqs { namespace arrays {
       typedef typename LHS::value_type value_type;
       LHS & lhs; const RHS & rhs;
       impl(LHS & lhs_, const RHS & rhs_): lhs(lhs_), rhs(rhs_) {}
-      FORCEINLINE void invoke() { assign_foreach(lhs, rhs); }
+      FORCEINLINE void invoke() { if (!try_flat_assign<'E'>(lhs, rhs)) assign_foreach(lhs, rhs); }
      };
 
     // -----------------   assignment for scalar RHS, except some matrix case --------------------------------------------------
@@ -140,7 +201,12 @@ namespace triqs { namespace arrays {
       LHS & lhs; const RHS & rhs; 
       impl(LHS & lhs_, const RHS & rhs_): lhs(lhs_), rhs(rhs_){}
       template<typename ... Args> void operator()(Args const & ...args) const {_ops_<value_type, RHS, OP>::invoke(lhs(args...), rhs);}
-      void invoke() { foreach(lhs,*this);  }
+      void invoke() {
+       if (lhs.indexmap().is_contiguous())
+        flat_assign<OP>(lhs, flat_scalar<RHS>{rhs});
+       else
+        foreach(lhs, *this, get_execution_policy());
+      }
      };
 
     // -----------------   assignment for scalar RHS for Matrices --------------------------------------------------
@@ -166,7 +232,7 @@ namespace triqs { namespace arrays {
       else
        _ops_<value_type, value_type, OP>::invoke(lhs(args...), 0);
      }
-     void invoke() { foreach(lhs, *this); }
+     void invoke() { foreach(lhs, *this, get_execution_policy()); }
     };
 
     // Specialisation for Matrix Classes : scalar is a unity matrix, and operation is E, A, S, but NOT M, D
@@ -182,7 +248,7 @@ namespace triqs { namespace arrays {
      template <typename... Args> void operator()(Args const&... args) const {
       _ops_<value_type, RHS, OP>::invoke(lhs(args...), (kronecker(args...) ? rhs : RHS{0 * rhs}));
      }
-     void invoke() { foreach(lhs, *this); }
+     void invoke() { foreach(lhs, *this, get_execution_policy()); }
     };
 
 #undef TRIQS_REJECT_MATRIX_COMPOUND_MUL_DIV_NON_SCALAR
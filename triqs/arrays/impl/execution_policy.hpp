@@ -0,0 +1,90 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace triqs {
+namespace arrays {
+
+ /**
+  * Execution policy of the element-wise operations on arrays.
+  *
+  * When the library is compiled with OpenMP (cmake -DUSE_OPENMP=ON), the element-wise operations
+  * on arrays with at least min_size elements are split on the slowest index across n_threads threads.
+  * Without OpenMP, the policy is ignored and everything is serial.
+  *
+  *  - The assignments (A = expr, A += expr, ..., including map and clef auto-assignment A(i_,j_) << expr)
+  *    use the current policy, set by set_execution_policy or by an execution_policy_guard in a scope.
+  *    The default policy is serial.
+  *    The current policy is per thread (thread_local) : it is changed for the calling thread only,
+  *    and a new thread starts with the default (serial) policy.
+  *  - foreach(A, F) is always serial, since F may have side effects (e.g. accumulate a sum).
+  *    foreach(A, F, policy) runs in parallel according to policy : F must then be thread safe.
+  *
+  * In parallel, the elements are computed in an unspecified order.
+  */
+ struct execution_policy {
+  int n_threads = 1;       // 1 : serial. 0 : the default number of OpenMP threads
+  long min_size = 1 << 15; // below this number of elements, the operation is serial
+ };
+
+ /// A parallel policy, on all the OpenMP threads
+ inline execution_policy parallel_policy(long min_size = 1 << 15) { return {0, min_size}; }
+
+ namespace execution_policy_impl {
+  inline execution_policy& current_execution_policy() {
+   static thread_local execution_policy p;
+   return p;
+  }
+ }
+
+ /// The policy of the calling thread, used by the assignments
+ inline execution_policy const& get_execution_policy() { return execution_policy_impl::current_execution_policy(); }
+
+ /// Change the policy of the calling thread
+ inline void set_execution_policy(execution_policy const& p) { execution_policy_impl::current_execution_policy() = p; }
+
+ /// Change the policy of the calling thread in a scope, e.g. { execution_policy_guard _(parallel_policy()); G = G0 + S;}
+ class execution_policy_guard {
+  execution_policy old;
+
+  public:
+  execution_policy_guard(execution_policy const& p) : old(get_execution_policy()) { set_execution_policy(p); }
+  ~execution_policy_guard() { set_execution_policy(old); }
+  execution_policy_guard(execution_policy_guard const&) = delete;
+  execution_policy_guard& operator=(execution_policy_guard const&) = delete;
+ };
+
+ /// Number of threads to use for an operation on n_elements elements (1 : serial)
+ inline int n_threads_for(execution_policy const& p, long n_elements) {
+#ifdef _OPENMP
+  if ((p.n_threads == 1) || (n_elements < p.min_size) || omp_in_parallel()) return 1;
+  return (p.n_threads > 0 ? p.n_threads : omp_get_max_threads());
+#else
+  (void)p;
+  (void)n_elements;
+  return 1;
+#endif
+ }
+}
+}
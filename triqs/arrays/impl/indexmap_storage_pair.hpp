@@ -287,12 +287,12 @@ namespace triqs { namespace arrays {
      // ------------------------------- clef auto assign --------------------------------------------
 
     template <typename Fnt> friend void triqs_clef_auto_assign(indexmap_storage_pair &x, Fnt f) {
-      foreach (x, array_auto_assign_worker<indexmap_storage_pair, Fnt>{x, f});
+      foreach (x, array_auto_assign_worker<indexmap_storage_pair, Fnt>{x, f}, get_execution_policy());
      }
      // for views only !
      template <typename Fnt> friend void triqs_clef_auto_assign(indexmap_storage_pair &&x, Fnt f) {
       static_assert(IsView, "Internal errro");
-      foreach (x, array_auto_assign_worker<indexmap_storage_pair, Fnt>{x, f});
+      foreach (x, array_auto_assign_worker<indexmap_storage_pair, Fnt>{x, f}, get_execution_policy());
      }
      // template<typename Fnt> friend void triqs_clef_auto_assign (indexmap_storage_pair & x, Fnt f) { assign_foreach(x,f);}
 
@@ -21,6 +21,7 @@
 #pragma once
 #include "./map.hpp"
 #include "./mem_layout.hpp"
+#include "../../impl/execution_policy.hpp"
 #include <boost/preprocessor/repetition/enum_params.hpp>
 #include <boost/preprocessor/repetition/repeat_from_to.hpp>
 #include <boost/preprocessor/repetition/repeat.hpp>
@@ -84,6 +85,46 @@ namespace arrays {
 #undef AUX_Custom1
 #undef AUX3
 #undef AUX3C
+
+   // ------------------------- parallel foreach -----------------------------------------------------
+
+   // The index of the outermost loop of the traversal
+   template <int R> int outer_index(_traversal_c, memory_layout<R> const&) { return 0; }
+   template <int R> int outer_index(_traversal_fortran, memory_layout<R> const&) { return R - 1; }
+   template <int R> int outer_index(_traversal_dynamical, memory_layout<R> const& ml) { return ml[0]; }
+   template <int R, int... Is> int outer_index(_traversal_custom<Is...>, memory_layout<R> const&) {
+    return permutations::apply(permutations::permutation(Is...), 0);
+   }
+
+   // Calls (a copy of) F with the index d shifted
+   template <typename FntType> struct _shifted_fnt {
+    FntType F;
+    int d;
+    foreach_int_type shift;
+    template <size_t... Is, typename... Args> FORCEINLINE void call(std14::index_sequence<Is...>, Args const&... args) {
+     F((int(Is) == d ? args + shift : args)...);
+    }
+    template <typename... Args> FORCEINLINE void operator()(Args const&... args) {
+     call(std14::make_index_sequence<sizeof...(Args)>{}, args...);
+    }
+   };
+
+   // The outermost loop is split in n_threads slices
+   template <typename Traversal, int R, typename FntType>
+   void foreach_impl_parallel(Traversal t, domain_t<R> const& dom, memory_layout<R> const& ml, FntType const& F, int n_threads) {
+    const int d = outer_index(t, ml);
+    const foreach_int_type L = dom.lengths()[d];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+    for (int c = 0; c < n_threads; ++c) {
+     foreach_int_type b = L * c / n_threads, e = L * (c + 1) / n_threads;
+     if (b == e) continue;
+     auto l = dom.lengths();
+     l[d] = e - b;
+     foreach_impl(t, domain_t<R>(l), ml, _shifted_fnt<FntType>{F, d, b});
+    }
+   }
   }
  }
 
@@ -114,12 +155,33 @@ namespace arrays {
 #endif
  }
 
+ /// foreach with an execution policy : F may be called in parallel (Cf execution_policy.hpp)
+ template <typename T, typename Function>
+ std14::enable_if_t<ImmutableCuboidArray<T>::value> foreach(T const& x, Function const& F, execution_policy const& p) {
+  using S = _get_traversal_order<T>;
+  int n_threads = n_threads_for(p, x.domain().number_of_elements());
+  if (n_threads > 1)
+   indexmaps::cuboid::foreach_impl_parallel(typename S::traversal_order_t{}, x.domain(), S::invoke(x), F, n_threads);
+  else
+   foreach(x, F);
+ }
+
 /// --------------- ASSIGN FOREACH ------------------------
  template <typename T, typename Function>
- std14::enable_if_t<MutableCuboidArray<T>::value> assign_foreach(T& x, Function const& f) {
+ std14::enable_if_t<MutableCuboidArray<T>::value> assign_foreach(T& x, Function const& f, execution_policy const& p) {
   using S = _get_traversal_order<T>;
-  indexmaps::cuboid::foreach_impl(typename S::traversal_order_t{}, x.domain(), S::invoke(x),
-                                  [&x, &f](auto const&... args) { x(args...) = f(args...); });
+  auto F = [&x, &f](auto const&... args) { x(args...) = f(args...); };
+  int n_threads = n_threads_for(p, x.domain().number_of_elements());
+  if (n_threads > 1)
+   indexmaps::cuboid::foreach_impl_parallel(typename S::traversal_order_t{}, x.domain(), S::invoke(x), F, n_threads);
+  else
+   indexmaps::cuboid::foreach_impl(typename S::traversal_order_t{}, x.domain(), S::invoke(x), F);
+ }
+
+ /// assign_foreach with the global execution policy
+ template <typename T, typename Function>
+ std14::enable_if_t<MutableCuboidArray<T>::value> assign_foreach(T& x, Function const& f) {
+  assign_foreach(x, f, get_execution_policy());
  }
 }
 } // namespace
@@ -0,0 +1,257 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./det_and_inverse.hpp"
+#include "../impl/execution_policy.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace triqs {
+namespace arrays {
+
+ namespace batched_inverse_impl {
+
+  // The matrices are inverted in place, in their memory order : since inverse(transpose(M)) = transpose(inverse(M)),
+  // the kernels are the same for C and Fortran order. They return false iif the matrix is singular.
+
+  inline double pivot_norm(double x) { return std::abs(x); }
+  inline double pivot_norm(std::complex<double> const &x) { return std::abs(x.real()) + std::abs(x.imag()); } // as izamax
+
+  // ------------------ closed forms, N <= 4 ----------------------
+
+  template <typename T> bool invert_1(T *a) {
+   if (a[0] == T(0)) return false;
+   a[0] = T(1) / a[0];
+   return true;
+  }
+
+  template <typename T> bool invert_2(T *a) {
+   T det = a[0] * a[3] - a[1] * a[2];
+   if (det == T(0)) return false;
+   T u = T(1) / det, a0 = a[0];
+   a[0] = a[3] * u;
+   a[1] = -a[1] * u;
+   a[2] = -a[2] * u;
+   a[3] = a0 * u;
+   return true;
+  }
+
+  template <typename T> bool invert_3(T *a) {
+   T c00 = a[4] * a[8] - a[5] * a[7], c01 = a[5] * a[6] - a[3] * a[8], c02 = a[3] * a[7] - a[4] * a[6];
+   T det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+   if (det == T(0)) return false;
+   T u = T(1) / det;
+   T b01 = a[2] * a[7] - a[1] * a[8], b02 = a[1] * a[5] - a[2] * a[4];
+   T b11 = a[0] * a[8] - a[2] * a[6], b12 = a[2] * a[3] - a[0] * a[5];
+   T b21 = a[1] * a[6] - a[0] * a[7], b22 = a[0] * a[4] - a[1] * a[3];
+   a[0] = c00 * u, a[1] = b01 * u, a[2] = b02 * u;
+   a[3] = c01 * u, a[4] = b11 * u, a[5] = b12 * u;
+   a[6] = c02 * u, a[7] = b21 * u, a[8] = b22 * u;
+   return true;
+  }
+
+  // With the 2x2 minors of the first two rows (s) and of the last two rows (c)
+  template <typename T> bool invert_4(T *a) {
+   T s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[6] - a[4] * a[2], s2 = a[0] * a[7] - a[4] * a[3];
+   T s3 = a[1] * a[6] - a[5] * a[2], s4 = a[1] * a[7] - a[5] * a[3], s5 = a[2] * a[7] - a[6] * a[3];
+   T c5 = a[10] * a[15] - a[14] * a[11], c4 = a[9] * a[15] - a[13] * a[11], c3 = a[9] * a[14] - a[13] * a[10];
+   T c2 = a[8] * a[15] - a[12] * a[11], c1 = a[8] * a[14] - a[12] * a[10], c0 = a[8] * a[13] - a[12] * a[9];
+   T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+   if (det == T(0)) return false;
+   T u = T(1) / det;
+   T b[16];
+   b[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * u;
+   b[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * u;
+   b[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * u;
+   b[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * u;
+   b[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * u;
+   b[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * u;
+   b[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * u;
+   b[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * u;
+   b[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * u;
+   b[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * u;
+   b[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * u;
+   b[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * u;
+   b[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * u;
+   b[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * u;
+   b[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * u;
+   b[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * u;
+   std::copy(b, b + 16, a);
+   return true;
+  }
+
+  // ------------------ Gauss-Jordan with partial pivoting, N fixed ----------------------
+
+  // The sizes are known at compile time : the loops are unrolled/vectorized by the compiler.
+  template <int N, typename T> bool invert_gauss_jordan(T *a) {
+   int piv[N];
+   for (int k = 0; k < N; ++k) {
+    int p = k;
+    double m = pivot_norm(a[k * N + k]);
+    for (int i = k + 1; i < N; ++i) {
+     double x = pivot_norm(a[i * N + k]);
+     if (x > m) {
+      m = x;
+      p = i;
+     }
+    }
+    if (m == 0) return false;
+    piv[k] = p;
+    if (p != k)
+     for (int j = 0; j < N; ++j) std::swap(a[k * N + j], a[p * N + j]);
+    T u = T(1) / a[k * N + k];
+    a[k * N + k] = 1;
+    for (int j = 0; j < N; ++j) a[k * N + j] *= u;
+    for (int i = 0; i < N; ++i) {
+     if (i == k) continue;
+     T f = a[i * N + k];
+     a[i * N + k] = 0;
+     for (int j = 0; j < N; ++j) a[i * N + j] -= f * a[k * N + j];
+    }
+   }
+   // undo the row permutations on the columns
+   for (int k = N - 1; k >= 0; --k)
+    if (piv[k] != k)
+     for (int i = 0; i < N; ++i) std::swap(a[i * N + k], a[i * N + piv[k]]);
+   return true;
+  }
+ }
+
+ /**
+  * Inverts in place a sequence of n x n matrices, contiguous in memory (C or Fortran order).
+  *
+  *  - n <= 4 : closed forms (cofactors).
+  *  - n <= 8 : Gauss-Jordan with partial pivoting, with the size known at compile time.
+  *  - larger n : lapack getrf/getri, with the pivots and the workspace allocated once.
+  *
+  * A singular matrix (exactly zero determinant or pivot) is reported by invert, as with lapack.
+  * A worker is not thread safe : use one worker per thread.
+  */
+ template <typename T> class batched_inverse_worker {
+  static_assert(is_blas_lapack_type<T>::value, "batched_inverse_worker : only for double and dcomplex");
+  int n;
+  std::vector<int> ipiv;
+  std::vector<T> work;
+
+  public:
+  batched_inverse_worker(int n_) : n(n_) {
+   if (n <= 8) return;
+   ipiv.resize(n);
+   int info;
+   T work1[2];
+   lapack::f77::getri(n, nullptr, n, nullptr, work1, -1, info); // workspace query
+   work.resize(std::max(size_t(n), lapack::r_round(work1[0])));
+  }
+
+  int dim() const { return n; }
+
+  /// Inverts the matrix at p in place. Returns false iif it is singular.
+  bool invert(T *p) {
+   using namespace batched_inverse_impl;
+   switch (n) {
+    case 0: return true;
+    case 1: return invert_1(p);
+    case 2: return invert_2(p);
+    case 3: return invert_3(p);
+    case 4: return invert_4(p);
+    case 5: return invert_gauss_jordan<5>(p);
+    case 6: return invert_gauss_jordan<6>(p);
+    case 7: return invert_gauss_jordan<7>(p);
+    case 8: return invert_gauss_jordan<8>(p);
+   }
+   int info;
+   lapack::f77::getrf(n, n, p, n, ipiv.data(), info);
+   if (info != 0) return false;
+   lapack::f77::getri(n, p, n, ipiv.data(), work.data(), work.size(), info);
+   return (info == 0);
+  }
+ };
+
+ namespace batched_inverse_impl {
+
+  // Inverts the matrices [b, e) of a, at stride s. Returns the first singular one, or e.
+  template <typename T> long invert_range(T *a, std::ptrdiff_t s, int n, long b, long e) {
+   batched_inverse_worker<T> w(n);
+   for (long i = b; i < e; ++i)
+    if (!w.invert(a + i * s)) return i;
+   return e;
+  }
+
+  // The matrices a(i,_,_) are contiguous, in C or Fortran order
+  template <typename A3> bool has_contiguous_matrices(A3 const &a) {
+   auto const &st = a.indexmap().strides();
+   long n = second_dim(a);
+   if (n <= 1) return true;
+   return ((st[1] == n) && (st[2] == 1)) || ((st[1] == 1) && (st[2] == n));
+  }
+
+  // Fallback : one matrix at a time
+  template <typename A3> void invert_one_by_one(A3 &a) {
+   for (size_t i = 0; i < first_dim(a); ++i) {
+    auto v = make_matrix_view(a(i, range(), range()));
+    v = inverse(v);
+   }
+  }
+
+  template <typename A3> void batched_inverse_in_place(A3 &a, execution_policy const &pol, std::true_type) {
+   long n_mat = first_dim(a);
+   int n = second_dim(a);
+   if (!has_contiguous_matrices(a)) return invert_one_by_one(a);
+   auto *p = a.data_start();
+   auto s = a.indexmap().strides()[0];
+   int n_threads = n_threads_for(pol, n_mat * n * n);
+   long bad = n_mat;
+   if (n_threads == 1)
+    bad = invert_range(p, s, n, 0, n_mat);
+   else {
+    std::vector<long> bad_in_chunk(n_threads);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+    for (int c = 0; c < n_threads; ++c) {
+     long e = n_mat * (c + 1) / n_threads;
+     bad_in_chunk[c] = invert_range(p, s, n, n_mat * c / n_threads, e);
+     if (bad_in_chunk[c] == e) bad_in_chunk[c] = n_mat;
+    }
+    bad = *std::min_element(bad_in_chunk.begin(), bad_in_chunk.end());
+   }
+   if (bad != n_mat) throw matrix_inverse_exception() << "Inverse error : the matrix " << bad << " of the batch is not invertible";
+  }
+
+  template <typename A3> void batched_inverse_in_place(A3 &a, execution_policy const &, std::false_type) { invert_one_by_one(a); }
+ }
+
+ /**
+  * Inverts in place the matrices a(i,_,_) of a rank 3 array or array_view a, e.g. the data of a matrix valued gf.
+  * The matrices are split among the threads according to the execution policy.
+  */
+ template <typename A3> void batched_inverse_in_place(A3 &&a, execution_policy const &pol = get_execution_policy()) {
+  using A_t = std14::decay_t<A3>;
+  static_assert(A_t::rank == 3, "batched_inverse_in_place : the array must be of rank 3");
+  if (second_dim(a) != third_dim(a))
+   TRIQS_RUNTIME_ERROR << "batched_inverse_in_place : the matrices are not square but of size " << second_dim(a) << " x "
+                       << third_dim(a);
+  using v_t = typename std::remove_cv<typename A_t::value_type>::type;
+  batched_inverse_impl::batched_inverse_in_place(a, pol, std::integral_constant<bool, is_blas_lapack_type<v_t>::value>{});
+ }
+}
+}
@@ -0,0 +1,212 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/utility/first_include.hpp>
+#include "./allocators.hpp"
+#include "./mem_block.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+namespace triqs {
+namespace arrays {
+ namespace storages {
+  namespace allocators {
+
+#ifdef TRIQS_ARRAYS_DEBUG_COUNT_MEMORY
+#define TRIQS_POOL_COUNT(X) ++__global_memory_allocated_from_c.X
+#else
+#define TRIQS_POOL_COUNT(X)
+#endif
+
+   namespace {
+
+    // ------------------ system allocation ----------------------
+
+    // The aligned block is preceded by a header, in the alignment padding, which tells how to release it.
+    // (malloc + padding is much faster than posix_memalign).
+    struct header {
+     void* raw;        // the pointer returned by malloc or mmap
+     size_t map_size;  // the size of the mapping if the block was mmapped, 0 if it was malloced
+    };
+
+    inline char* align_up(char* p, size_t align) {
+     return reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + align - 1) & ~std::uintptr_t(align - 1));
+    }
+
+    inline header* get_header(void* p) { return static_cast<header*>(p) - 1; }
+
+    void* system_allocate(size_t bytes) {
+     char* raw = static_cast<char*>(std::malloc(bytes + alignment + sizeof(header)));
+     if (!raw) throw std::bad_alloc{};
+     char* p = align_up(raw + sizeof(header), alignment);
+     *get_header(p) = {raw, 0};
+     return p;
+    }
+
+    // A block aligned on the huge pages, advised to use them
+    void* system_allocate_huge_pages(size_t bytes) {
+     size_t rounded = (bytes + pooled::huge_page_size - 1) / pooled::huge_page_size * pooled::huge_page_size;
+     size_t map_size = rounded + pooled::huge_page_size;
+     void* raw = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+     if (raw == MAP_FAILED) throw std::bad_alloc{};
+     char* p = align_up(static_cast<char*>(raw) + sizeof(header), pooled::huge_page_size);
+#ifdef MADV_HUGEPAGE
+     madvise(p, rounded, MADV_HUGEPAGE); // only a hint : ignore the failure
+#endif
+     *get_header(p) = {raw, map_size};
+     return p;
+    }
+
+    void system_deallocate(void* p) {
+     header h = *get_header(p);
+     if (h.map_size)
+      munmap(h.raw, h.map_size);
+     else
+      std::free(h.raw);
+    }
+
+    // ------------------ size classes ----------------------
+
+    constexpr int min_class_log2 = 6; // 64 bytes = alignment
+    constexpr int max_class_log2 = 20;
+    constexpr int n_classes = max_class_log2 - min_class_log2 + 1;
+    static_assert((size_t(1) << max_class_log2) == pooled::max_pooled_size, "Internal error");
+    static_assert((size_t(1) << min_class_log2) == alignment, "Internal error");
+
+    constexpr size_t max_cached_bytes_per_class = size_t(1) << 21;
+    constexpr size_t min_cached_blocks_per_class = 4;
+
+    // the smallest c such that bytes <= 2^(c + min_class_log2)
+    inline int size_class(size_t bytes) {
+     if (bytes <= alignment) return 0;
+     return 64 - __builtin_clzll((unsigned long long)(bytes - 1)) - min_class_log2;
+    }
+
+    inline size_t class_size(int c) { return size_t(1) << (c + min_class_log2); }
+
+    // ------------------ thread local cache ----------------------
+
+    // A freed block stores the next free block of its class in its first bytes
+    struct free_block {
+     free_block* next;
+    };
+
+    struct thread_cache {
+     free_block* head[n_classes] = {};
+     size_t count[n_classes] = {};
+
+     void release() {
+      for (int c = 0; c < n_classes; ++c) {
+       while (head[c]) {
+        free_block* b = head[c];
+        head[c] = b->next;
+        system_deallocate(b);
+       }
+       count[c] = 0;
+      }
+     }
+     ~thread_cache();
+    };
+
+    // The cache is destroyed at the exit of its thread, possibly before some arrays are destroyed
+    // (e.g. the static arrays for the main thread) : their blocks are then returned directly to the system.
+    thread_local bool cache_destroyed = false;
+
+    thread_cache::~thread_cache() {
+     release();
+     cache_destroyed = true;
+    }
+
+    thread_cache* get_cache() {
+     if (cache_destroyed) return nullptr;
+     static thread_local thread_cache cache;
+     return &cache;
+    }
+
+    std::atomic<bool> use_huge_pages{false};
+
+   } // namespace
+
+   // ------------------ aligned ----------------------
+
+   void* aligned::allocate(size_t bytes) { return system_allocate(bytes); }
+
+   void aligned::deallocate(void* p, size_t) {
+    if (p) system_deallocate(p);
+   }
+
+   // ------------------ pooled ----------------------
+
+   void* pooled::allocate(size_t bytes) {
+    if (bytes > max_pooled_size) {
+     TRIQS_POOL_COUNT(n_pool_bypass);
+     if (use_huge_pages && (bytes >= huge_page_min_size)) return system_allocate_huge_pages(bytes);
+     return system_allocate(bytes);
+    }
+    int c = size_class(bytes);
+    thread_cache* cache = get_cache();
+    if (cache && cache->head[c]) {
+     TRIQS_POOL_COUNT(n_pool_hits);
+     free_block* b = cache->head[c];
+     cache->head[c] = b->next;
+     --cache->count[c];
+     return b;
+    }
+    TRIQS_POOL_COUNT(n_pool_misses);
+    return system_allocate(class_size(c));
+   }
+
+   void pooled::deallocate(void* p, size_t bytes) {
+    if (p == nullptr) return;
+    if (bytes > max_pooled_size) {
+     system_deallocate(p);
+     return;
+    }
+    int c = size_class(bytes);
+    thread_cache* cache = get_cache();
+    size_t max_count = std::max(min_cached_blocks_per_class, max_cached_bytes_per_class / class_size(c));
+    if (!cache || cache->count[c] >= max_count) {
+     system_deallocate(p);
+     return;
+    }
+    auto* b = static_cast<free_block*>(p);
+    b->next = cache->head[c];
+    cache->head[c] = b;
+    ++cache->count[c];
+   }
+
+   void pooled::enable_huge_pages(bool b) { use_huge_pages = b; }
+
+   bool pooled::huge_pages_enabled() { return use_huge_pages; }
+
+   void pooled::release_thread_cache() {
+    thread_cache* cache = get_cache();
+    if (cache) cache->release();
+   }
+
+#undef TRIQS_POOL_COUNT
+  }
+ }
+}
+}
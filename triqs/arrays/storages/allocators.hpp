@@ -0,0 +1,81 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstddef>
+
+namespace triqs {
+namespace arrays {
+ namespace storages {
+
+  /**
+   * The allocators of the raw memory of the mem_block.
+   *
+   * An allocator is a class with two static functions
+   *    void * allocate(size_t bytes);            // throws std::bad_alloc on failure
+   *    void deallocate(void * p, size_t bytes);  // bytes : the size given to allocate
+   *
+   * The allocator of mem_block is TRIQS_ARRAYS_ALLOCATOR (by default allocators::aligned).
+   * allocators::pooled is used with the cmake option USE_ARRAYS_POOL.
+   * Like TRIQS_ARRAYS_DEBUG_COUNT_MEMORY, it must be the same for the library and all the codes using it.
+   */
+  namespace allocators {
+
+   /// All the blocks are aligned on this boundary (a cache line, an AVX-512 register)
+   constexpr size_t alignment = 64;
+
+   /// Aligned allocation from the system, without pool
+   struct aligned {
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p, size_t bytes);
+   };
+
+   /**
+    * Aligned allocation with a pool.
+    *
+    *  - The blocks up to max_pooled_size bytes are rounded to a power of 2 (the size class).
+    *    A freed block is kept by the thread which frees it, in a free list of its size class (up to a limit),
+    *    and reused by the next allocation of this size class in this thread.
+    *  - The larger blocks are allocated from the system. If the huge pages are enabled, the blocks of at least
+    *    huge_page_min_size bytes are aligned on the huge page size and advised to use huge pages (Linux only).
+    */
+   struct pooled {
+    static constexpr size_t max_pooled_size = size_t(1) << 20;
+    static constexpr size_t huge_page_size = size_t(1) << 21;
+    static constexpr size_t huge_page_min_size = size_t(1) << 24;
+
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p, size_t bytes);
+
+    /// Enable/disable the huge pages for the large blocks (disabled by default)
+    static void enable_huge_pages(bool b);
+    static bool huge_pages_enabled();
+
+    /// Returns all the blocks kept by the pool of the calling thread to the system
+    static void release_thread_cache();
+   };
+  }
+ }
+}
+}
+
+#ifndef TRIQS_ARRAYS_ALLOCATOR
+#define TRIQS_ARRAYS_ALLOCATOR triqs::arrays::storages::allocators::aligned
+#endif
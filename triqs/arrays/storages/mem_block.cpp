@@ -9,13 +9,23 @@ namespace triqs { namespace arrays { namespace storages {
 
   void term_handler() {
    std::cerr << "[triqs:mem_block] End of program : memory still allocated for triqs::arrays : "
-             << __global_memory_allocated_from_c.count << std::endl <<"   Python initialized : "<< Py_IsInitialized() << std::endl;
+             << __global_memory_allocated_from_c.count << std::endl;
+#ifdef TRIQS_WITH_PYTHON_SUPPORT
+   std::cerr << "   Python initialized : " << Py_IsInitialized() << std::endl;
+#endif
   }
 
   __global_memory_allocated_from_c_t::__global_memory_allocated_from_c_t() {
    std::set_terminate(*term_handler);
   }
 
+  void __global_memory_allocated_from_c_t::print_pool_stats() const {
+   size_t n_pooled = n_pool_hits + n_pool_misses;
+   std::cerr << "[triqs:mem_block] Pool : " << n_pool_hits << " hits / " << n_pooled << " pooled allocations (hit rate "
+             << (n_pooled ? double(n_pool_hits) / n_pooled : 0.0) << "), " << n_pool_bypass << " allocations larger than the pool"
+             << std::endl;
+  }
+
   __global_memory_allocated_from_c_t::~__global_memory_allocated_from_c_t() {
    term_handler();
    if (count != 0) {
@@ -33,9 +33,15 @@ typedef void PyObject;
 #endif
 
 #include "./memcopy.hpp"
+#include "./allocators.hpp"
 #include <triqs/utility/macros.hpp>
+#include <new>
 
 //#define TRIQS_ARRAYS_DEBUG_TRACE_MEM
+#ifdef TRIQS_ARRAYS_DEBUG_COUNT_MEMORY
+#include <atomic>
+#endif
+
 #ifdef TRIQS_ARRAYS_DEBUG_TRACE_MEM
 #include <iostream>
 #define TRACE_MEM_DEBUG(X) std::cerr<< "[triqs:mem_block]"<< X << std::endl;
@@ -83,15 +89,19 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
  // For debug purpose only: a counter of the memory allocated
  struct __global_memory_allocated_from_c_t {
   size_t count = 0;
+  // allocators::pooled : allocations served by the pool, by the system, and larger than the pooled sizes
+  std::atomic<size_t> n_pool_hits{0}, n_pool_misses{0}, n_pool_bypass{0};
   __global_memory_allocated_from_c_t();
   ~__global_memory_allocated_from_c_t();
+  void print_pool_stats() const;
  };
  extern __global_memory_allocated_from_c_t __global_memory_allocated_from_c;
 #define TRIQS_MEMORY_USED_INC(s)                                                                                                 \
  __global_memory_allocated_from_c.count += s;                                                                                    \
  TRACE_MEM_DEBUG("Total memblock allocated from C++ : " << __global_memory_allocated_from_c.count);
 #define TRIQS_PRINT_MEMORY_USED                                                                                                  \
- std::cerr << "[triqs:mem_block]" << triqs::arrays::storages::__global_memory_allocated_from_c.count << std::endl;         
+ std::cerr << "[triqs:mem_block]" << triqs::arrays::storages::__global_memory_allocated_from_c.count << std::endl;          \
+ triqs::arrays::storages::__global_memory_allocated_from_c.print_pool_stats();
  #else
 #define TRIQS_MEMORY_USED_INC(s)
 #define TRIQS_PRINT_MEMORY_USED
@@ -148,6 +158,34 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
   PyObject * py_guard;           // if not null, a BORROWED reference to the guard. If null, the guard does not exist
   static_assert(!std::is_const<ValueType>::value, "internal error");
 
+  using allocator = TRIQS_ARRAYS_ALLOCATOR;
+
+  // Raw allocation, then default initialization of the elements (as new ValueType[s])
+  static ValueType* allocate(size_t s) {
+   auto* r = static_cast<ValueType*>(allocator::allocate(s * sizeof(ValueType)));
+   if (!std::is_trivially_default_constructible<ValueType>::value) {
+    size_t i = 0;
+    try {
+     for (; i < s; ++i) new (r + i) ValueType;
+    } catch (...) {
+     destroy(r, i);
+     allocator::deallocate(r, s * sizeof(ValueType));
+     throw;
+    }
+   }
+   return r;
+  }
+
+  static void destroy(ValueType* r, size_t s) {
+   if (!std::is_trivially_destructible<ValueType>::value)
+    for (size_t i = 0; i < s; ++i) r[i].~ValueType();
+  }
+
+  static void deallocate(ValueType* r, size_t s) {
+   destroy(r, s);
+   allocator::deallocate(r, s * sizeof(ValueType));
+  }
+
 #ifdef TRIQS_WITH_PYTHON_SUPPORT
   static void import_numpy_array() {}// if (_import_array()!=0) TRIQS_RUNTIME_ERROR <<"Internal Error in importing numpy";}
 #endif
@@ -157,7 +195,7 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
 
   // construct to state 1 with a given size.
   mem_block (size_t s):size_(s),py_numpy(nullptr), py_guard(nullptr){
-   try { p = new ValueType[s];}
+   try { p = allocate(s);}
    catch (std::bad_alloc& ba) { TRIQS_RUNTIME_ERROR<< "Memory allocation error in memblock construction. Size :"<<s << "  bad_alloc error : "<< ba.what();}
    TRACE_MEM_DEBUG("Allocating from C++ a block of size "<< s << " at address " <<p);
    TRIQS_MEMORY_USED_INC(s);
@@ -192,7 +230,7 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
     if (p) { // state 2 or state 0
      TRACE_MEM_DEBUG("Desallocating from C++ a block of size " << this->size_ << " at address " << p);
      TRIQS_MEMORY_USED_INC(-size_);
-     delete[] p;
+     deallocate(p, size_);
     }
    }
   }
@@ -216,7 +254,7 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
   // This is a choice, even if X is state 2 (a numpy).
   // We copy a numpy into a regular C++ array, which can then be used at max speed.
   mem_block (mem_block const & X): size_(X.size()), py_numpy(nullptr), py_guard(nullptr) {
-  try { p = new ValueType[X.size()];}
+  try { p = allocate(X.size());}
    catch (std::bad_alloc& ba) { TRIQS_RUNTIME_ERROR<< "Memory allocation error in memblock copy construction. Size :"<<X.size() << "  bad_alloc error : "<< ba.what();}
    TRACE_MEM_DEBUG("Allocating from C++ a block of size "<< X.size() << " at address " <<p);
    TRIQS_MEMORY_USED_INC(X.size());
@@ -304,7 +342,7 @@ namespace triqs { namespace arrays { namespace storages { //namespace details {
     ar >> size_;
     assert (p==nullptr);
     try {
-     p = new ValueType[size_];
+     p = allocate(size_);
     }
     catch (std::bad_alloc& ba) {
      TRIQS_RUNTIME_ERROR << "Memory allocation error in memblock deserialization. Size :" << size_
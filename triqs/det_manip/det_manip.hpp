@@ -23,7 +23,9 @@
 #include <triqs/utility/first_include.hpp>
 #include <vector>
 #include <iterator>
+#include <algorithm>
 #include <numeric>
+#include <random>
 #include <triqs/arrays.hpp>
 #include <triqs/arrays/algorithms.hpp>
 #include <triqs/arrays/linalg/det_and_inverse.hpp>
@@ -51,7 +53,7 @@ namespace triqs { namespace det_manip {
   public:
   using xy_type = typename f_tr::template decay_arg<0>::type;
   using value_type = typename f_tr::result_type;
-  // options the det could be kept in a long double to minimize overflow
+  // the det is kept as a mantissa of type det_type and a binary exponent, to avoid overflow
   //using det_type = std14::conditional_t<std::is_same<value_type, double>::value, long double, std::complex<long double>>;
   using det_type = value_type;
   static_assert(std::is_floating_point<value_type>::value || triqs::is_complex<value_type>::value,
@@ -68,9 +70,10 @@ namespace triqs { namespace det_manip {
     FunctionType f;
 
     // serialized data. There are all VALUES.
-    det_type det;
+    det_type det;    // det = mantissa * 2^det_exp, with |mantissa| in [0.5,1[
+    int det_exp = 0;
     size_t Nmax, N;
-    enum {NoTry, Insert, Remove, ChangeCol, ChangeRow, Insert2 = 10, Remove2 = 11, Refill = 20}
+    enum {NoTry, Insert, Remove, ChangeCol, ChangeRow, Insert2 = 10, Remove2 = 11, InsertK = 12, RemoveK = 13, Refill = 20}
     last_try = NoTry; // keep in memory the last operation not completed
     std::vector<size_t> row_num, col_num;
     std::vector<xy_type> x_values, y_values;
@@ -80,32 +83,66 @@ namespace triqs { namespace det_manip {
     uint64_t n_opts_max_before_check = 100; // max number of ops before the test of deviation of the det, M^-1 is performed.
     double singular_threshold = -1; // the test to see if the matrix is singular is abs(det) > singular_threshold. If <0, it is !isnormal(abs(det))
 
+    // Delayed updates. The true inverse is mat_inv + dU * dV (restricted to the first N rows/cols)
+    // where the pending low rank updates are accumulated in the n_pending first cols of dU and rows of dV.
+    size_t n_delayed = 0;  // number of pending rank 1 updates triggering a flush. 0 : no delay, mat_inv is always up to date.
+    size_t n_pending = 0;  // current number of pending rank 1 updates
+    matrix_type dU, dV;    // Nmax x capacity, capacity x Nmax
+
+   public:
+    /// Statistics of the periodic checks of M^-1
+    struct drift_statistics {
+     uint64_t n_checks = 0;        // number of periodic checks
+     uint64_t n_regenerations = 0; // number of O(N^3) regenerations done by these checks
+     double last_drift = 0;        // last estimated drift, max |M M^-1 v - v| over the probes (only with probes)
+     double max_drift = 0;         // max of the estimated drift
+    };
+
+   protected:
+    // Cheap check of M^-1 with random probe vectors.
+    int n_drift_probes = 0;       // 0 : the periodic check is a full regeneration
+    double drift_threshold = 1.e-8; // above it, M^-1 is regenerated
+    drift_statistics drift_stats;
+    std::mt19937 drift_rng;
+    matrix_type drift_V, drift_W; // the probes v and M^-1 v : N x n_drift_probes
+
    private:
     //  ------------     BOOST Serialization ------------
     //  What about f ? Not serialized at the moment.
     friend class boost::serialization::access;
     template<class Archive>
      void serialize(Archive & ar, const unsigned int version) {
+      flush_delayed_updates();
       ar & TRIQS_MAKE_NVP("Nmax",Nmax) 
        & TRIQS_MAKE_NVP("N",N)
        & TRIQS_MAKE_NVP("n_opts",n_opts) 
        & TRIQS_MAKE_NVP("n_opts_max_before_check",n_opts_max_before_check)
        & TRIQS_MAKE_NVP("singular_threshold",singular_threshold) 
        & TRIQS_MAKE_NVP("det",det) 
+       & TRIQS_MAKE_NVP("det_exp",det_exp)
        & TRIQS_MAKE_NVP("sign",sign)
        & TRIQS_MAKE_NVP("Minv",mat_inv)
        & TRIQS_MAKE_NVP("row_num",row_num) 
        & TRIQS_MAKE_NVP("col_num",col_num)
        & TRIQS_MAKE_NVP("x_values",x_values) 
        & TRIQS_MAKE_NVP("y_values",y_values);
+      _resize_delayed_storage();
      }
 
     /// Write into HDF5
     friend void h5_write (h5::group fg, std::string subgroup_name, det_manip const & g) {
      auto gr =  fg.create_group(subgroup_name);
      h5_write(gr,"N",g.N);
-     h5_write(gr,"mat_inv",g.mat_inv);
+     if (g.n_pending == 0)
+      h5_write(gr,"mat_inv",g.mat_inv);
+     else { // write the true inverse, with the pending updates
+      matrix_type m = g.mat_inv;
+      range R(0, g.N), K(0, g.n_pending);
+      blas::gemm(1.0, g.dU(R, K), g.dV(K, R), 1.0, m(R, R));
+      h5_write(gr,"mat_inv",m);
+     }
      h5_write(gr,"det",g.det);
+     h5_write(gr,"det_exp",g.det_exp);
      h5_write(gr,"sign",g.sign);
      h5_write(gr,"row_num",g.row_num);
      h5_write(gr,"col_num",g.col_num);
@@ -123,7 +160,11 @@ namespace triqs { namespace det_manip {
      h5_read(gr,"mat_inv",g.mat_inv);
      g.Nmax = first_dim(g.mat_inv); // restore Nmax
      g.last_try = NoTry;
+     g._resize_delayed_storage();
      h5_read(gr,"det",g.det);
+     g.det_exp = 0;
+     if (gr.has_key("det_exp")) h5_read(gr,"det_exp",g.det_exp); // old files : det was not scaled
+     g._normalize_det();
      h5_read(gr,"sign",g.sign);
      h5_read(gr,"row_num",g.row_num);
      h5_read(gr,"col_num",g.col_num);
@@ -144,17 +185,101 @@ namespace triqs { namespace det_manip {
      // ksi = newdet/det
      value_type ksi;
      size_t i,j,ireal,jreal;
-     void reserve(size_t s) { B.resize(s); C.resize(s); MB.resize(s); MC.resize(s); MB()=0; MC()=0; }
+     void reserve(size_t s) { B.resize(s); C.resize(s); MB.resize(s); MC.resize(s); }
     };
 
     struct work_data_type2 {
      xy_type x[2], y[2];
      // MB = A^(-1)*B,
      // MC = C*A^(-1)
-     matrix_type MB, MC, B, C, ksi;
+     // ksi_MC = ksi * MC, or ksi * A^(-1)(Rl, R) in remove2
+     matrix_type MB, MC, B, C, ksi, ksi_MC;
      size_t i[2],j[2],ireal[2],jreal[2];
-     void reserve(size_t s) { MB.resize(s,2); MC.resize(2,s); B.resize(s,2), C.resize(2,s); ksi.resize(2,2); MB() = 0; MC() = 0; }
+     void reserve(size_t s) { MB.resize(s,2); MC.resize(2,s); B.resize(s,2), C.resize(2,s); ksi.resize(2,2); ksi_MC.resize(2,s); }
      value_type det_ksi() const { return ksi(0,0) * ksi(1,1) - ksi(1,0)* ksi(0,1);}
+     // ksi <- ksi^(-1), explicitly, without any allocation
+     void invert_ksi() {
+      value_type d = det_ksi(), k00 = ksi(0,0);
+      ksi(0,0) = ksi(1,1) / d;
+      ksi(1,1) = k00 / d;
+      ksi(0,1) = -ksi(0,1) / d;
+      ksi(1,0) = -ksi(1,0) / d;
+     }
+    };
+
+    // work data for insert_k/remove_k. Sized for kmax rows/cols at once.
+    struct work_data_type_k {
+     std::vector<xy_type> x, y;
+     // MB = A^(-1)*B,
+     // MC = C*A^(-1)
+     // ksi = Schur complement, then its inverse. ksi_MC = ksi * MC, or ksi * A^(-1)(Rl, R) in remove_k
+     matrix_type MB, MC, B, C, ksi, ksi_MC;
+     std::vector<size_t> i, j, ireal, jreal, i_moved, j_moved, perm;
+     std::vector<int> piv;
+     size_t k = 0, kmax = 0;
+     void reserve(size_t s, size_t k_max) {
+      kmax = k_max;
+      MB.resize(s, kmax); MC.resize(kmax, s); B.resize(s, kmax); C.resize(kmax, s); ksi.resize(kmax, kmax); ksi_MC.resize(kmax, s);
+      for (auto *v : {&i, &j, &ireal, &jreal, &i_moved, &j_moved, &perm}) v->reserve(kmax);
+      x.reserve(kmax); y.reserve(kmax); piv.resize(kmax);
+     }
+
+     // ksi(Rk,Rk) <- ksi(Rk,Rk)^(-1), in place, without any allocation. Returns the det of ksi.
+     // Gauss-Jordan with partial pivoting. For K>0, the size is known at compile time, n is ignored.
+     template <int K> value_type invert_ksi_impl(int n_dyn) {
+      const int n = (K > 0 ? K : n_dyn);
+      value_type d = 1;
+      for (int c = 0; c < n; ++c) {
+       int p = c;
+       for (int r = c + 1; r < n; ++r)
+        if (std::abs(ksi(r, c)) > std::abs(ksi(p, c))) p = r;
+       piv[c] = p;
+       if (p != c) {
+        for (int l = 0; l < n; ++l) std::swap(ksi(c, l), ksi(p, l));
+        d = -d;
+       }
+       value_type pv = ksi(c, c);
+       d *= pv;
+       if (pv == value_type(0)) return 0; // singular : the move will be rejected
+       ksi(c, c) = 1;
+       for (int l = 0; l < n; ++l) ksi(c, l) /= pv;
+       for (int r = 0; r < n; ++r) {
+        if (r == c) continue;
+        value_type t = ksi(r, c);
+        ksi(r, c) = 0;
+        for (int l = 0; l < n; ++l) ksi(r, l) -= t * ksi(c, l);
+       }
+      }
+      for (int c = n - 1; c >= 0; --c)
+       if (piv[c] != c)
+        for (int r = 0; r < n; ++r) std::swap(ksi(r, c), ksi(r, piv[c]));
+      return d;
+     }
+
+     value_type invert_ksi() {
+      switch (k) {
+       case 1: return invert_ksi_impl<1>(1);
+       case 2: return invert_ksi_impl<2>(2);
+       case 3: return invert_ksi_impl<3>(3);
+       case 4: return invert_ksi_impl<4>(4);
+       default: return invert_ksi_impl<0>(k);
+      }
+     }
+
+     // Sort the positions p (and the values v accordingly) in increasing order, into p_out, v_out
+     template <typename IntContainer, typename ArgumentContainer>
+     void sort_into(IntContainer const &p, ArgumentContainer const &v, std::vector<size_t> &p_out, std::vector<xy_type> &v_out) {
+      perm.resize(k);
+      std::iota(perm.begin(), perm.end(), 0);
+      std::sort(perm.begin(), perm.end(), [&p](size_t a, size_t b) { return p[a] < p[b]; });
+      p_out.clear(); v_out.clear();
+      for (auto a : perm) { p_out.push_back(p[a]); v_out.push_back(v[a]); }
+     }
+     template <typename IntContainer> void sort_into(IntContainer const &p, std::vector<size_t> &p_out) {
+      p_out.clear();
+      for (size_t a = 0; a < k; ++a) p_out.push_back(p[a]);
+      std::sort(p_out.begin(), p_out.end());
+     }
     };
 
     struct work_data_type_refill {
@@ -169,19 +294,25 @@ namespace triqs { namespace det_manip {
 
     work_data_type1 w1;
     work_data_type2 w2;
+    work_data_type_k wk;
     work_data_type_refill w_refill;
+    vector_type dw;      // work data for the delayed updates : capacity
+    matrix_type dWb, dWc; // capacity x max(2,kmax), max(2,kmax) x capacity
     det_type newdet;
+    int newdet_exp; // only for refill : in other cases, newdet has the exponent of det
     int newsign;
 
    private: // for the move constructor, I need to separate the swap since f may not be defaulted constructed
     void swap_but_f (det_manip & rhs) noexcept {
      using std::swap;
 #define SW(a) swap(this->a,rhs.a)
-     SW(det);SW(Nmax);SW(N); SW(last_try);
+     SW(det);SW(det_exp);SW(Nmax);SW(N); SW(last_try);
      SW(row_num); SW(col_num);
      SW(x_values); SW(y_values);
      SW(sign); SW(mat_inv); SW(n_opts); SW(n_opts_max_before_check);
-     SW(w1); SW(w2); SW(newdet); SW(newsign);
+     SW(w1); SW(w2); SW(wk); SW(newdet); SW(newdet_exp); SW(newsign);
+     SW(n_delayed); SW(n_pending); SW(dU); SW(dV); SW(dw); SW(dWb); SW(dWc);
+     SW(n_drift_probes); SW(drift_threshold); SW(drift_stats); SW(drift_rng); SW(drift_V); SW(drift_W);
 #undef SW
     }
 
@@ -200,11 +331,14 @@ namespace triqs { namespace det_manip {
      */
     void reserve (size_t new_size) {
      if (new_size <= Nmax) return;
+     flush_delayed_updates();
      matrix_type Mcopy(mat_inv);
      size_t N0 = Nmax; Nmax = new_size;
      mat_inv.resize(Nmax,Nmax); mat_inv(range(0,N0), range(0,N0)) = Mcopy; // keep the content of mat_inv ---> into the lib ?
      row_num.reserve(Nmax);col_num.reserve(Nmax); x_values.reserve(Nmax);y_values.reserve(Nmax);
      w1.reserve(Nmax); w2.reserve(Nmax);
+     if (wk.kmax) wk.reserve(Nmax, wk.kmax);
+     _resize_delayed_storage();
     }
 
     /// Get the number below which abs(det) is considered 0. If <0, the test will be isnormal(abs(det))
@@ -219,6 +353,53 @@ namespace triqs { namespace det_manip {
     /// Sets the number of operations done before a check in the dets.
     void set_n_operations_before_check(uint64_t n)  { n_opts_max_before_check = n;}
 
+    /**
+     * Sets the number of random probe vectors used by the periodic check of M^-1.
+     *
+     * With n>0, every n_operations_before_check operations, the drift of M^-1 is estimated
+     * as max |M M^-1 v - v| for n random vectors v of +-1, in O(N^2), and M^-1 is regenerated
+     * in O(N^3) only if it is above the drift threshold.
+     * n=0 (default) : the periodic check is a full regeneration, which also checks the det.
+     */
+    void set_n_drift_probes(int n) { n_drift_probes = n;}
+
+    /// Gets the number of random probe vectors of the periodic check of M^-1.
+    int get_n_drift_probes() const { return n_drift_probes;}
+
+    /// Sets the estimated drift above which M^-1 is regenerated. Cf set_n_drift_probes.
+    void set_drift_threshold(double threshold) { drift_threshold = threshold;}
+
+    /// Gets the estimated drift above which M^-1 is regenerated.
+    double get_drift_threshold() const { return drift_threshold;}
+
+    /// Statistics of the periodic checks.
+    drift_statistics const & get_drift_statistics() const { return drift_stats;}
+
+    /// Gets the number of delayed rank 1 updates. 0 means that M^-1 is updated at each complete_operation.
+    size_t get_n_delayed_updates() const { return n_delayed;}
+
+    /**
+     * Sets the number of delayed rank 1 updates.
+     *
+     * If k>0, the updates of M^-1 done by complete_operation are not applied immediately,
+     * but accumulated as low rank factors M^-1 + U V, and the try_xxx are computed with them.
+     * The k pending updates are then flushed into M^-1 in a single gemm.
+     * Insert2/Remove2 count as 2 updates. k=0 (default) : no delay.
+     */
+    void set_n_delayed_updates(size_t k) {
+     flush_delayed_updates();
+     n_delayed = k;
+     _resize_delayed_storage();
+    }
+
+    /// Apply the pending delayed updates to M^-1. No effect if there is none.
+    void flush_delayed_updates() {
+     if (n_pending == 0) return;
+     range R(0, N), K(0, n_pending);
+     blas::gemm(1.0, dU(R, K), dV(K, R), 1.0, mat_inv(R, R));
+     n_pending = 0;
+    }
+
     /**
      * \brief Constructor.
      *
@@ -255,7 +436,7 @@ namespace triqs { namespace det_manip {
 	mat_inv(i,j) = f(x_values[i],y_values[j]);
       }
       range R(0,N);
-      det = arrays::determinant(mat_inv(R,R));
+      det = _scaled_determinant(mat_inv(R,R), det_exp);
       mat_inv(R,R) = inverse(mat_inv(R,R));
      }
 
@@ -267,7 +448,7 @@ namespace triqs { namespace det_manip {
 
     /// Put to size 0 : like a vector
     void clear () {
-     N = 0; sign = 1;det =1; last_try = NoTry;
+     N = 0; sign = 1;det =1; det_exp = 0; last_try = NoTry; n_pending = 0;
      row_num.clear(); col_num.clear(); x_values.clear(); y_values.clear();
     }
 
@@ -285,12 +466,18 @@ namespace triqs { namespace det_manip {
     /// Returns the function f
     FunctionType const & get_function() const { return f;}
 
-    /** det M of the current state of the matrix.  */
-    det_type determinant() const { return sign * det; }
+    /** det M of the current state of the matrix. It may overflow for large N : cf log_abs_determinant */
+    det_type determinant() const { return _ldexp(sign * det, det_exp); }
+
+    /** log |det M|. Does not overflow. */
+    double log_abs_determinant() const { return std::log(std::abs(det)) + det_exp * std::log(2.0); }
+
+    /** det M / |det M|. Does not overflow. */
+    det_type determinant_phase() const { return sign * det / std::abs(det); }
 
     /** Returns M^{-1}(i,j) */
     // warning : need to invert the 2 permutations: (AP)^-1= P^-1 A^-1.
-    value_type inverse_matrix(size_t i,size_t j) const { return mat_inv(col_num[i],row_num[j]);}
+    value_type inverse_matrix(size_t i,size_t j) const { return _minv(col_num[i],row_num[j]);}
 
     /// Returns the inverse matrix. Warning : this is slow, since it create a new copy, and reorder the lines/cols
     matrix_view_type inverse_matrix() const {
@@ -318,9 +505,143 @@ namespace triqs { namespace det_manip {
       //for (size_t j=0; j<d.N;j++)
       // f(d.x_values[i], d.y_values[j], d.mat_inv(j,i));
      range R(0,d.N);
-     foreach(d.mat_inv(R,R), [&f,&d](int i, int j) { return f(d.x_values[i], d.y_values[j], d.mat_inv(j,i));});
+     foreach(d.mat_inv(R,R), [&f,&d](int i, int j) { return f(d.x_values[i], d.y_values[j], d._minv(j,i));});
+    }
+
+   private:
+    // ------------------------- SCALED DETERMINANT -----------------------------------------------
+
+    // x * 2^e
+    template <typename T> static T _ldexp(T x, int e) { return std::ldexp(x, e); }
+    template <typename T> static std::complex<T> _ldexp(std::complex<T> x, int e) {
+     return {std::ldexp(x.real(), e), std::ldexp(x.imag(), e)};
     }
 
+    // x <- x * 2^-e, exp <- exp + e, with e such that the largest of |Re x|, |Im x| is in [0.5,1[
+    static void _normalize(det_type &x, int &exp) {
+     auto a = std::max(std::abs(std::real(x)), std::abs(std::imag(x)));
+     if (!std::isnormal(a)) return; // 0, inf, nan : kept as is, for is_singular
+     int e;
+     std::frexp(a, &e);
+     x = _ldexp(x, -e);
+     exp += e;
+    }
+    void _normalize_det() { _normalize(det, det_exp); }
+
+    // The determinant of M, as mantissa (returned) and exponent, computed from its LU factorization.
+    static det_type _scaled_determinant(matrix_type M, int &exp) {
+     exp = 0;
+     arrays::vector<int> ipiv(first_dim(M));
+     int info = arrays::lapack::getrf(M, ipiv);
+     if (info < 0) TRIQS_RUNTIME_ERROR << "det_manip : failure of getrf lapack routine ";
+     det_type d = 1;
+     for (size_t i = 0; i < first_dim(M); ++i) {
+      d *= M(i, i);
+      if (ipiv(i) != int(i) + 1) d = -d;
+      _normalize(d, exp);
+     }
+     return d;
+    }
+
+    // ------------------------- DELAYED UPDATES -----------------------------------------------
+
+    size_t _delay_capacity() const { return std::max(n_delayed, size_t(2)); }
+
+    void _resize_delayed_storage() {
+     n_pending = 0;
+     if (n_delayed == 0) { dU = matrix_type{}; dV = matrix_type{}; return;}
+     auto c = _delay_capacity();
+     dU.resize(Nmax, c); dV.resize(c, Nmax); dw.resize(c);
+     _resize_delayed_work_matrices();
+    }
+
+    void _resize_delayed_work_matrices() {
+     auto c = _delay_capacity(), m = std::max(wk.kmax, size_t(2));
+     dWb.resize(c, m); dWc.resize(m, c);
+    }
+
+    // Element (i,j) of the true inverse
+    value_type _minv(size_t i, size_t j) const {
+     value_type r = mat_inv(i, j);
+     for (size_t k = 0; k < n_pending; ++k) r += dU(i, k) * dV(k, j);
+     return r;
+    }
+
+    // Y = Minv(R,R) * X, with the pending updates
+    template <typename VT1, typename VT2> void _minv_gemv(range R, VT1 const &X, VT2 &&Y) {
+     blas::gemv(1.0, mat_inv(R, R), X, 0.0, Y);
+     if (n_pending == 0) return;
+     range K(0, n_pending);
+     blas::gemv(1.0, dV(K, R), X, 0.0, dw(K));
+     blas::gemv(1.0, dU(R, K), dw(K), 1.0, Y);
+    }
+
+    // Y = Minv(R,R)^T * X, with the pending updates
+    template <typename VT1, typename VT2> void _minv_t_gemv(range R, VT1 const &X, VT2 &&Y) {
+     blas::gemv(1.0, mat_inv(R, R).transpose(), X, 0.0, Y);
+     if (n_pending == 0) return;
+     range K(0, n_pending);
+     blas::gemv(1.0, dU(R, K).transpose(), X, 0.0, dw(K));
+     blas::gemv(1.0, dV(K, R).transpose(), dw(K), 1.0, Y);
+    }
+
+    // Y = Minv(R,R) * X, for X a N x m matrix, m <= max(2,kmax)
+    template <typename MT1, typename MT2> void _minv_gemm(range R, MT1 const &X, MT2 &&Y) {
+     blas::gemm(1.0, mat_inv(R, R), X, 0.0, Y);
+     if (n_pending == 0) return;
+     range K(0, n_pending), Rm(0, second_dim(X));
+     blas::gemm(1.0, dV(K, R), X, 0.0, dWb(K, Rm));
+     blas::gemm(1.0, dU(R, K), dWb(K, Rm), 1.0, Y);
+    }
+
+    // Y = X * Minv(R,R), for X a m x N matrix, m <= max(2,kmax)
+    template <typename MT1, typename MT2> void _gemm_minv(range R, MT1 const &X, MT2 &&Y) {
+     blas::gemm(1.0, X, mat_inv(R, R), 0.0, Y);
+     if (n_pending == 0) return;
+     range K(0, n_pending), Rm(0, first_dim(X));
+     blas::gemm(1.0, X, dU(R, K), 0.0, dWc(Rm, K));
+     blas::gemm(1.0, dWc(Rm, K), dV(K, R), 1.0, Y);
+    }
+
+    // Y = Minv(R, j), resp. Minv(i, R), with the pending updates
+    template <typename VT> void _minv_col(range R, size_t j, VT &&Y) {
+     Y = mat_inv(R, j);
+     if (n_pending == 0) return;
+     range K(0, n_pending);
+     blas::gemv(1.0, dU(R, K), dV(K, j), 1.0, Y);
+    }
+    template <typename VT> void _minv_row(range R, size_t i, VT &&Y) {
+     Y = mat_inv(i, R);
+     if (n_pending == 0) return;
+     range K(0, n_pending);
+     blas::gemv(1.0, dV(K, R).transpose(), dU(i, K), 1.0, Y);
+    }
+
+    // Make room for m new pending updates. To be called before the change of N.
+    void _prepare_delayed_updates(size_t m) {
+     if (n_pending + m > _delay_capacity()) flush_delayed_updates();
+    }
+
+    // The m new pending updates have been written in dU, dV. Flush if the queue is full.
+    void _commit_delayed_updates(size_t m) {
+     n_pending += m;
+     if (n_pending >= n_delayed) flush_delayed_updates();
+    }
+
+    // Swap rows i, j of the true inverse, resp. cols
+    void _swap_rows(size_t i, size_t j) {
+     range R(0, N);
+     arrays::deep_swap(mat_inv(i, R), mat_inv(j, R));
+     if (n_pending) { range K(0, n_pending); arrays::deep_swap(dU(i, K), dU(j, K)); }
+    }
+    void _swap_cols(size_t i, size_t j) {
+     range R(0, N);
+     arrays::deep_swap(mat_inv(R, i), mat_inv(R, j));
+     if (n_pending) { range K(0, n_pending); arrays::deep_swap(dV(K, i), dV(K, j)); }
+    }
+
+   public:
+
     // ------------------------- OPERATIONS -----------------------------------------------
 
     /**
@@ -364,7 +685,7 @@ namespace triqs { namespace det_manip {
      }
      range R(0,N);
      //w1.MB(R) = mat_inv(R,R) * w1.B(R);// OPTIMIZE BELOW
-     blas::gemv(1.0, mat_inv(R,R), w1.B(R),0.0,w1.MB(R));
+     _minv_gemv(R, w1.B(R), w1.MB(R));
      w1.ksi = f(x,y) - arrays::dot( w1.C(R) , w1.MB(R) );
      newdet = det*w1.ksi;
      newsign = ((i + j)%2==0 ? sign : -sign);   // since N-i0 + N-j0  = i0+j0 [2]
@@ -392,7 +713,7 @@ namespace triqs { namespace det_manip {
      }
      range R(0,N);
      //w1.MB(R) = mat_inv(R,R) * w1.B(R);// OPTIMIZE BELOW
-     blas::gemv(1.0, mat_inv(R,R), w1.B(R),0.0,w1.MB(R));
+     _minv_gemv(R, w1.B(R), w1.MB(R));
      w1.ksi = ksi - arrays::dot( w1.C(R) , w1.MB(R) );
      newdet = det*w1.ksi;
      newsign = ((i + j)%2==0 ? sign : -sign);   // since N-i0 + N-j0  = i0+j0 [2]
@@ -412,7 +733,7 @@ namespace triqs { namespace det_manip {
 
      range R1(0,N);
      //w1.MC(R1) = mat_inv(R1,R1).transpose() * w1.C(R1); //OPTIMIZE BELOW
-     blas::gemv(1.0, mat_inv(R1,R1).transpose(), w1.C(R1),0.0,w1.MC(R1));
+     _minv_t_gemv(R1, w1.C(R1), w1.MC(R1));
      w1.MC(N) = -1;
      w1.MB(N) = -1;
 
@@ -435,8 +756,17 @@ namespace triqs { namespace det_manip {
      range R(0,N);
      mat_inv(R,N-1) = 0;
      mat_inv(N-1,R) = 0;
-     //mat_inv(R,R) += w1.ksi* w1.MB(R) * w1.MC(R)// OPTIMIZE BELOW
-     blas::ger(w1.ksi, w1.MB(R) ,w1.MC(R),mat_inv(R,R));
+     if (n_delayed == 0) {
+      //mat_inv(R,R) += w1.ksi* w1.MB(R) * w1.MC(R)// OPTIMIZE BELOW
+      blas::ger(w1.ksi, w1.MB(R) ,w1.MC(R),mat_inv(R,R));
+      return;
+     }
+     // the pending updates do not act on the new row/col. Then it is safe to flush.
+     if (n_pending) { range K(0, n_pending); dU(N-1,K) = 0; dV(K,N-1) = 0; }
+     _prepare_delayed_updates(1);
+     dU(R, n_pending) = w1.MB(R);
+     dV(n_pending, R) = w1.ksi * w1.MC(R);
+     _commit_delayed_updates(1);
     }
 
    public :
@@ -503,7 +833,7 @@ namespace triqs { namespace det_manip {
      }
      range R(0,N), R2(0,2);
      //w2.MB(R,R2) = mat_inv(R,R) * w2.B(R,R2); // OPTIMIZE BELOW
-     blas::gemm(1.0, mat_inv(R,R) , w2.B(R,R2),0.0,w2.MB(R,R2));
+     _minv_gemm(R, w2.B(R,R2), w2.MB(R,R2));
      //w2.ksi -= w2.C (R2, R) * w2.MB(R, R2); // OPTIMIZE BELOW
      blas::gemm(-1.0, w2.C(R2,R), w2.MB(R, R2),1.0,w2.ksi);
      auto ksi = w2.det_ksi();
@@ -527,7 +857,8 @@ namespace triqs { namespace det_manip {
      // treat empty matrix separately
      if (N==0) {
        N=2;
-       mat_inv(R2,R2)=inverse(w2.ksi);
+       w2.invert_ksi();
+       mat_inv(R2,R2) = w2.ksi;
        row_num[w2.i[1]]=1;
        col_num[w2.j[1]]=1;
        return;
@@ -535,7 +866,7 @@ namespace triqs { namespace det_manip {
 
      range Ri(0,N);
      //w2.MC(R2,Ri) = w2.C(R2,Ri) * mat_inv(Ri,Ri);// OPTIMIZE BELOW
-     blas::gemm(1.0, w2.C(R2,Ri), mat_inv(Ri,Ri),0.0,w2.MC(R2,Ri));
+     _gemm_minv(Ri, w2.C(R2,Ri), w2.MC(R2,Ri));
      w2.MC(R2, range(N, N+2) ) = -1; // -identity matrix
      w2.MB(range(N,N+2), R2 ) = -1; // -identity matrix !
 
@@ -550,13 +881,22 @@ namespace triqs { namespace det_manip {
       for (int_type i =N-2; i>=int_type(w2.j[k]); i--) col_num[i+1]= col_num[i];
       col_num[w2.j[k]] = N-1;
      }
-     w2.ksi = inverse (w2.ksi);
+     w2.invert_ksi();
      range R(0,N);
      mat_inv(R,range(N-2,N)) = 0;
      mat_inv(range(N-2,N),R) = 0;
-     //mat_inv(R,R) += w2.MB(R,R2) * (w2.ksi * w2.MC(R2,R)); // OPTIMIZE BELOW
-     blas::gemm(1.0, w2.MB(R,R2), (w2.ksi * w2.MC(R2,R)),1.0,mat_inv(R,R) );
-
+     if (n_delayed == 0) {
+      //mat_inv(R,R) += w2.MB(R,R2) * (w2.ksi * w2.MC(R2,R)); // OPTIMIZE BELOW
+      blas::gemm(1.0, w2.ksi, w2.MC(R2,R), 0.0, w2.ksi_MC(R2,R));
+      blas::gemm(1.0, w2.MB(R,R2), w2.ksi_MC(R2,R), 1.0, mat_inv(R,R));
+      return;
+     }
+     if (n_pending) { range K(0, n_pending); dU(range(N-2,N),K) = 0; dV(K,range(N-2,N)) = 0; }
+     _prepare_delayed_updates(2);
+     range P(n_pending, n_pending + 2);
+     dU(R, P) = w2.MB(R,R2);
+     blas::gemm(1.0, w2.ksi, w2.MC(R2,R), 0.0, dV(P, R));
+     _commit_delayed_updates(2);
     }
 
    public:
@@ -576,7 +916,7 @@ namespace triqs { namespace det_manip {
      // compute the newdet
      // first we resolve the w1.ireal,w1.jreal, with the permutation of the Minv, then we pick up what
      // will become the 'corner' coefficient, if the move is accepted, after the exchange of row and col.
-     w1.ksi = mat_inv(w1.jreal,w1.ireal);
+     w1.ksi = _minv(w1.jreal,w1.ireal);
      auto ksi = w1.ksi;
      newdet = det*ksi;
      newsign = ((i + j)%2==0 ? sign : -sign);
@@ -590,27 +930,32 @@ namespace triqs { namespace det_manip {
      // repack the matrix inv_mat
      // swap the rows w1.ireal and N, w1.jreal and N in inv_mat
      // Remember that for M row/col is interchanged by inversion, transposition.
-     {
-      range R(0,N);
-      if (w1.jreal !=N-1){
-       arrays::deep_swap( mat_inv(w1.jreal,R), mat_inv(N-1,R));
-       y_values[w1.jreal] = y_values[N-1];
-      }
+     if (w1.jreal !=N-1){
+      _swap_rows(w1.jreal, N-1);
+      y_values[w1.jreal] = y_values[N-1];
+     }
 
-      if (w1.ireal !=N-1){
-       arrays::deep_swap (mat_inv(R,w1.ireal),  mat_inv(R,N-1));
-       x_values[w1.ireal] = x_values[N-1];
-      }
+     if (w1.ireal !=N-1){
+      _swap_cols(w1.ireal, N-1);
+      x_values[w1.ireal] = x_values[N-1];
      }
 
+     if (n_delayed) _prepare_delayed_updates(1);
      N--;
 
      // M <- a - d^-1 b c with BLAS
-     w1.ksi = - 1/mat_inv(N,N);
+     w1.ksi = - 1/_minv(N,N);
      range R(0,N);
 
-     //mat_inv(R,R) += w1.ksi, * mat_inv(R,N) * mat_inv(N,R);
-     blas::ger(w1.ksi,mat_inv(R,N),mat_inv(N,R), mat_inv(R,R));
+     if (n_delayed == 0) {
+      //mat_inv(R,R) += w1.ksi, * mat_inv(R,N) * mat_inv(N,R);
+      blas::ger(w1.ksi,mat_inv(R,N),mat_inv(N,R), mat_inv(R,R));
+     } else {
+      _minv_col(R, N, dU(R, n_pending));
+      _minv_row(R, N, dV(n_pending, R));
+      dU(R, n_pending) *= w1.ksi;
+      _commit_delayed_updates(1);
+     }
 
      // modify the permutations
      for (size_t k =w1.i; k<N; k++) {row_num[k]= row_num[k+1];}
@@ -655,10 +1000,10 @@ namespace triqs { namespace det_manip {
      w2.jreal[1] = col_num[w2.j[1]];
 
      // compute the newdet
-     w2.ksi(0,0) = mat_inv(w2.jreal[0],w2.ireal[0]);
-     w2.ksi(1,0) = mat_inv(w2.jreal[1],w2.ireal[0]);
-     w2.ksi(0,1) = mat_inv(w2.jreal[0],w2.ireal[1]);
-     w2.ksi(1,1) = mat_inv(w2.jreal[1],w2.ireal[1]);
+     w2.ksi(0,0) = _minv(w2.jreal[0],w2.ireal[0]);
+     w2.ksi(1,0) = _minv(w2.jreal[1],w2.ireal[0]);
+     w2.ksi(0,1) = _minv(w2.jreal[0],w2.ireal[1]);
+     w2.ksi(1,1) = _minv(w2.jreal[1],w2.ireal[1]);
      auto ksi = w2.det_ksi();
      newdet = det * ksi;
      newsign = ((i0 + j0+ i1 + j1)%2==0 ? sign : -sign);
@@ -675,36 +1020,50 @@ namespace triqs { namespace det_manip {
      size_t j_real_max =std::max(w2.jreal[0],w2.jreal[1]);
      size_t j_real_min =std::min(w2.jreal[0],w2.jreal[1]);
 
-     range R(0,N);
-
      if (j_real_max != N-1) {
-      arrays::deep_swap( mat_inv(j_real_max,R), mat_inv(N-1,R));
+      _swap_rows(j_real_max, N-1);
       y_values[ j_real_max ] = y_values[N-1];
      }
      if (j_real_min != N-2) {
-      arrays::deep_swap( mat_inv(j_real_min,R), mat_inv(N-2,R));
+      _swap_rows(j_real_min, N-2);
       y_values[ j_real_min ] = y_values[N-2];
      }
      if (i_real_max != N-1) {
-      arrays::deep_swap (mat_inv(R,i_real_max),  mat_inv(R,N-1));
+      _swap_cols(i_real_max, N-1);
       x_values[ i_real_max ] = x_values[N-1];
      }
      if (i_real_min != N-2) {
-      arrays::deep_swap (mat_inv(R,i_real_min),  mat_inv(R,N-2));
+      _swap_cols(i_real_min, N-2);
       x_values[ i_real_min ] = x_values[N-2];
      }
 
+     if (n_delayed) _prepare_delayed_updates(2);
      N -= 2;
 
      // M <- a - d^-1 b c with BLAS
      range Rn(0,N), Rl(N,N+2);
-     //w2.ksi = mat_inv(Rl,Rl);
-     //w2.ksi = inverse( w2.ksi);
-     w2.ksi =  inverse( mat_inv(Rl,Rl));
-
-     // write explicitely the second product on ksi for speed ?
-     //mat_inv(Rn,Rn) -= mat_inv(Rn,Rl) * (w2.ksi * mat_inv(Rl,Rn)); // OPTIMIZE BELOW
-     blas::gemm(-1.0, mat_inv(Rn,Rl), w2.ksi * mat_inv(Rl,Rn),1.0,  mat_inv(Rn,Rn) );
+     if (n_delayed == 0) {
+      w2.ksi = mat_inv(Rl,Rl);
+      w2.invert_ksi();
+
+      //mat_inv(Rn,Rn) -= mat_inv(Rn,Rl) * (w2.ksi * mat_inv(Rl,Rn)); // OPTIMIZE BELOW
+      range R2(0,2);
+      blas::gemm(1.0, w2.ksi, mat_inv(Rl,Rn), 0.0, w2.ksi_MC(R2,Rn));
+      blas::gemm(-1.0, mat_inv(Rn,Rl), w2.ksi_MC(R2,Rn), 1.0, mat_inv(Rn,Rn));
+     } else {
+      for (int a = 0; a < 2; ++a)
+       for (int b = 0; b < 2; ++b) w2.ksi(a, b) = _minv(N + a, N + b);
+      w2.invert_ksi();
+      // dU = - Minv(Rn,Rl), dV = ksi * Minv(Rl,Rn). w2.MC is used as a temporary for Minv(Rl,Rn).
+      for (int a = 0; a < 2; ++a) {
+       _minv_col(Rn, N + a, dU(Rn, n_pending + a));
+       _minv_row(Rn, N + a, w2.MC(a, Rn));
+      }
+      range P(n_pending, n_pending + 2);
+      dU(Rn, P) *= -1;
+      blas::gemm(1.0, w2.ksi, w2.MC(range(0,2), Rn), 0.0, dV(P, Rn));
+      _commit_delayed_updates(2);
+     }
 
      // modify the permutations
      for (size_t k =w2.i[0]; k<w2.i[1]-1; k++)   row_num[k] = row_num[k+1];
@@ -725,6 +1084,247 @@ namespace triqs { namespace det_manip {
        y_values.pop_back();
      }
     }
+    //------------------------------------------------------------------------------------------
+   private:
+    // Check the k positions, and size the work data for k.
+    template <typename IntContainer> void _prepare_k(IntContainer const &i, IntContainer const &j) {
+     TRIQS_ASSERT(i.size() == j.size());
+     size_t k = i.size();
+     TRIQS_ASSERT(k > 0);
+     if (N + k > Nmax) reserve(std::max(2 * Nmax, N + k));
+     if (k > wk.kmax) {
+      wk.reserve(Nmax, k);
+      if (n_delayed) _resize_delayed_work_matrices();
+     }
+     wk.k = k;
+    }
+
+   public:
+    //------------------------------------------------------------------------------------------
+
+    /**
+     * Insertion of k rows and k cols at once.
+     *
+     * The new rows (resp. cols) will be at positions i[a] (resp. j[a]) of the new matrix,
+     * with values x[a] (resp. y[a]). The i (resp. j) must be distinct and < N + k.
+     * For k = 1, 2, try_insert and try_insert2 are faster.
+     *
+     * Returns the ratio of det Minv_new / det Minv.
+     * This routine does NOT make any modification. It has to be completed with complete_operation().
+     */
+    template <typename IntContainer, typename ArgumentContainer1, typename ArgumentContainer2>
+    value_type try_insert_k(IntContainer const &i, IntContainer const &j, ArgumentContainer1 const &x, ArgumentContainer2 const &y) {
+     TRIQS_ASSERT(x.size() == i.size()); TRIQS_ASSERT(y.size() == j.size());
+     _prepare_k(i, j);
+     last_try = InsertK;
+     size_t k = wk.k;
+     wk.sort_into(i, x, wk.i, wk.x);
+     wk.sort_into(j, y, wk.j, wk.y);
+     for (size_t a = 0; a < k; ++a) {
+      TRIQS_ASSERT(wk.i[a] < N + k); TRIQS_ASSERT(wk.j[a] < N + k);
+      if (a > 0) { TRIQS_ASSERT(wk.i[a] != wk.i[a - 1]); TRIQS_ASSERT(wk.j[a] != wk.j[a - 1]); }
+     }
+
+     // ksi = Delta(x,y) - C * Minv * B : the Schur complement of the new block
+     for (size_t a = 0; a < k; ++a)
+      for (size_t b = 0; b < k; ++b) wk.ksi(a, b) = f(wk.x[a], wk.y[b]);
+
+     // I add the rows and cols and the end. If the move is rejected,
+     // no effect since N will not be changed : inv_mat(i,j) for i,j>=N has no meaning.
+     if (N > 0) {
+      for (size_t p = 0; p < N; p++)
+       for (size_t a = 0; a < k; ++a) {
+        wk.B(p, a) = f(x_values[p], wk.y[a]);
+        wk.C(a, p) = f(wk.x[a], y_values[p]);
+       }
+      range R(0, N), Rk(0, k);
+      _minv_gemm(R, wk.B(R, Rk), wk.MB(R, Rk));
+      blas::gemm(-1.0, wk.C(Rk, R), wk.MB(R, Rk), 1.0, wk.ksi(Rk, Rk));
+     }
+
+     // the inverse of ksi is kept for complete_insert_k
+     auto ksi = wk.invert_ksi();
+     newdet = det * ksi;
+     size_t s = 0;
+     for (size_t a = 0; a < k; ++a) s += wk.i[a] + wk.j[a];
+     newsign = (s % 2 == 0 ? sign : -sign); // as for insert2, moving the new rows/cols from the end to their place
+     return ksi * (newsign * sign);       // sign is unity, hence 1/sign == sign
+    }
+
+    //------------------------------------------------------------------------------------------
+   private:
+    void complete_insert_k() {
+     size_t k = wk.k;
+     for (size_t a = 0; a < k; ++a) {
+      x_values.push_back(wk.x[a]);
+      y_values.push_back(wk.y[a]);
+      row_num.push_back(0);
+      col_num.push_back(0);
+     }
+
+     range Rk(0, k);
+     // treat empty matrix separately : then i[a] = j[a] = a
+     if (N == 0) {
+      N = k;
+      mat_inv(Rk, Rk) = wk.ksi(Rk, Rk);
+      std::iota(row_num.begin(), row_num.end(), 0);
+      std::iota(col_num.begin(), col_num.end(), 0);
+      return;
+     }
+
+     bool delayed = (n_delayed != 0) && (k <= _delay_capacity());
+     if (!delayed) flush_delayed_updates(); // too many cols to be delayed
+
+     range Ri(0, N), Rl(N, N + k);
+     _gemm_minv(Ri, wk.C(Rk, Ri), wk.MC(Rk, Ri));
+     wk.MC(Rk, Rl) = -1; // -identity matrix
+     wk.MB(Rl, Rk) = -1; // -identity matrix !
+
+     // keep the real position of the row/col, as in complete_insert2
+     for (size_t a = 0; a < k; ++a) {
+      N++;
+      for (int_type i = N - 2; i >= int_type(wk.i[a]); i--) row_num[i + 1] = row_num[i];
+      row_num[wk.i[a]] = N - 1;
+      for (int_type i = N - 2; i >= int_type(wk.j[a]); i--) col_num[i + 1] = col_num[i];
+      col_num[wk.j[a]] = N - 1;
+     }
+     range R(0, N);
+     mat_inv(R, Rl) = 0;
+     mat_inv(Rl, R) = 0;
+     if (!delayed) {
+      //mat_inv(R,R) += wk.MB(R,Rk) * (wk.ksi * wk.MC(Rk,R)); // OPTIMIZE BELOW
+      blas::gemm(1.0, wk.ksi(Rk, Rk), wk.MC(Rk, R), 0.0, wk.ksi_MC(Rk, R));
+      blas::gemm(1.0, wk.MB(R, Rk), wk.ksi_MC(Rk, R), 1.0, mat_inv(R, R));
+      return;
+     }
+     if (n_pending) { range K(0, n_pending); dU(Rl, K) = 0; dV(K, Rl) = 0; }
+     _prepare_delayed_updates(k);
+     range P(n_pending, n_pending + k);
+     dU(R, P) = wk.MB(R, Rk);
+     blas::gemm(1.0, wk.ksi(Rk, Rk), wk.MC(Rk, R), 0.0, dV(P, R));
+     _commit_delayed_updates(k);
+    }
+
+   public:
+    //------------------------------------------------------------------------------------------
+
+    /**
+     * Removal of k rows i[a] and k cols j[a] at once.
+     *
+     * The i (resp. j) must be distinct and < N.
+     * For k = 1, 2, try_remove and try_remove2 are faster.
+     *
+     * Returns the ratio of det Minv_new / det Minv.
+     * This routine does NOT make any modification. It has to be completed with complete_operation().
+     */
+    template <typename IntContainer> value_type try_remove_k(IntContainer const &i, IntContainer const &j) {
+     TRIQS_ASSERT(i.size() <= N);
+     _prepare_k(i, j);
+     last_try = RemoveK;
+     size_t k = wk.k;
+     wk.sort_into(i, wk.i);
+     wk.sort_into(j, wk.j);
+     wk.ireal.clear(); wk.jreal.clear();
+     for (size_t a = 0; a < k; ++a) {
+      TRIQS_ASSERT(wk.i[a] < N); TRIQS_ASSERT(wk.j[a] < N);
+      if (a > 0) { TRIQS_ASSERT(wk.i[a] != wk.i[a - 1]); TRIQS_ASSERT(wk.j[a] != wk.j[a - 1]); }
+      wk.ireal.push_back(row_num[wk.i[a]]);
+      wk.jreal.push_back(col_num[wk.j[a]]);
+     }
+
+     // the new det is the det of the block of Minv of the removed cols/rows
+     for (size_t a = 0; a < k; ++a)
+      for (size_t b = 0; b < k; ++b) wk.ksi(a, b) = _minv(wk.jreal[a], wk.ireal[b]);
+     auto ksi = wk.invert_ksi();
+     newdet = det * ksi;
+     size_t s = 0;
+     for (size_t a = 0; a < k; ++a) s += wk.i[a] + wk.j[a];
+     newsign = (s % 2 == 0 ? sign : -sign);
+     return ksi * (newsign * sign); // sign is unity, hence 1/sign == sign
+    }
+
+    //------------------------------------------------------------------------------------------
+   private:
+    // r are the real positions to be removed. On return, r contains only those below N-k (the holes),
+    // in increasing order, and moved the kept positions >= N-k, which are to be moved into the holes.
+    void _holes_and_moves(std::vector<size_t> &r, std::vector<size_t> &moved) {
+     std::sort(r.begin(), r.end());
+     moved.clear();
+     for (size_t p = N - wk.k; p < N; ++p)
+      if (!std::binary_search(r.begin(), r.end(), p)) moved.push_back(p);
+     r.resize(moved.size());
+    }
+
+    void complete_remove_k() {
+     size_t k = wk.k;
+     if (N == k) { clear(); return; }
+
+     bool delayed = (n_delayed != 0) && (k <= _delay_capacity());
+     if (!delayed) flush_delayed_updates(); // too many cols to be delayed
+
+     // Move the rows/cols to be removed to the last k positions of mat_inv.
+     // Remember that for M row/col is interchanged by inversion, transposition.
+     _holes_and_moves(wk.jreal, wk.j_moved);
+     for (size_t a = 0; a < wk.jreal.size(); ++a) {
+      _swap_rows(wk.jreal[a], wk.j_moved[a]);
+      y_values[wk.jreal[a]] = y_values[wk.j_moved[a]];
+     }
+     _holes_and_moves(wk.ireal, wk.i_moved);
+     for (size_t a = 0; a < wk.ireal.size(); ++a) {
+      _swap_cols(wk.ireal[a], wk.i_moved[a]);
+      x_values[wk.ireal[a]] = x_values[wk.i_moved[a]];
+     }
+
+     if (delayed) _prepare_delayed_updates(k);
+     N -= k;
+
+     // M <- a - d^-1 b c with BLAS
+     range Rn(0, N), Rl(N, N + k), Rk(0, k);
+     if (!delayed) {
+      wk.ksi(Rk, Rk) = mat_inv(Rl, Rl);
+      wk.invert_ksi();
+      //mat_inv(Rn,Rn) -= mat_inv(Rn,Rl) * (wk.ksi * mat_inv(Rl,Rn)); // OPTIMIZE BELOW
+      blas::gemm(1.0, wk.ksi(Rk, Rk), mat_inv(Rl, Rn), 0.0, wk.ksi_MC(Rk, Rn));
+      blas::gemm(-1.0, mat_inv(Rn, Rl), wk.ksi_MC(Rk, Rn), 1.0, mat_inv(Rn, Rn));
+     } else {
+      for (size_t a = 0; a < k; ++a)
+       for (size_t b = 0; b < k; ++b) wk.ksi(a, b) = _minv(N + a, N + b);
+      wk.invert_ksi();
+      // dU = - Minv(Rn,Rl), dV = ksi * Minv(Rl,Rn). wk.MC is used as a temporary for Minv(Rl,Rn).
+      for (size_t a = 0; a < k; ++a) {
+       _minv_col(Rn, N + a, dU(Rn, n_pending + a));
+       _minv_row(Rn, N + a, wk.MC(a, Rn));
+      }
+      range P(n_pending, n_pending + k);
+      dU(Rn, P) *= -1;
+      blas::gemm(1.0, wk.ksi(Rk, Rk), wk.MC(Rk, Rn), 0.0, dV(P, Rn));
+      _commit_delayed_updates(k);
+     }
+
+     // modify the permutations : drop the positions i[a], j[a] (sorted)
+     // and relabel the moved real positions into their holes
+     auto drop = [k, this](std::vector<size_t> &num, std::vector<size_t> const &pos, std::vector<size_t> const &holes,
+                           std::vector<size_t> const &moved) {
+      size_t a = 0, q = 0;
+      for (size_t p = 0; p < N + k; ++p) {
+       if (a < k && pos[a] == p) { ++a; continue; }
+       num[q++] = num[p];
+      }
+      for (size_t p = 0; p < N; ++p)
+       for (size_t b = 0; b < moved.size(); ++b)
+        if (num[p] == moved[b]) { num[p] = holes[b]; break; }
+     };
+     drop(row_num, wk.i, wk.ireal, wk.i_moved);
+     drop(col_num, wk.j, wk.jreal, wk.j_moved);
+
+     for (size_t u = 0; u < k; ++u) {
+      row_num.pop_back();
+      col_num.pop_back();
+      x_values.pop_back();
+      y_values.pop_back();
+     }
+    }
+
     //------------------------------------------------------------------------------------------
    public:
 
@@ -745,7 +1345,7 @@ namespace triqs { namespace det_manip {
      for (size_t i= 0; i<N;i++) w1.MC(i) = f(x_values[i] , w1.y) - f(x_values[i], y_values[w1.jreal]);
      range R(0,N);
      //w1.MB(R) = mat_inv(R,R) * w1.MC(R);// OPTIMIZE BELOW
-     blas::gemv(1.0, mat_inv(R,R), w1.MC(R) ,0.0,  w1.MB(R) );
+     _minv_gemv(R, w1.MC(R), w1.MB(R));
 
      // compute the newdet
      w1.ksi = (1+w1.MB(w1.jreal));
@@ -760,6 +1360,14 @@ namespace triqs { namespace det_manip {
      range R(0,N);
      y_values[w1.jreal] = w1.y;
 
+     if (n_delayed) { // pure Sherman Morrison : M += (-1/ksi) * MB * M(jreal, R)
+      _prepare_delayed_updates(1);
+      dU(R, n_pending) = (-1 / w1.ksi) * w1.MB(R);
+      _minv_row(R, w1.jreal, dV(n_pending, R));
+      _commit_delayed_updates(1);
+      return;
+     }
+
      // modifying M : Mij += w1.ksi Bi Mnj
      // using Shermann Morrison formula.
      // implemented in 2 times : first Bn=0 so that Mnj is not modified ! and then change Mnj
@@ -791,7 +1399,7 @@ namespace triqs { namespace det_manip {
      for (size_t i= 0; i<N;i++) w1.MB(i) = f(w1.x, y_values[i] ) -  f(x_values[w1.ireal], y_values[i] );
      range R(0,N);
      //w1.MC(R) = mat_inv(R,R).transpose() * w1.MB(R); // OPTIMIZE BELOW
-     blas::gemv(1.0, mat_inv(R,R).transpose(), w1.MB(R),0.0,  w1.MC(R));
+     _minv_t_gemv(R, w1.MB(R), w1.MC(R));
 
      // compute the newdet
      w1.ksi = (1+w1.MC(w1.ireal));
@@ -806,6 +1414,14 @@ namespace triqs { namespace det_manip {
      range R(0,N);
      x_values[w1.ireal] = w1.x;
 
+     if (n_delayed) { // pure Sherman Morrison : M += (-1/ksi) * M(R, ireal) * MC
+      _prepare_delayed_updates(1);
+      _minv_col(R, w1.ireal, dU(R, n_pending));
+      dV(n_pending, R) = (-1 / w1.ksi) * w1.MC(R);
+      _commit_delayed_updates(1);
+      return;
+     }
+
      // modifying M : M ij += w1.ksi Min Cj
      // using Shermann Morrison formula.
      // impl. Cf case 3
@@ -838,7 +1454,7 @@ namespace triqs { namespace det_manip {
      if (s==0) {
       w_refill.x_values.clear();
       w_refill.y_values.clear();
-      return 1 / (sign * det);
+      return _ldexp(1 / (sign * det), -det_exp);
      }
 
      w_refill.reserve(s);
@@ -850,22 +1466,24 @@ namespace triqs { namespace det_manip {
       for (size_t j=0; j<s; ++j)
        w_refill.M(i,j) = f(w_refill.x_values[i],w_refill.y_values[j]);
      range R(0,s);
-     newdet = arrays::determinant(w_refill.M(R,R));
+     newdet = _scaled_determinant(w_refill.M(R,R), newdet_exp);
      newsign = 1;
 
-     return newdet / (sign * det);
+     return _ldexp(newdet / (sign * det), newdet_exp - det_exp);
     }
 
     //------------------------------------------------------------------------------------------
    private :
 
     void complete_refill () {
+     n_pending = 0; // mat_inv is recomputed from scratch
      N = w_refill.x_values.size();
 
      // special empty case again
      if (N==0) {
       clear();
       newdet = 1;
+      newdet_exp = 0;
       newsign = 1;
       return;
      }
@@ -885,8 +1503,10 @@ namespace triqs { namespace det_manip {
     //------------------------------------------------------------------------------------------
     private:
     void _regenerate_with_check(bool do_check, double precision_warning, double precision_error) {
+     flush_delayed_updates();
      if (N == 0) {
       det = 1;
+      det_exp = 0;
       sign = 1;
       return;
      }
@@ -895,7 +1515,7 @@ namespace triqs { namespace det_manip {
      matrix_type res(N, N);
      for (int i = 0; i < N; i++)
       for (int j = 0; j < N; j++) res(i, j) = f(x_values[i], y_values[j]);
-     det = arrays::determinant(res);
+     det = _scaled_determinant(res, det_exp);
      if (is_singular()) {
       res() = std::numeric_limits<double>::quiet_NaN();
       do_check = false;
@@ -943,8 +1563,50 @@ namespace triqs { namespace det_manip {
      _regenerate_with_check(true, precision_warning, precision_error);
     }
 
+    // The periodic check
+    void _periodic_check() {
+     ++drift_stats.n_checks;
+     if (n_drift_probes == 0) {
+      ++drift_stats.n_regenerations;
+      check_mat_inv();
+      return;
+     }
+     n_opts = 0;
+     if (N == 0) return;
+     flush_delayed_updates();
+     size_t np = n_drift_probes;
+     if ((first_dim(drift_V) < N) || (second_dim(drift_V) != np)) {
+      drift_V.resize(Nmax, np);
+      drift_W.resize(Nmax, np);
+     }
+     range R(0, N), P(0, np);
+     for (size_t i = 0; i < N; ++i)
+      for (size_t p = 0; p < np; ++p) drift_V(i, p) = ((drift_rng() & 1) ? 1 : -1);
+     blas::gemm(1.0, mat_inv(R, R), drift_V(R, P), 0.0, drift_W(R, P));
+     // r = max | M W - V |, M being evaluated once, row by row
+     double r = 0;
+     for (size_t i = 0; i < N; ++i) {
+      drift_V(i, P) *= -1;
+      for (size_t j = 0; j < N; ++j) {
+       auto m = f(x_values[i], y_values[j]);
+       for (size_t p = 0; p < np; ++p) drift_V(i, p) += m * drift_W(j, p);
+      }
+      for (size_t p = 0; p < np; ++p) r = std::max(r, double(std::abs(drift_V(i, p))));
+     }
+     drift_stats.last_drift = r;
+     drift_stats.max_drift = std::max(drift_stats.max_drift, r);
+     if (!(r < drift_threshold)) { // also if r is nan
+      ++drift_stats.n_regenerations;
+      regenerate();
+     }
+    }
+
     /// it the det 0 ? I.e. (singular_threshold <0 ? not std::isnormal(std::abs(det)) : (std::abs(det)<singular_threshold))
-    bool is_singular() const { return (singular_threshold <0 ? not std::isnormal(std::abs(det)) : (std::abs(det)<singular_threshold)) ; }
+    /// Since the det is scaled, a very large or small det is not singular.
+    bool is_singular() const {
+     if (singular_threshold < 0) return not std::isnormal(std::abs(det));
+     return log_abs_determinant() < std::log(singular_threshold);
+    }
 
     //------------------------------------------------------------------------------------------
     public:
@@ -964,6 +1626,8 @@ namespace triqs { namespace det_manip {
       case (ChangeRow): complete_change_row(); break;
       case (Insert2): complete_insert2(); break;
       case (Remove2): complete_remove2(); break;
+      case (InsertK): complete_insert_k(); break;
+      case (RemoveK): complete_remove_k(); break;
       case (Refill): complete_refill(); break;
       case (NoTry):
        last_try = NoTry;
@@ -973,9 +1637,12 @@ namespace triqs { namespace det_manip {
      }
      if (is_sing) { regenerate(); } else {
       det = newdet;
+      if (last_try == Refill) det_exp = newdet_exp;
+      _normalize_det();
       sign = newsign;
+      if (N == 0) { det = 1; det_exp = 0; sign = 1; } // the det of the empty matrix is exactly 1
       ++n_opts;
-      if (n_opts > n_opts_max_before_check) check_mat_inv();
+      if (n_opts > n_opts_max_before_check) _periodic_check();
      }
      last_try = NoTry;
     }
@@ -1009,6 +1676,14 @@ namespace triqs { namespace det_manip {
      return insert2(N, N+1, N, N+1, x0, x1, y0, y1);
     }
 
+    /// Insert_k (try_insert_k + complete)
+    template <typename IntContainer, typename ArgumentContainer1, typename ArgumentContainer2>
+    value_type insert_k(IntContainer const &i, IntContainer const &j, ArgumentContainer1 const &x, ArgumentContainer2 const &y) {
+     auto r = try_insert_k(i, j, x, y);
+     complete_operation();
+     return r;
+    }
+
     /// Remove (try_remove + complete)
     value_type remove(size_t i, size_t j) {
      auto r = try_remove(i, j);
@@ -1033,6 +1708,13 @@ namespace triqs { namespace det_manip {
      return remove2(N-1, N-2, N-1, N-2);
     }
 
+    /// Remove_k (try_remove_k + complete)
+    template <typename IntContainer> value_type remove_k(IntContainer const &i, IntContainer const &j) {
+     auto r = try_remove_k(i, j);
+     complete_operation();
+     return r;
+    }
+
     /// change_col (try_change_col + complete)
     value_type change_col(size_t j, xy_type const& y) {
      auto r = try_change_col(j, y);
@@ -1053,6 +1735,7 @@ namespace triqs { namespace det_manip {
     void change_one_row_and_one_col(size_t i, size_t j, xy_type const& x, xy_type const& y) {
       TRIQS_ASSERT(j<N); TRIQS_ASSERT(j>=0);
       TRIQS_ASSERT(i<N); TRIQS_ASSERT(i>=0);
+      flush_delayed_updates();
 
       //we treat the case N=1 separately
       if(N==1){
@@ -1113,6 +1796,7 @@ namespace triqs { namespace det_manip {
       auto f = arrays::dot( w1.MC(R), w1.B(R)) - w1.ksi;
       w1.ksi = g * h - mat_inv(N-1,N-1) * f;
       det *= w1.ksi;
+      _normalize_det();
       w1.ksi= 1./w1.ksi;
 
       //new B and C
@@ -4,45 +4,59 @@
 #include "./fourier_tensor.hpp"
 namespace triqs { namespace gfs{
 
+ namespace {
+
+  // All the elements (a,b,c) of a tensor valued gf are transformed at once, as the columns of a (mesh, element) array.
+  using tensor_t = array_const_view<dcomplex, 4>;
+
+  array<dcomplex, 2> to_mesh_element(tensor_t d) {
+   auto sh = d.shape();
+   long n0 = sh[0], n1 = sh[1], n2 = sh[2], n3 = sh[3];
+   array<dcomplex, 2> r(n0, n1 * n2 * n3);
+   for (long k = 0; k < n0; ++k)
+    for (long a = 0, e = 0; a < n1; a++)
+     for (long b = 0; b < n2; b++)
+      for (long c = 0; c < n3; c++, e++) r(k, e) = d(k, a, b, c);
+   return r;
+  }
+
+  void from_mesh_element(array_view<dcomplex, 4> d, array<dcomplex, 2> const &r) {
+   auto sh = d.shape();
+   long n0 = sh[0], n1 = sh[1], n2 = sh[2], n3 = sh[3];
+   for (long k = 0; k < n0; ++k)
+    for (long a = 0, e = 0; a < n1; a++)
+     for (long b = 0; b < n2; b++)
+      for (long c = 0; c < n3; c++, e++) d(k, a, b, c) = r(k, e);
+  }
+
+  // (3, element) : the orders 1, 2, 3 of the (scalar) tails
+  array<dcomplex, 2> tail_coefficients(array_const_view<tail, 3> ta) {
+   auto sh = ta.shape();
+   long n0 = sh[0], n1 = sh[1], n2 = sh[2];
+   array<dcomplex, 2> r(3, n0 * n1 * n2);
+   for (long a = 0, e = 0; a < n0; a++)
+    for (long b = 0; b < n1; b++)
+     for (long c = 0; c < n2; c++, e++)
+      for (int o = 0; o < 3; ++o) r(o, e) = ta(a, b, c).get_or_zero(o + 1)(0, 0);
+   return r;
+  }
+ }
+
  gf<imfreq, tensor_valued<3>, tail_zero<array<dcomplex,3>>> fourier(gf_const_view<imtime, tensor_valued<3>, tail_zero<array<dcomplex,3>>> g_in, array_const_view<tail, 3> tail, int n_pts, bool positive_frequencies_only){
 
   auto g_out = gf<imfreq, tensor_valued<3>, tail_zero<array<dcomplex,3>>>({g_in.mesh().domain().beta, g_in.mesh().domain().statistic, n_pts, positive_frequencies_only? matsubara_mesh_opt::positive_frequencies_only : matsubara_mesh_opt::all_frequencies}, get_target_shape(g_in));
-  auto g_out_single = gf<imfreq, scalar_valued>(g_out.mesh());
-  auto g_in_single = gf<imtime, scalar_valued>(g_in.mesh());
-  for(int a=0;a<get_target_shape(g_in)[0];a++){
-   for(int b=0;b<get_target_shape(g_in)[1];b++){
-    for(int c=0;c<get_target_shape(g_in)[2];c++){
-     for(auto const & om: g_in_single.mesh())
-      g_in_single[om] = g_in[om](a,b,c);
-     g_in_single.singularity() = tail(a,b,c);
-     g_out_single() = fourier(g_in_single);
-     for(auto const & om: g_out_single.mesh())
-      g_out[om](a,b,c) = g_out_single[om];
-    }//c
-   }//b
-  }//a
-
+  array<dcomplex, 2> r(g_out.mesh().size(), g_out.data().shape()[1] * g_out.data().shape()[2] * g_out.data().shape()[3]);
+  details::fourier_matsubara_direct(g_out.mesh(), r, g_in.mesh(), to_mesh_element(g_in.data()), tail_coefficients(tail));
+  from_mesh_element(g_out.data(), r);
   return g_out;
  }
 
  gf<imtime, tensor_valued<3>,tail_zero<array<dcomplex,3>>> inverse_fourier(gf_const_view<imfreq, tensor_valued<3>,tail_zero<array<dcomplex,3>>> g_in, array_const_view<tail, 3> tail, int n_tau){
 
   auto g_out = gf<imtime, tensor_valued<3>,tail_zero<array<dcomplex,3>>>({g_in.mesh().domain().beta, g_in.mesh().domain().statistic, n_tau}, get_target_shape(g_in));
-  auto g_out_single = gf<imtime, scalar_valued>(g_out.mesh());
-  auto g_in_single = gf<imfreq, scalar_valued>(g_in.mesh());
-  for(int a=0;a<get_target_shape(g_in)[0];a++){
-   for(int b=0;b<get_target_shape(g_in)[1];b++){
-    for(int c=0;c<get_target_shape(g_in)[2];c++){
-     for(auto const & om: g_in_single.mesh())
-      g_in_single[om] = g_in[om](a,b,c);
-     g_in_single.singularity() = tail(a,b,c);
-     g_out_single() = inverse_fourier(g_in_single);
-     for(auto const & om: g_out_single.mesh())
-      g_out[om](a,b,c) = g_out_single[om];
-    }//c
-   }//b
-  }//a
-
+  array<dcomplex, 2> r(g_out.mesh().size(), g_out.data().shape()[1] * g_out.data().shape()[2] * g_out.data().shape()[3]);
+  details::fourier_matsubara_inverse(g_out.mesh(), r, g_in.mesh(), to_mesh_element(g_in.data()), tail_coefficients(tail));
+  from_mesh_element(g_out.data(), r);
   return g_out;
  }
 }}
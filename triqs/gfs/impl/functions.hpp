@@ -138,12 +138,8 @@ namespace gfs {
   *-----------------------------------------------------------------------------------------------------*/
 
  // auxiliary function : invert the data : one function for all matrix valued gf (save code).
- template <typename A3> void _gf_invert_data_in_place(A3 &&a) {
-  for (int i = 0; i < first_dim(a); ++i) { // Rely on the ordering
-   auto v = make_matrix_view(a(i, arrays::range(), arrays::range()));
-   v = triqs::arrays::inverse(v);
-  }
- }
+ // Rely on the ordering : the first index is the mesh index.
+ template <typename A3> void _gf_invert_data_in_place(A3 &&a) { arrays::batched_inverse_in_place(a); }
 
  template <typename M, typename S, typename E> void invert_in_place(gf_view<M, matrix_valued, S, E> g) {
   _gf_invert_data_in_place(g.data());
@@ -208,6 +208,16 @@ namespace gfs {
   template <typename G> static void invoke(h5::group gr, G&g) {}
  };
 
+ /**
+  * Read a slice of the data of the gf stored in the subgroup subgroup_name, e.g. one k point or a frequency window of G(k, iw),
+  * without reading the rest of the data. Cf h5_read_slice for arrays.
+  * The indices are those of the data array in the file : the mesh indices (one per component of a product mesh),
+  * then the target indices. NB : a imfreq gf may be stored on the positive frequencies only (cf its mesh in the file).
+  */
+ template <typename A, typename... S> void h5_read_data_slice(h5::group fg, std::string const &subgroup_name, A &&a, S const &... s) {
+  h5_read_slice(fg.open_group(subgroup_name), "data", std::forward<A>(a), s...);
+ }
+
  /// ---------------------------  real for gf ---------------------------------
 
  /// is_gf_real(g, tolerance). 
@@ -32,62 +32,46 @@ namespace triqs { namespace gfs {
   if (size1 < 0) TRIQS_RUNTIME_ERROR << "n_max - n_min + 1 <0";
   // size2 is the number of moments
 
-  arrays::matrix<double> A(size1, std::max(size_even, size_odd), FORTRAN_LAYOUT);
-  arrays::matrix<double> B(size1, 1, FORTRAN_LAYOUT);
+  // The design matrices depend only on the frequencies and the orders : all the elements (i,j) are fitted
+  // at once, as the columns of the right hand side of a single least squares problem for each parity.
+  int n1 = get_target_shape(gf)[0], n2 = get_target_shape(gf)[1];
+  arrays::matrix<double> A_odd(size1, size_odd, FORTRAN_LAYOUT), A_even(size1, size_even, FORTRAN_LAYOUT);
+  arrays::matrix<double> B_odd(size1, n1 * n2, FORTRAN_LAYOUT), B_even(size1, n1 * n2, FORTRAN_LAYOUT);
   arrays::vector<double> S(std::max(size_even, size_odd));
   const double rcond = 0.0;
   int rank;
 
-  for (int i = 0; i < get_target_shape(gf)[0]; i++) {
-   for (int j = 0; j < get_target_shape(gf)[1]; j++) {
-
-    // fit the odd moments
-    S.resize(size_odd);
-    A.resize(size1,size_odd); //when resizing, gelss segfaults
-    for (int k = 0; k < size1; k++) {
-     auto n = n_min + k;
-     auto iw = std::complex<double>(gf.mesh().index_to_point(n));
-
-     B(k, 0) = imag(gf.data()(gf.mesh().index_to_linear(n), i, j));
-     // subtract known tail if present
-     if (known_moments.size() > 0)
-      B(k, 0) -= imag(evaluate(slice_target(known_moments, arrays::range(i, i + 1), arrays::range(j, j + 1)), iw)(0, 0));
-
-     for (int l = 0; l < size_odd; l++) {
-      int order = omin_odd + 2 * l;
-      A(k, l) = imag(pow(iw, -1.0 * order)); // set design matrix for odd moments
-     }
+  for (int k = 0; k < size1; k++) {
+   auto n = n_min + k;
+   auto iw = std::complex<double>(gf.mesh().index_to_point(n));
+
+   // data to be fitted : odd moments from the imaginary part, even moments from the real part
+   arrays::matrix<dcomplex> g = gf.data()(gf.mesh().index_to_linear(n), arrays::range(), arrays::range());
+   // subtract known tail if present
+   if (known_moments.size() > 0) g -= evaluate(known_moments, iw);
+   for (int i = 0; i < n1; i++)
+    for (int j = 0; j < n2; j++) {
+     B_odd(k, i * n2 + j) = imag(g(i, j));
+     B_even(k, i * n2 + j) = real(g(i, j));
     }
 
-    arrays::lapack::gelss(A, B, S, rcond, rank);
-    for (int m = 0; m < size_odd; m++) {
-     res(omin_odd + 2 * m)(i, j) = B(m, 0);
-    }
+   // set design matrices
+   for (int l = 0; l < size_odd; l++) A_odd(k, l) = imag(pow(iw, -1.0 * (omin_odd + 2 * l)));
+   for (int l = 0; l < size_even; l++) A_even(k, l) = real(pow(iw, -1.0 * (omin_even + 2 * l)));
+  }
 
-    // fit the even moments
-    S.resize(size_even);
-    A.resize(size1,size_even); //when resizing, gelss segfaults
-    for (int k = 0; k < size1; k++) {
-     auto n = n_min + k;
-     auto iw = std::complex<double>(gf.mesh().index_to_point(n));
-
-     B(k, 0) = real(gf.data()(gf.mesh().index_to_linear(n), i, j));
-     // subtract known tail if present
-     if (known_moments.size() > 0)
-      B(k, 0) -= real(evaluate(slice_target(known_moments, arrays::range(i, i + 1), arrays::range(j, j + 1)), iw)(0, 0));
-
-     for (int l = 0; l < size_even; l++) {
-      int order = omin_even + 2 * l;
-      A(k, l) = real(pow(iw, -1.0 * order)); // set design matrix for odd moments
-     }
-    }
+  // fit the odd moments
+  if (size_odd > 0) arrays::lapack::gelss(A_odd, B_odd, S, rcond, rank);
+  for (int m = 0; m < size_odd; m++)
+   for (int i = 0; i < n1; i++)
+    for (int j = 0; j < n2; j++) res(omin_odd + 2 * m)(i, j) = B_odd(m, i * n2 + j);
+
+  // fit the even moments
+  if (size_even > 0) arrays::lapack::gelss(A_even, B_even, S, rcond, rank);
+  for (int m = 0; m < size_even; m++)
+   for (int i = 0; i < n1; i++)
+    for (int j = 0; j < n2; j++) res(omin_even + 2 * m)(i, j) = B_even(m, i * n2 + j);
 
-    arrays::lapack::gelss(A, B, S, rcond, rank);
-    for (int m = 0; m < size_even; m++) {
-     res(omin_even + 2 * m)(i, j) = B(m, 0);
-    }
-   }
-  }
   res.mask()()=max_moment;
   return res; // return tail
  }
@@ -111,69 +95,54 @@ namespace triqs { namespace gfs {
   int n_freq = n_max - n_min + 1;
   if (n_freq < 0) TRIQS_RUNTIME_ERROR << "n_max - n_min + 1 <0";
 
-  arrays::matrix<double> A(n_freq, n_unknown_moments, FORTRAN_LAYOUT);
-  arrays::matrix<double> B(n_freq, 1, FORTRAN_LAYOUT);
+  // The design matrices depend only on the frequencies and the orders : all the elements (i,j) are fitted
+  // at once, as the columns of the right hand side of a single least squares problem for each part.
+  int n1 = get_target_shape(gf)[0], n2 = get_target_shape(gf)[1];
+  arrays::matrix<double> A_im(n_freq, n_unknown_moments, FORTRAN_LAYOUT), A_re(n_freq, n_unknown_moments, FORTRAN_LAYOUT);
+  arrays::matrix<double> B_im(n_freq, n1 * n2, FORTRAN_LAYOUT), B_re(n_freq, n1 * n2, FORTRAN_LAYOUT);
   arrays::vector<double> S(n_unknown_moments);
   const double rcond = 0.0;
   int rank;
 
   // fit both real and imaginary parts at the same time
-  for (int i = 0; i < get_target_shape(gf)[0]; i++) {
-   for (int j = 0; j < get_target_shape(gf)[1]; j++) {
-
-    // IMAGINARY PART
-    // k is a label for the matsubara frequency
-    for (int k = 0; k < n_freq; k++) {
-     auto n = n_min + k;
-     auto iw = std::complex<double>(gf.mesh().index_to_point(n));
-
-     // construct data to be fitted - subtract known tail if present
-     B(k, 0) = imag(gf.data()(gf.mesh().index_to_linear(n), i, j));
-     if (known_moments.size() > 0)
-      B(k, 0) -= imag(evaluate(slice_target(known_moments, arrays::range(i, i + 1), arrays::range(j, j + 1)), iw)(0, 0));
-
-     // set design matrix
-     // if the order is odd the fit yields the real coefficient of the moment
-     // if the order is even the fit yields the imaginary coefficient of the moment
-     for (int l = 0; l < n_unknown_moments; l++) {
-      int order = omin + l;
-      A(k, l) = imag( (order%2==1 ? 1.0 : dcomplex{0,1})*pow(iw, -1.0 * order) );
-     }
+  // k is a label for the matsubara frequency
+  for (int k = 0; k < n_freq; k++) {
+   auto n = n_min + k;
+   auto iw = std::complex<double>(gf.mesh().index_to_point(n));
+
+   // construct data to be fitted - subtract known tail if present
+   arrays::matrix<dcomplex> g = gf.data()(gf.mesh().index_to_linear(n), arrays::range(), arrays::range());
+   if (known_moments.size() > 0) g -= evaluate(known_moments, iw);
+   for (int i = 0; i < n1; i++)
+    for (int j = 0; j < n2; j++) {
+     B_im(k, i * n2 + j) = imag(g(i, j));
+     B_re(k, i * n2 + j) = real(g(i, j));
     }
 
-    arrays::lapack::gelss(A, B, S, rcond, rank);
-    for (int m = 0; m < n_unknown_moments; m++) {
-     res(omin+m)(i, j) = ((omin+m)%2==1 ? B(m,0) : dcomplex{0,1}*B(m, 0));
-    }
+   // set design matrices
+   // imaginary part : if the order is odd the fit yields the real coefficient of the moment,
+   // if the order is even the fit yields the imaginary coefficient of the moment
+   // real part : if the order is even the fit yields the real coefficient of the moment,
+   // if the order is odd the fit yields the imaginary coefficient of the moment
+   for (int l = 0; l < n_unknown_moments; l++) {
+    int order = omin + l;
+    A_im(k, l) = imag((order % 2 == 1 ? 1.0 : dcomplex{0, 1}) * pow(iw, -1.0 * order));
+    A_re(k, l) = real((order % 2 == 0 ? 1.0 : dcomplex{0, 1}) * pow(iw, -1.0 * order));
+   }
+  }
 
-    // REAL PART
-    // k is a label for the matsubara frequency
-    for (int k = 0; k < n_freq; k++) {
-     auto n = n_min + k;
-     auto iw = std::complex<double>(gf.mesh().index_to_point(n));
-
-     // construct data to be fitted - subtract known tail if present
-     B(k, 0) = real(gf.data()(gf.mesh().index_to_linear(n), i, j));
-     if (known_moments.size() > 0)
-      B(k, 0) -= real(evaluate(slice_target(known_moments, arrays::range(i, i + 1), arrays::range(j, j + 1)), iw)(0, 0));
-
-     // set design matrix
-     // if the order is even the fit yields the real coefficient of the moment
-     // if the order is odd the fit yields the imaginary coefficient of the moment
-     for (int l = 0; l < n_unknown_moments; l++) {
-      int order = omin + l;
-      A(k, l) = real( (order%2==0 ? 1.0 : dcomplex{0,1})*pow(iw, -1.0 * order) );
-     }
-    }
+  // IMAGINARY PART
+  arrays::lapack::gelss(A_im, B_im, S, rcond, rank);
+  // REAL PART
+  arrays::lapack::gelss(A_re, B_re, S, rcond, rank);
 
-    arrays::lapack::gelss(A, B, S, rcond, rank);
-    for (int m = 0; m < n_unknown_moments; m++) {
-     res(omin+m)(i, j) += ((omin+m)%2==0 ? B(m, 0) : dcomplex{0,1}*B(m,0));
+  for (int m = 0; m < n_unknown_moments; m++)
+   for (int i = 0; i < n1; i++)
+    for (int j = 0; j < n2; j++) {
+     double b_im = B_im(m, i * n2 + j), b_re = B_re(m, i * n2 + j);
+     res(omin + m)(i, j) = ((omin + m) % 2 == 1 ? b_im : dcomplex{0, 1} * b_im) + ((omin + m) % 2 == 0 ? b_re : dcomplex{0, 1} * b_re);
     }
 
-   }
-  }
-
   res.mask()()=max_moment;
   return res; // return tail
  }
@@ -0,0 +1,188 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2014 by M. Ferrero, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "./fftw_plan_cache.hpp"
+#include <triqs/utility/exceptions.hpp>
+#include <fftw3.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+namespace triqs {
+namespace gfs {
+
+ namespace {
+
+  // All that determines a plan usable with fftw_execute_dft on other arrays
+  struct plan_key {
+   std::vector<int> dims;
+   int howmany, istride, idist, ostride, odist, sign;
+   bool in_place, aligned;
+   bool operator<(plan_key const &k) const {
+    return std::tie(dims, howmany, istride, idist, ostride, odist, sign, in_place, aligned) <
+           std::tie(k.dims, k.howmany, k.istride, k.idist, k.ostride, k.odist, k.sign, k.in_place, k.aligned);
+   }
+  };
+
+  // The FFTW planner is not thread safe : all the planner calls are done under this lock.
+  std::mutex planner_mutex;
+  fftw_planning planning = fftw_planning::estimate;
+
+  // A plan is destroyed (under the lock) when it is no more in the cache, and no more executed by any thread.
+  using plan_ptr = std::shared_ptr<std::remove_pointer<fftw_plan>::type>;
+  plan_ptr make_plan_ptr(fftw_plan p) {
+   return plan_ptr(p, [](fftw_plan q) {
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    fftw_destroy_plan(q);
+   });
+  }
+
+  // The cache. last_use is the value of use_count at the last use of the plan.
+  // When it is full, the least recently used plan is evicted.
+  struct cached_plan {
+   plan_ptr plan;
+   uint64_t last_use;
+  };
+  using cache_t = std::map<plan_key, cached_plan>;
+  cache_t plan_cache;
+  size_t max_cache_size = 64;
+  uint64_t use_count = 0;
+
+  unsigned planning_flags() {
+   switch (planning) {
+    case fftw_planning::measure: return FFTW_MEASURE;
+    case fftw_planning::patient: return FFTW_PATIENT;
+    default: return FFTW_ESTIMATE;
+   }
+  }
+
+  // Removes the least recently used plans until the cache has at most n plans. They are put in removed,
+  // to be destroyed when the lock is released.
+  void shrink_cache_no_lock(size_t n, std::vector<plan_ptr> &removed) {
+   while (plan_cache.size() > n) {
+    auto lru = std::min_element(plan_cache.begin(), plan_cache.end(),
+                                [](cache_t::value_type const &x, cache_t::value_type const &y) {
+                                 return x.second.last_use < y.second.last_use;
+                                });
+    removed.push_back(std::move(lru->second.plan));
+    plan_cache.erase(lru);
+   }
+  }
+
+  // destroys the plans at exit
+  struct cache_cleaner {
+   ~cache_cleaner() { fftw_clear_plan_cache(); }
+  } _cleaner;
+
+  // Makes the plan on scratch arrays, since measure and patient overwrite them.
+  fftw_plan make_plan(plan_key const &k) {
+   long n = 1;
+   for (auto d : k.dims) n *= d;
+   long in_size = (k.howmany - 1) * long(k.idist) + (n - 1) * k.istride + 1;
+   long out_size = (k.howmany - 1) * long(k.odist) + (n - 1) * k.ostride + 1;
+   auto in = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * std::max(in_size, out_size)));
+   auto out = (k.in_place ? in : static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * out_size)));
+   unsigned flags = planning_flags() | (k.aligned ? 0 : FFTW_UNALIGNED);
+   auto p = fftw_plan_many_dft(k.dims.size(), k.dims.data(), k.howmany, in, NULL, k.istride, k.idist, out, NULL, k.ostride,
+                               k.odist, k.sign, flags);
+   if (!k.in_place) fftw_free(out);
+   fftw_free(in);
+   if (!p) TRIQS_RUNTIME_ERROR << "FFTW : can not make the plan";
+   return p;
+  }
+ }
+
+ //--------------------------------------------------------------------------------------
+
+ void set_fftw_planning(fftw_planning p) {
+  std::vector<plan_ptr> removed; // destroyed after the lock is released
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  if (p == planning) return;
+  planning = p;
+  shrink_cache_no_lock(0, removed);
+ }
+
+ fftw_planning get_fftw_planning() {
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  return planning;
+ }
+
+ bool fftw_import_wisdom(std::string const &filename) {
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  return fftw_import_wisdom_from_filename(filename.c_str());
+ }
+
+ void fftw_export_wisdom(std::string const &filename) {
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  if (!fftw_export_wisdom_to_filename(filename.c_str())) TRIQS_RUNTIME_ERROR << "FFTW : can not write the wisdom file " << filename;
+ }
+
+ void fftw_clear_plan_cache() {
+  std::vector<plan_ptr> removed;
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  shrink_cache_no_lock(0, removed);
+ }
+
+ void set_fftw_plan_cache_max_size(size_t n) {
+  if (n == 0) TRIQS_RUNTIME_ERROR << "FFTW : the plan cache must hold at least one plan";
+  std::vector<plan_ptr> removed;
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  max_cache_size = n;
+  shrink_cache_no_lock(n, removed);
+ }
+
+ size_t fftw_plan_cache_size() {
+  std::lock_guard<std::mutex> lock(planner_mutex);
+  return plan_cache.size();
+ }
+
+ //--------------------------------------------------------------------------------------
+
+ namespace details {
+
+  void fft_many(std::vector<int> const &dims, int howmany, std::complex<double> const *in, int istride, int idist,
+                std::complex<double> *out, int ostride, int odist, int sign) {
+   // out of place, a complex dft does not modify its input
+   auto in_fft = reinterpret_cast<fftw_complex *>(const_cast<std::complex<double> *>(in));
+   auto out_fft = reinterpret_cast<fftw_complex *>(out);
+   bool aligned = (fftw_alignment_of(reinterpret_cast<double *>(in_fft)) == 0) &&
+                  (fftw_alignment_of(reinterpret_cast<double *>(out_fft)) == 0);
+   plan_key k{dims, howmany, istride, idist, ostride, odist, sign, (in == out), aligned};
+   plan_ptr p;
+   std::vector<plan_ptr> removed;
+   {
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    auto it = plan_cache.find(k);
+    if (it == plan_cache.end()) {
+     shrink_cache_no_lock(max_cache_size - 1, removed);
+     it = plan_cache.insert({k, {make_plan_ptr(make_plan(k)), 0}}).first;
+    }
+    it->second.last_use = ++use_count;
+    p = it->second.plan;
+   }
+   removed.clear();                             // destroys the evicted plans, out of the lock
+   fftw_execute_dft(p.get(), in_fft, out_fft); // thread safe
+  }
+ }
+}
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2014 by M. Ferrero, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <complex>
+#include <string>
+#include <vector>
+
+namespace triqs {
+namespace gfs {
+
+ /**
+  * How the FFTW plans of the Fourier transforms are made.
+  *  - estimate : heuristic plan, immediate (FFTW_ESTIMATE). Default.
+  *  - measure  : the plan is chosen by timing some algorithms (FFTW_MEASURE).
+  *  - patient  : idem, with more algorithms (FFTW_PATIENT).
+  * The plans are cached, for each size, direction and layout, so that the cost of measure or patient
+  * is paid once per process, or once for all with the wisdom files.
+  * The cache holds at most 64 plans by default (cf set_fftw_plan_cache_max_size) : the least recently used plan is then evicted.
+  */
+ enum class fftw_planning { estimate, measure, patient };
+
+ /// Sets the planning of the plans made from now on. It clears the plan cache.
+ void set_fftw_planning(fftw_planning p);
+
+ /// The current planning
+ fftw_planning get_fftw_planning();
+
+ /**
+  * Loads the FFTW wisdom saved by fftw_export_wisdom, e.g. in a previous run.
+  * The plans made afterwards with the same planning are then immediate.
+  * Returns false if the file can not be read.
+  */
+ bool fftw_import_wisdom(std::string const &filename);
+
+ /// Saves the FFTW wisdom of this process to a file.
+ void fftw_export_wisdom(std::string const &filename);
+
+ /// Destroys all the cached plans
+ void fftw_clear_plan_cache();
+
+ /// Sets the maximum number of cached plans (>0). The least recently used plans are evicted.
+ void set_fftw_plan_cache_max_size(size_t n);
+
+ /// Number of cached plans
+ size_t fftw_plan_cache_size();
+
+ namespace details {
+
+  /**
+   * FFT of howmany arrays of dimensions dims, as fftw_plan_many_dft : the element x of the k-th array
+   * is at in[k * idist + x * istride], with x the C order index in dims (idem for out).
+   * The plan is taken from the cache, or made and cached. Thread safe.
+   * in is not modified, unless in == out (in place transform).
+   *
+   * @param sign -1 (FFTW_FORWARD) or +1 (FFTW_BACKWARD)
+   */
+  void fft_many(std::vector<int> const &dims, int howmany, std::complex<double> const *in, int istride, int idist,
+                std::complex<double> *out, int ostride, int odist, int sign);
+
+  /// FFT of one contiguous array of size L
+  inline void fft_1d(int L, std::complex<double> const *in, std::complex<double> *out, int sign) {
+   fft_many({L}, 1, in, 1, L, out, 1, L, sign);
+  }
+ }
+}
+}
@@ -19,6 +19,7 @@
  *
  ******************************************************************************/
 #include "fourier_base.hpp"
+#include "./fftw_plan_cache.hpp"
 #include <fftw3.h>
 #include <algorithm>
 
@@ -30,23 +31,22 @@ namespace triqs { namespace gfs { namespace details {
   //const size_t L( (direct ? in.size() : out.size()) );
   //const int L(max(in.size(),out.size()));  <-- bug
   
-  fftw_complex *inFFT, *outFFT;
-  fftw_plan p;
-  inFFT = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * L);
-  outFFT = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * L);
-  
-  const dcomplex * restrict in_ptr = in.data_start();
-  dcomplex * restrict out_ptr = out.data_start();
+  int sign = (direct ? FFTW_BACKWARD : FFTW_FORWARD);
+  // no copy when the vectors have the size of the transform
+  if ((in.size() == L) && (out.size() == L)) {
+   fft_1d(L, in.data_start(), out.data_start(), sign);
+   return;
+  }
+
+  // otherwise, pad the input with 0, and truncate the output
+  static thread_local std::vector<dcomplex> inFFT, outFFT;
+  inFFT.assign(L, 0);
+  outFFT.resize(L);
   const size_t imax = std::min(L,in.size());
-  for (size_t i =0; i<imax; ++i) { inFFT[i][0] = real(in_ptr[i]); inFFT[i][1] = imag(in_ptr[i]);}
-  for (size_t i =imax; i<L; ++i) { inFFT[i][0] = 0; inFFT[i][1] = 0;}
-//   for (size_t i =0; i<L; ++i) { inFFT[i][0] = real(in_ptr[i]); inFFT[i][1] = imag(in_ptr[i]);}
-  p = fftw_plan_dft_1d(L, inFFT, outFFT, (direct ? FFTW_BACKWARD : FFTW_FORWARD), FFTW_ESTIMATE);
-  fftw_execute(p); 
+  for (size_t i =0; i<imax; ++i) inFFT[i] = in[i];
+  fft_1d(L, inFFT.data(), outFFT.data(), sign);
   const size_t jmax = std::min(L,out.size());
-  for (size_t j =0; j<jmax; ++j) out_ptr[j] = dcomplex(outFFT[j][0] ,outFFT[j][1]);
-  fftw_destroy_plan(p); 
-  fftw_free(inFFT); fftw_free(outFFT);
+  for (size_t j =0; j<jmax; ++j) out[j] = outFFT[j];
  }
  
 }}}
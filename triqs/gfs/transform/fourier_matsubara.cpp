@@ -19,6 +19,8 @@
  *
  ******************************************************************************/
 #include "fourier_matsubara.hpp"
+#include "./fftw_plan_cache.hpp"
+#include "./mesh_element.hpp"
 #include <fftw3.h>
 
 namespace triqs {
@@ -26,9 +28,7 @@ namespace gfs {
 
  //--------------------------------------------------------------------------------------
 
- struct impl_worker {
-
-  arrays::vector<dcomplex> g_in, g_out;
+ namespace {
 
   dcomplex oneFermion(dcomplex a, double b, double tau, double beta) {
    return -a * (b >= 0 ? exp(-b * tau) / (1 + exp(-beta * b)) : exp(b * (beta - tau)) / (1 + exp(beta * b)));
@@ -38,172 +38,187 @@ namespace gfs {
    return a * (b >= 0 ? exp(-b * tau) / (exp(-beta * b) - 1) : exp(b * (beta - tau)) / (1 - exp(b * beta)));
   }
 
-  //-------------------------------------
-
-  void direct(gf_view<imfreq, scalar_valued> gw, gf_const_view<imtime, scalar_valued> gt) {
-   auto ta = gt.singularity();
-   direct_impl(make_gf_view_without_tail(gw), make_gf_view_without_tail(gt), ta);
-   gw.singularity() = gt.singularity(); // set tail
-  }
-
-  void direct(gf_view<imfreq, scalar_valued, no_tail> gw, gf_const_view<imtime, scalar_valued, no_tail> gt) {
-   auto ta = tail{1,1};
-   direct_impl(gw, gt, ta);
-  }
-  
-  //-------------------------------------
+  // The tail is subtracted as a1/(w-b1) + a2/(w-b2) + a3/(w-b3), whose Fourier transform is known.
+  // a(i,e) : coefficient ai of the element e.
+  struct tail_model {
+   double b[3];
+   arrays::array<dcomplex, 2> a;
+
+   tail_model(arrays::array_const_view<dcomplex, 2> coefs, bool is_fermion) : a(3, coefs.shape()[1]) {
+    long ne = a.shape()[1];
+    for (long e = 0; e < ne; ++e) {
+     dcomplex d = coefs(0, e), A = coefs(1, e), B = coefs(2, e);
+     if (is_fermion) {
+      a(0, e) = d - B;
+      a(1, e) = (A + B) / 2;
+      a(2, e) = (B - A) / 2;
+     } else {
+      a(0, e) = 4 * (d - B) / 3;
+      a(1, e) = B - (d + A) / 2;
+      a(2, e) = d / 6 + A / 2 + B / 3;
+     }
+    }
+    if (is_fermion) {
+     b[0] = 0;
+     b[1] = 1;
+     b[2] = -1;
+    } else {
+     b[0] = -0.5;
+     b[1] = -1;
+     b[2] = 1;
+    }
+   }
+  };
+ }
 
-  private:
-  void direct_impl(gf_view<imfreq, scalar_valued, no_tail> gw, gf_const_view<imtime, scalar_valued, no_tail> gt,
-                   tail const& ta) {
-   // TO BE MODIFIED AFTER SCALAR IMPLEMENTATION TODO
-   dcomplex d = ta(1)(0, 0), A = ta.get_or_zero(2)(0, 0), B = ta.get_or_zero(3)(0, 0);
-   double b1 = 0, b2 = 0, b3 = 0;
-   dcomplex a1, a2, a3;
-   double beta = gt.mesh().domain().beta;
-   auto L = gt.mesh().size() - 1;
-   if (L < 2*(gw.mesh().last_index()+1))
-    TRIQS_RUNTIME_ERROR << "Fourier: The time mesh mush be at least twice as long as the number of positive frequencies :\n gt.mesh().size() =  " << gt.mesh().size()
-                        << " gw.mesh().last_index()" << gw.mesh().last_index();
+ namespace details {
+
+  // All the elements are transformed together : the tail functions are computed once per time or frequency,
+  // and one FFT (fft_many) is done for all the elements.
+  void fourier_matsubara_direct(gf_mesh<imfreq> const &mw, arrays::array_view<dcomplex, 2> gw, gf_mesh<imtime> const &mt,
+                                arrays::array_const_view<dcomplex, 2> gt, arrays::array_const_view<dcomplex, 2> tail_coefs) {
+   long ne = gt.shape()[1];
+   double beta = mt.domain().beta;
+   long L = mt.size() - 1;
+   if (L < 2 * (mw.last_index() + 1))
+    TRIQS_RUNTIME_ERROR << "Fourier: The time mesh mush be at least twice as long as the number of positive frequencies :\n gt.mesh().size() =  "
+                        << mt.size() << " gw.mesh().last_index()" << mw.last_index();
    double fact = beta / L;
    dcomplex iomega = M_PI * 1_j / beta;
-   bool is_fermion = (gw.domain().statistic == Fermion);
-
-   if (is_fermion) {
-    b1 = 0;
-    b2 = 1;
-    b3 = -1;
-    a1 = d - B;
-    a2 = (A + B) / 2;
-    a3 = (B - A) / 2;
-   } else {
-    b1 = -0.5;
-    b2 = -1;
-    b3 = 1;
-    a1 = 4 * (d - B) / 3;
-    a2 = B - (d + A) / 2;
-    a3 = d / 6 + A / 2 + B / 3;
+   bool is_fermion = (mw.domain().statistic == Fermion);
+   auto tm = tail_model{tail_coefs, is_fermion};
+
+   // g_in(t, e) : the function minus its tail, on the L first times
+   arrays::array<dcomplex, 2> g_in(L, ne), g_out(L, ne);
+   for (auto const &t : mt) {
+    long k = t.index();
+    if (k == L) break;
+    dcomplex f[3], ph = (is_fermion ? fact * exp(iomega * t) : fact);
+    for (int i = 0; i < 3; ++i) f[i] = (is_fermion ? oneFermion(1, tm.b[i], t, beta) : oneBoson(1, tm.b[i], t, beta));
+    for (long e = 0; e < ne; ++e) g_in(k, e) = ph * (gt(k, e) - (tm.a(0, e) * f[0] + tm.a(1, e) * f[1] + tm.a(2, e) * f[2]));
    }
 
-   //debug: check it is useless ...
-   //a1=0; a2=0;a3=0;
+   // in our convention backward is direct
+   fft_many({int(L)}, ne, g_in.data_start(), ne, 1, g_out.data_start(), ne, 1, FFTW_BACKWARD);
 
-   g_in.resize(L + 1);
-   g_out.resize(L);
-   g_in() = 0;
- 
-   if (is_fermion) {
-    for (auto const & t : gt.mesh())
-       g_in[t.index()] = fact * exp(iomega * t) *
-                         (gt[t] - (oneFermion(a1, b1, t, beta) + oneFermion(a2, b2, t, beta) + oneFermion(a3, b3, t, beta)));
-   } else {
-    for (auto const & t : gt.mesh())
-       g_in[t.index()] = fact * (gt[t] - (oneBoson(a1, b1, t, beta) + oneBoson(a2, b2, t, beta) + oneBoson(a3, b3, t, beta)));
-   }
-   g_in[L] = 0;
-
-   auto g_in_fft = reinterpret_cast<fftw_complex*>(g_in.data_start());
-   auto g_out_fft = reinterpret_cast<fftw_complex*>(g_out.data_start());
- 
-   auto p = fftw_plan_dft_1d(L, g_in_fft, g_out_fft, FFTW_BACKWARD, FFTW_ESTIMATE); // in our convention backward is direct
-   fftw_execute(p); 
-   fftw_destroy_plan(p); 
-
-   //details::fourier_base(g_in, g_out, L, true);
-
-   // I do not see the use of this term
    // If the discontinuity is perfectly correct, this term is 0.
    // We manually remove half of the first time point contribution and add half
    // of the last time point contribution. This is necessary to make sure that no symmetry is lost
-   dcomplex corr = -0.5 * fact * (gt[0] + d + (is_fermion ? 1 : -1) * gt[L]);
-   for (auto const& w : gw.mesh()) gw[w] = g_out((w.index() + L) % L) + corr + a1 / (w - b1) + a2 / (w - b2) + a3 / (w - b3);
-   
-   //for (auto const& w : gw.mesh()) gw[w] = g_out((w.index() + L) % L) + a1 / (w - b1) + a2 / (w - b2) + a3 / (w - b3);
+   arrays::array<dcomplex, 1> corr(ne);
+   for (long e = 0; e < ne; ++e) corr(e) = -0.5 * fact * (gt(0, e) + tail_coefs(0, e) + (is_fermion ? 1 : -1) * gt(L, e));
+
+   for (auto const &w : mw) {
+    long k = w.linear_index(), r = (w.index() + L) % L;
+    dcomplex f[3];
+    for (int i = 0; i < 3; ++i) f[i] = 1.0 / (dcomplex(w) - tm.b[i]);
+    for (long e = 0; e < ne; ++e) gw(k, e) = g_out(r, e) + corr(e) + tm.a(0, e) * f[0] + tm.a(1, e) * f[1] + tm.a(2, e) * f[2];
+   }
   }
 
-  public:
   //-------------------------------------
 
-  void inverse(gf_view<imtime, scalar_valued> gt, gf_const_view<imfreq, scalar_valued> gw) {
-   if (gw.mesh().positive_only()) TRIQS_RUNTIME_ERROR << "Fourier is only implemented for g(i omega_n) with full mesh (positive and negative frequencies)";
-   auto ta = gw.singularity();
-   // TO BE MODIFIED AFTER SCALAR IMPLEMENTATION TODO
-   dcomplex d = ta(1)(0, 0), A = ta.get_or_zero(2)(0, 0), B = ta.get_or_zero(3)(0, 0);
-   double b1, b2, b3;
-   dcomplex a1, a2, a3;
-   double beta = gw.domain().beta;
-   long L = gt.mesh().size() - 1;
-   if (L < 2*(gw.mesh().last_index()+1))
-    TRIQS_RUNTIME_ERROR << "Inverse Fourier: The time mesh mush be at least twice as long as the freq mesh :\n gt.mesh().size() =  " << gt.mesh().size()
-                        << " gw.mesh().last_index()" << gw.mesh().last_index();
-   dcomplex iomega = M_PI* 1_j / beta;
+  void fourier_matsubara_inverse(gf_mesh<imtime> const &mt, arrays::array_view<dcomplex, 2> gt, gf_mesh<imfreq> const &mw,
+                                 arrays::array_const_view<dcomplex, 2> gw, arrays::array_const_view<dcomplex, 2> tail_coefs) {
+   if (mw.positive_only())
+    TRIQS_RUNTIME_ERROR << "Fourier is only implemented for g(i omega_n) with full mesh (positive and negative frequencies)";
+   long ne = gw.shape()[1];
+   double beta = mw.domain().beta;
+   long L = mt.size() - 1;
+   if (L < 2 * (mw.last_index() + 1))
+    TRIQS_RUNTIME_ERROR << "Inverse Fourier: The time mesh mush be at least twice as long as the freq mesh :\n gt.mesh().size() =  "
+                        << mt.size() << " gw.mesh().last_index()" << mw.last_index();
+   dcomplex iomega = M_PI * 1_j / beta;
    double fact = 1.0 / beta;
-   bool is_fermion = (gw.domain().statistic == Fermion);
- 
-   if (is_fermion) {
-    b1 = 0;
-    b2 = 1;
-    b3 = -1;
-    a1 = d - B;
-    a2 = (A + B) / 2;
-    a3 = (B - A) / 2;
-   } else {
-    b1 = -0.5;
-    b2 = -1;
-    b3 = 1;
-    a1 = 4 * (d - B) / 3;
-    a2 = B - (d + A) / 2;
-    a3 = d / 6 + A / 2 + B / 3;
+   bool is_fermion = (mw.domain().statistic == Fermion);
+   auto tm = tail_model{tail_coefs, is_fermion};
+
+   // L>=2*(gw.mesh().last_index()+1) , we fill the middle of the array with 0
+   arrays::array<dcomplex, 2> g_in(L, ne), g_out(L, ne);
+   g_in() = 0;
+   for (auto const &w : mw) {
+    long k = w.linear_index(), r = (w.index() + L) % L;
+    dcomplex f[3];
+    for (int i = 0; i < 3; ++i) f[i] = 1.0 / (dcomplex(w) - tm.b[i]);
+    for (long e = 0; e < ne; ++e) g_in(r, e) = fact * (gw(k, e) - (tm.a(0, e) * f[0] + tm.a(1, e) * f[1] + tm.a(2, e) * f[2]));
    }
 
-   g_in.resize(L); // L>=2*(gw.mesh().last_index()+1) , we will fill the middle array with 0
-   g_out.resize(L + 1);
+   // in our convention forward is inverse
+   fft_many({int(L)}, ne, g_in.data_start(), ne, 1, g_out.data_start(), ne, 1, FFTW_FORWARD);
 
-   g_in() = 0;
-   for (auto const& w : gw.mesh()) g_in[(w.index() + L) % L] = fact * (gw[w] - (a1 / (w - b1) + a2 / (w - b2) + a3 / (w - b3)));
-
-   auto g_in_fft = reinterpret_cast<fftw_complex*>(g_in.data_start());
-   auto g_out_fft = reinterpret_cast<fftw_complex*>(g_out.data_start());
- 
-   auto p = fftw_plan_dft_1d(L, g_in_fft, g_out_fft, FFTW_FORWARD, FFTW_ESTIMATE); // in our convention backward is inverse FFT
-   fftw_execute(p); 
-   fftw_destroy_plan(p); 
-
-   if (is_fermion) {
-    for (auto const & t : gt.mesh()) {
-      gt[t] = g_out(t.index()) * exp(-iomega * t) + oneFermion(a1, b1, t, beta) + oneFermion(a2, b2, t, beta) +
-              oneFermion(a3, b3, t, beta);
-    }
-   } else {
-    for (auto const & t : gt.mesh())
-      gt[t] = g_out(t.index()) + oneBoson(a1, b1, t, beta) + oneBoson(a2, b2, t, beta) + oneBoson(a3, b3, t, beta);
+   for (auto const &t : mt) {
+    long k = t.index();
+    if (k == L) break;
+    dcomplex f[3], ph = (is_fermion ? exp(-iomega * t) : 1);
+    for (int i = 0; i < 3; ++i) f[i] = (is_fermion ? oneFermion(1, tm.b[i], t, beta) : oneBoson(1, tm.b[i], t, beta));
+    for (long e = 0; e < ne; ++e) gt(k, e) = g_out(k, e) * ph + tm.a(0, e) * f[0] + tm.a(1, e) * f[1] + tm.a(2, e) * f[2];
    }
    double pm = (is_fermion ? -1 : 1);
-   gt.on_mesh(L) = pm * (gt.on_mesh(0) + ta(1)(0, 0));
-   // set tail
-   gt.singularity() = gw.singularity();
+   for (long e = 0; e < ne; ++e) gt(L, e) = pm * (gt(0, e) + tail_coefs(0, e));
+  }
+ }
+
+ //--------------------------------------------------------------------------------------
+
+ namespace {
+
+  using details::as_mesh_element;
+  using details::copy_back;
+
+  // (3, n1 * n2) : the orders 1, 2, 3 of the tail
+  arrays::array<dcomplex, 2> tail_coefficients(tail_const_view ta) {
+   long n1 = ta.shape()[0], n2 = ta.shape()[1];
+   arrays::array<dcomplex, 2> r(3, n1 * n2);
+   for (int o = 0; o < 3; ++o) {
+    auto m = ta.get_or_zero(o + 1);
+    for (long i = 0; i < n1; ++i)
+     for (long j = 0; j < n2; ++j) r(o, i * n2 + j) = m(i, j);
+   }
+   return r;
   }
 
- }; // class worker
+  void direct_impl(gf_view<imfreq, matrix_valued, no_tail> gw, gf_const_view<imtime, matrix_valued, no_tail> gt, tail_const_view ta) {
+   if (gt.data().shape().front_pop() != gw.data().shape().front_pop()) TRIQS_RUNTIME_ERROR << "Fourier : matrix size of target mismatch";
+   arrays::array<dcomplex, 2> cw, ct;
+   auto vw = as_mesh_element(gw.data(), cw);
+   details::fourier_matsubara_direct(gw.mesh(), vw, gt.mesh(), as_mesh_element(gt.data(), ct), tail_coefficients(ta));
+   copy_back(gw.data(), vw, cw);
+  }
+ }
 
  //--------------------------------------------
 
  // Direct transformation imtime -> imfreq, with a tail
+ void _fourier_impl(gf_view<imfreq, matrix_valued, tail> gw, gf_const_view<imtime, matrix_valued, tail> gt) {
+  direct_impl(make_gf_view_without_tail(gw), make_gf_view_without_tail(gt), gt.singularity());
+  gw.singularity() = gt.singularity(); // set tail
+ }
+
+ void _fourier_impl(gf_view<imfreq, matrix_valued, no_tail> gw, gf_const_view<imtime, matrix_valued, no_tail> gt) {
+  auto sh = get_target_shape(gt);
+  direct_impl(gw, gt, tail(sh[0], sh[1]));
+ }
+
+ // Inverse transformation imfreq -> imtime: tail is mandatory
+ void _fourier_impl(gf_view<imtime, matrix_valued, tail> gt, gf_const_view<imfreq, matrix_valued, tail> gw) {
+  if (gt.data().shape().front_pop() != gw.data().shape().front_pop()) TRIQS_RUNTIME_ERROR << "Fourier : matrix size of target mismatch";
+  arrays::array<dcomplex, 2> cw, ct;
+  auto vt = as_mesh_element(gt.data(), ct);
+  details::fourier_matsubara_inverse(gt.mesh(), vt, gw.mesh(), as_mesh_element(gw.data(), cw), tail_coefficients(gw.singularity()));
+  copy_back(gt.data(), vt, ct);
+  gt.singularity() = gw.singularity(); // set tail
+ }
+
+ // The scalar valued gf are 1x1 matrices
  void _fourier_impl(gf_view<imfreq, scalar_valued, tail> gw, gf_const_view<imtime, scalar_valued, tail> gt) {
-  impl_worker w;
-  w.direct(gw, gt);
+  _fourier_impl(reinterpret_scalar_valued_gf_as_matrix_valued(gw), reinterpret_scalar_valued_gf_as_matrix_valued(gt));
  }
 
  void _fourier_impl(gf_view<imfreq, scalar_valued, no_tail> gw, gf_const_view<imtime, scalar_valued, no_tail> gt) {
-  impl_worker w;
-  w.direct(gw, gt);
+  _fourier_impl(reinterpret_scalar_valued_gf_as_matrix_valued(gw), reinterpret_scalar_valued_gf_as_matrix_valued(gt));
  }
 
- // Inverse transformation imfreq -> imtime: tail is mandatory
  void _fourier_impl(gf_view<imtime, scalar_valued, tail> gt, gf_const_view<imfreq, scalar_valued, tail> gw) {
-  impl_worker w;
-  w.inverse(gt, gw);
+  _fourier_impl(reinterpret_scalar_valued_gf_as_matrix_valued(gt), reinterpret_scalar_valued_gf_as_matrix_valued(gw));
  }
 }
 }
-
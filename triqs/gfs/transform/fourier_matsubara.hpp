@@ -44,6 +44,28 @@ namespace gfs {
  void _fourier_impl(gf_view<imfreq, scalar_valued, no_tail> gw, gf_const_view<imtime, scalar_valued, no_tail> gt);
  void _fourier_impl(gf_view<imtime, scalar_valued, tail> gt, gf_const_view<imfreq, scalar_valued, tail> gw);
 
+ // All the matrix elements are transformed at once
+ void _fourier_impl(gf_view<imfreq, matrix_valued, tail> gw, gf_const_view<imtime, matrix_valued, tail> gt);
+ void _fourier_impl(gf_view<imfreq, matrix_valued, no_tail> gw, gf_const_view<imtime, matrix_valued, no_tail> gt);
+ void _fourier_impl(gf_view<imtime, matrix_valued, tail> gt, gf_const_view<imfreq, matrix_valued, tail> gw);
+
+ namespace details {
+
+  /**
+   * Fourier transform imtime -> imfreq of ne functions at once.
+   *
+   * @param gw (mesh index, element) : the result, on the mesh mw
+   * @param gt (mesh index, element) : the functions, on the mesh mt
+   * @param tail_coefs (order - 1, element) : the coefficients of the orders 1, 2, 3 of the tails
+   */
+  void fourier_matsubara_direct(gf_mesh<imfreq> const &mw, arrays::array_view<dcomplex, 2> gw, gf_mesh<imtime> const &mt,
+                                arrays::array_const_view<dcomplex, 2> gt, arrays::array_const_view<dcomplex, 2> tail_coefs);
+
+  /// Inverse Fourier transform imfreq -> imtime of ne functions at once. Cf fourier_matsubara_direct.
+  void fourier_matsubara_inverse(gf_mesh<imtime> const &mt, arrays::array_view<dcomplex, 2> gt, gf_mesh<imfreq> const &mw,
+                                 arrays::array_const_view<dcomplex, 2> gw, arrays::array_const_view<dcomplex, 2> tail_coefs);
+ }
+
  /**
   *
   */
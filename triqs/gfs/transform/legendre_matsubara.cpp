@@ -22,7 +22,12 @@
 #include "legendre_matsubara.hpp"
 #include "fourier_matsubara.hpp"
 #include "../functions/functions.hpp"
+#include "./mesh_element.hpp"
 #include <triqs/utility/legendre.hpp>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 using namespace triqs::utility;
 
@@ -31,33 +36,104 @@ namespace gfs {
 
  // ----------------------------
 
- void legendre_matsubara_direct(gf_view<imfreq> gw, gf_const_view<legendre> gl) {
+ namespace details {
 
-  gw() = 0.0;
-  triqs::arrays::range R;
+  namespace {
+   std::mutex T_mutex;
+   std::map<std::tuple<long, long, long>, std::shared_ptr<const arrays::matrix<dcomplex>>> T_cache;
+   constexpr size_t T_cache_max_size = 16;
+  }
 
-  // Use the transformation matrix
-  for (auto om : gw.mesh()) {
-   for (auto l : gl.mesh()) {
-    gw[om] += legendre_T(om.index(), l.index()) * gl[l];
-   }
+  std::shared_ptr<const arrays::matrix<dcomplex>> legendre_T_matrix(long n_first, long n_last, long n_l) {
+   auto key = std::make_tuple(n_first, n_last, n_l);
+   std::lock_guard<std::mutex> lock(T_mutex);
+   auto it = T_cache.find(key);
+   if (it != T_cache.end()) return it->second;
+
+   // T_{-n-1,l} = T_{nl}^* : the rows n >= 0 are computed once.
+   long n_pos = std::max(n_last + 1, -n_first);
+   arrays::matrix<dcomplex> T_pos(std::max(n_pos, 0l), n_l);
+   for (long n = 0; n < n_pos; ++n)
+    for (long l = 0; l < n_l; ++l) T_pos(n, l) = legendre_T(n, l);
+
+   auto T = std::make_shared<arrays::matrix<dcomplex>>(n_last - n_first + 1, n_l);
+   for (long n = n_first; n <= n_last; ++n)
+    for (long l = 0; l < n_l; ++l) (*T)(n - n_first, l) = (n >= 0 ? T_pos(n, l) : std::conj(T_pos(-n - 1, l)));
+
+   if (T_cache.size() >= T_cache_max_size) T_cache.clear();
+   T_cache.emplace(key, T);
+   return T;
   }
 
+  size_t legendre_T_matrix_cache_size() {
+   std::lock_guard<std::mutex> lock(T_mutex);
+   return T_cache.size();
+  }
+ }
+
+ // ----------------------------
+
+ void legendre_matsubara_direct(gf_view<imfreq> gw, gf_const_view<legendre> gl) {
+
+  auto const &m = gw.mesh();
+  auto T = details::legendre_T_matrix(m.first_index_window(), m.last_index_window(), gl.mesh().size());
+
+  // G(i omega_n) = sum_l T_nl G_l : one matrix product for all the elements
+  arrays::array<dcomplex, 2> cw, cl;
+  auto vw = details::as_mesh_element(gw.data(), cw);
+  auto rw = arrays::matrix_view<dcomplex>{vw};
+  arrays::blas::gemm(1.0, *T, arrays::matrix_view<dcomplex>{details::as_mesh_element(gl.data(), cl)}, 0.0, rw);
+  details::copy_back(gw.data(), vw, cw);
+
   gw.singularity() = get_tail(gl, gw.singularity().size(), gw.singularity().order_min());
  }
 
  // ----------------------------
 
- void legendre_matsubara_direct(gf_view<imtime> gt, gf_const_view<legendre> gl) {
+ namespace {
 
-  gt() = 0.0;
-  legendre_generator L;
+  // The imtime <-> Legendre transforms are done by blocks of tau_block points :
+  // the (n_l, tau_block) block of the basis P_l(x(tau)) stays in cache.
+  constexpr long tau_block = 256;
 
-  for (auto t : gt.mesh()) {
-   L.reset(2 * t / gt.domain().beta - 1);
-   for (auto l : gl.mesh()) {
-    gt[t] += sqrt(2 * l.index() + 1) / gt.domain().beta * gl[l] * L.next();
-   }
+  // P_l(2 tau / beta - 1) for the points k0 <= k < k0 + p.shape()[1] of the mesh
+  void fill_basis(arrays::matrix<double> &p, gf_mesh<imtime> const &m, long k0) {
+   long nb = p.shape()[1];
+   std::vector<double> x(nb);
+   for (long k = 0; k < nb; ++k) x[k] = 2 * m.index_to_point(k0 + k) / m.domain().beta - 1;
+   legendre_basis(x.data(), nb, p.shape()[0], p.data_start());
+  }
+ }
+
+ // ----------------------------
+
+ void legendre_matsubara_direct(gf_view<imtime> gt, gf_const_view<legendre> gl) {
+
+  auto const &m = gt.mesh();
+  double beta = gt.domain().beta;
+  long n_t = m.size(), n_l = gl.mesh().size(), n1 = gt.data().shape()[1], n2 = gt.data().shape()[2];
+
+  // G(tau) = sum_l sqrt(2l+1) / beta P_l(x(tau)) G_l.
+  // As a product of real matrices, with the real and imaginary parts of the elements as columns of C.
+  arrays::matrix<double> C(n_l, 2 * n1 * n2);
+  for (long l = 0; l < n_l; ++l)
+   for (long i = 0; i < n1; ++i)
+    for (long j = 0; j < n2; ++j) {
+     dcomplex z = std::sqrt(2 * l + 1) / beta * gl.data()(l, i, j);
+     C(l, 2 * (i * n2 + j)) = z.real();
+     C(l, 2 * (i * n2 + j) + 1) = z.imag();
+    }
+
+  arrays::matrix<double> P, R;
+  for (long k0 = 0; k0 < n_t; k0 += tau_block) {
+   long nb = std::min(tau_block, n_t - k0);
+   P.resize(arrays::make_shape(n_l, nb));
+   R.resize(arrays::make_shape(nb, 2 * n1 * n2));
+   fill_basis(P, m, k0);
+   arrays::blas::gemm(1.0, P.transpose(), C, 0.0, R);
+   for (long k = 0; k < nb; ++k)
+    for (long i = 0; i < n1; ++i)
+     for (long j = 0; j < n2; ++j) gt.data()(k0 + k, i, j) = dcomplex(R(k, 2 * (i * n2 + j)), R(k, 2 * (i * n2 + j) + 1));
   }
 
   gt.singularity() = get_tail(gl, gt.singularity().size(), gt.singularity().order_min());
@@ -67,38 +143,79 @@ namespace gfs {
 
  void legendre_matsubara_inverse(gf_view<legendre> gl, gf_const_view<imtime> gt) {
 
-  gl() = 0.0;
-  legendre_generator L;
-  auto N = gt.mesh().size() - 1;
-  double coef;
-
-  // Do the integral over imaginary time
-  for (auto t : gt.mesh()) {
-   if (t.index()==0 || t.index()==N) coef = 0.5;
-   else coef = 1.0;
-   L.reset(2 * t / gt.domain().beta - 1);
-   for (auto l : gl.mesh()) {
-    gl[l] += coef * sqrt(2 * l.index() + 1) * L.next() * gt[t];
+  auto const &m = gt.mesh();
+  long n_t = m.size(), n_l = gl.mesh().size(), n1 = gt.data().shape()[1], n2 = gt.data().shape()[2];
+
+  // G_l = sqrt(2l+1) int_0^beta dtau P_l(x(tau)) G(tau), by the trapezoidal rule.
+  // The sum on tau is a product of real matrices, with the real and imaginary parts of the elements as columns.
+  arrays::matrix<double> P, A, Gl(n_l, 2 * n1 * n2);
+  Gl() = 0;
+  for (long k0 = 0; k0 < n_t; k0 += tau_block) {
+   long nb = std::min(tau_block, n_t - k0);
+   P.resize(arrays::make_shape(n_l, nb));
+   A.resize(arrays::make_shape(nb, 2 * n1 * n2));
+   fill_basis(P, m, k0);
+   for (long k = 0; k < nb; ++k) {
+    double w = (k0 + k == 0 || k0 + k == n_t - 1 ? 0.5 : 1.0) * m.delta();
+    for (long i = 0; i < n1; ++i)
+     for (long j = 0; j < n2; ++j) {
+      dcomplex z = w * gt.data()(k0 + k, i, j);
+      A(k, 2 * (i * n2 + j)) = z.real();
+      A(k, 2 * (i * n2 + j) + 1) = z.imag();
+     }
    }
+   arrays::blas::gemm(1.0, P, A, 1.0, Gl);
   }
-  gl.data() *= gt.mesh().delta();
+  for (long l = 0; l < n_l; ++l)
+   for (long i = 0; i < n1; ++i)
+    for (long j = 0; j < n2; ++j)
+     gl.data()(l, i, j) = std::sqrt(2 * l + 1) * dcomplex(Gl(l, 2 * (i * n2 + j)), Gl(l, 2 * (i * n2 + j) + 1));
  }
 
  // ----------------------------
 
  void legendre_matsubara_inverse(gf_view<legendre> gl, gf_const_view<imfreq> gw) {
 
-  gl() = 0.0;
-
-  // Construct a temporary imaginary-time Green's function gt
-  // I set Nt time bins. This is ugly, one day we must code the direct
-  // transformation without going through imaginary time
-  int Nt = 50000;
-  auto gt = gf<imtime>{{gw.domain(), Nt}, gw.data().shape().front_pop()};
-
-  // We first transform to imaginary time because it's been coded with the knowledge of the tails
-  gt() = inverse_fourier(gw);
-  legendre_matsubara_inverse(gl, gt());
+  // legendre_T is for fermions : the bosonic functions go through imaginary time
+  if (gw.domain().statistic == Boson) {
+   int Nt = 50000;
+   auto gt = gf<imtime>{{gw.domain(), Nt}, gw.data().shape().front_pop()};
+   gt() = inverse_fourier(gw);
+   legendre_matsubara_inverse(gl, gt());
+   return;
+  }
+  if (gw.mesh().positive_only())
+   TRIQS_RUNTIME_ERROR << "Legendre : only implemented for g(i omega_n) with full mesh (positive and negative frequencies)";
+
+  double beta = gw.domain().beta;
+  auto _ = arrays::range{};
+  auto const &m = gw.mesh();
+  long n_w = m.size(), n_l = gl.mesh().size(), n1 = gw.data().shape()[1], n2 = gw.data().shape()[2];
+  auto T = details::legendre_T_matrix(m.first_index_window(), m.last_index_window(), n_l);
+
+  // G_l = sum_n T_nl^* G(i omega_n).
+  // The sum is done on G minus the tail model c1/iw + c2/(iw)^2 + c3/(iw)^3, which decays fast enough.
+  // With R the conjugate of this residue, G_l^* = (T^t R)_l : one matrix product for all the elements.
+  auto const &ta = gw.singularity();
+  auto c1 = ta.get_or_zero(1), c2 = ta.get_or_zero(2), c3 = ta.get_or_zero(3);
+  arrays::matrix<dcomplex> R(n_w, n1 * n2);
+  for (long k = 0; k < n_w; ++k) {
+   dcomplex z = 1 / dcomplex(m.index_to_point(m.linear_to_index(k)));
+   auto g = gw.data()(k, _, _);
+   for (long i = 0; i < n1; ++i)
+    for (long j = 0; j < n2; ++j) R(k, i * n2 + j) = std::conj(g(i, j) - z * (c1(i, j) + z * (c2(i, j) + z * c3(i, j))));
+  }
+  arrays::matrix<dcomplex> Gl(n_l, n1 * n2);
+  arrays::blas::gemm(1.0, T->transpose(), R, 0.0, Gl);
+  for (long l = 0; l < n_l; ++l)
+   for (long i = 0; i < n1; ++i)
+    for (long j = 0; j < n2; ++j) gl.data()(l, i, j) = std::conj(Gl(l, i * n2 + j));
+
+  // In imaginary time, the tail model is -c1/2 + c2 (2 tau - beta)/4 + c3 tau (beta - tau)/4 :
+  // its Legendre coefficients are 0 for l > 2.
+  if (n_l > 0) gl.data()(0, _, _) += -beta / 2 * c1 + beta * beta * beta / 24 * c3;
+  if (n_l > 1) gl.data()(1, _, _) += std::sqrt(3.0) * beta * beta / 12 * c2;
+  if (n_l > 2) gl.data()(2, _, _) += -std::sqrt(5.0) * beta * beta * beta / 120 * c3;
  }
 
 
@@ -25,6 +25,7 @@
 #include "../imfreq.hpp"
 #include "../imtime.hpp"
 #include "../legendre.hpp"
+#include <memory>
 
 namespace triqs {
 namespace gfs {
@@ -50,6 +51,18 @@ namespace gfs {
  void triqs_gf_view_assign_delegation(gf_view<imtime> gt, gf_keeper<tags::legendre, legendre> const &L);
  void triqs_gf_view_assign_delegation(gf_view<legendre> gl, gf_keeper<tags::legendre, imfreq> const &L);
  void triqs_gf_view_assign_delegation(gf_view<legendre> gl, gf_keeper<tags::legendre, imtime> const &L);
+
+ namespace details {
+
+  /**
+   * The matrix T_nl, at row n - n_first, for the Matsubara indices n_first <= n <= n_last and 0 <= l < n_l.
+   * It is computed once for each (n_first, n_last, n_l) and cached. Thread safe.
+   */
+  std::shared_ptr<const arrays::matrix<dcomplex>> legendre_T_matrix(long n_first, long n_last, long n_l);
+
+  /// Number of cached T_nl matrices
+  size_t legendre_T_matrix_cache_size();
+ }
 }
 }
 #endif
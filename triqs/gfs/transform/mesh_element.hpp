@@ -0,0 +1,59 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2014 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/arrays.hpp>
+
+namespace triqs {
+namespace gfs {
+ namespace details {
+
+  /**
+   * The data (mesh, n1, n2) of a matrix valued gf as a (mesh, n1 * n2) array, as used by the transforms
+   * which treat all the elements at once. A view if the target indices can be merged, a copy in copy
+   * otherwise (e.g. for a slice).
+   */
+  template <typename A> arrays::array_view<dcomplex, 2> as_mesh_element(A &&a, arrays::array<dcomplex, 2> &copy) {
+   auto const &im = a.indexmap();
+   long n0 = im.lengths()[0], n1 = im.lengths()[1], n2 = im.lengths()[2];
+   if (im.strides()[1] == n2 * im.strides()[2]) {
+    using v_t = arrays::array_view<dcomplex, 2>;
+    return v_t{typename v_t::indexmap_type(arrays::make_shape(n0, n1 * n2), arrays::make_shape(im.strides()[0], im.strides()[2]),
+                                           im.start_shift()),
+               a.storage()};
+   }
+   copy.resize(arrays::make_shape(n0, n1 * n2));
+   for (long k = 0; k < n0; ++k)
+    for (long i = 0; i < n1; ++i)
+     for (long j = 0; j < n2; ++j) copy(k, i * n2 + j) = a(k, i, j);
+   return copy;
+  }
+
+  /// Copies back the result, if as_mesh_element made a copy
+  inline void copy_back(arrays::array_view<dcomplex, 3> a, arrays::array_view<dcomplex, 2> v, arrays::array<dcomplex, 2> const &copy) {
+   if (v.data_start() != copy.data_start()) return;
+   long n0 = a.shape()[0], n1 = a.shape()[1], n2 = a.shape()[2];
+   for (long k = 0; k < n0; ++k)
+    for (long i = 0; i < n1; ++i)
+     for (long j = 0; j < n2; ++j) a(k, i, j) = copy(k, i * n2 + j);
+  }
+ }
+}
+}
@@ -1,5 +1,6 @@
 #include "./group.hpp"
 #include "./base.hpp"
+#include <algorithm>
 
 namespace triqs {
 namespace h5 {
@@ -47,7 +48,7 @@ namespace h5 {
   if (!has_key(key)) TRIQS_RUNTIME_ERROR << "no subgroup " << key << " in the group";
   hid_t sg = H5Gopen2(id, key.c_str(), H5P_DEFAULT);
   if (sg < 0) TRIQS_RUNTIME_ERROR << "Error in opening the subgroup " << key;
-  return group(sg);
+  return group(sg).with_storage(_storage);
  }
 
  /// Open an existing DataSet. Throw if it does not exist.
@@ -67,7 +68,48 @@ namespace h5 {
   unlink_key_if_exists(key);
   hid_t id_g = H5Gcreate2(id, key.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
   if (id_g < 0) TRIQS_RUNTIME_ERROR << "Cannot create the subgroup " << key << " of the group" << name();
-  return group(id_g);
+  return group(id_g).with_storage(_storage);
+ }
+
+ //----------------------------------------------------------
+
+ std::vector<hsize_t> chunk_shape(std::vector<hsize_t> const &dims, size_t element_size, size_t chunk_bytes) {
+  std::vector<hsize_t> chunk(dims.size(), 1);
+  hsize_t n_elements = std::max(chunk_bytes / element_size, size_t(1)); // the number of elements in a chunk
+  for (int u = int(dims.size()) - 1; u >= 0; --u) {
+   if (dims[u] <= n_elements) {
+    chunk[u] = std::max(dims[u], hsize_t(1));
+    n_elements /= chunk[u];
+   } else { // cut this dimension, and keep 1 for the first ones
+    chunk[u] = n_elements;
+    break;
+   }
+  }
+  return chunk;
+ }
+
+ // The creation property list of a dataset of type ty and space sp, according to the storage policy s.
+ // H5P_DEFAULT for a contiguous dataset.
+ static proplist dataset_creation_proplist(dataset_storage const &s, datatype const &ty, dataspace const &sp) {
+  if (!s.chunked) return H5P_DEFAULT;
+  int rank = H5Sget_simple_extent_ndims(sp);
+  if (rank <= 0) return H5P_DEFAULT; // scalar
+  std::vector<hsize_t> dims(rank);
+  H5Sget_simple_extent_dims(sp, dims.data(), NULL);
+  size_t element_size = H5Tget_size(ty);
+  hsize_t n_elements = 1;
+  for (auto d : dims) n_elements *= d;
+  if ((n_elements == 0) || (n_elements * element_size < s.min_bytes)) return H5P_DEFAULT;
+
+  proplist pl = H5Pcreate(H5P_DATASET_CREATE);
+  auto chunk = chunk_shape(dims, element_size, s.chunk_bytes);
+  if (H5Pset_chunk(pl, rank, chunk.data()) < 0) TRIQS_RUNTIME_ERROR << "Cannot set the chunks of the dataset";
+  if (s.shuffle && (H5Pset_shuffle(pl) < 0)) TRIQS_RUNTIME_ERROR << "Cannot set the shuffle filter";
+  if (s.deflate_level > 0) {
+   if (!H5Zfilter_avail(H5Z_FILTER_DEFLATE)) TRIQS_RUNTIME_ERROR << "The deflate filter is not available in this hdf5 library";
+   if (H5Pset_deflate(pl, std::min(s.deflate_level, 9)) < 0) TRIQS_RUNTIME_ERROR << "Cannot set the deflate filter";
+  }
+  return pl;
  }
 
  /**
@@ -78,7 +120,8 @@ namespace h5 {
   */
  dataset group::create_dataset(std::string const &key, datatype ty, dataspace sp, hid_t pl) const {
   unlink_key_if_exists(key);
-  dataset ds = H5Dcreate2(id, key.c_str(), ty, sp, H5P_DEFAULT, pl, H5P_DEFAULT);
+  proplist cparms = (pl == H5P_DEFAULT ? dataset_creation_proplist(_storage, ty, sp) : h5_object::from_borrowed(pl));
+  dataset ds = H5Dcreate2(id, key.c_str(), ty, sp, H5P_DEFAULT, cparms, H5P_DEFAULT);
   if (!ds.is_valid()) TRIQS_RUNTIME_ERROR << "Cannot create the dataset " << key << " in the group" << name();
   return ds;
  }
@@ -20,16 +20,55 @@
  ******************************************************************************/
 #pragma once
 #include "./file.hpp"
+#include <vector>
 
 namespace triqs {
 namespace h5 {
 
+ /**
+  * Storage policy of the datasets created in a group.
+  *
+  * By default, the datasets are contiguous and uncompressed.
+  * A chunked dataset is cut into chunks of about chunk_bytes bytes, keeping the last dimensions whole
+  * (for a gf, the target indices, and the real/imaginary part), and cutting the first ones (the mesh).
+  * The chunks can then be compressed with the standard shuffle and deflate (gzip) filters,
+  * which any hdf5 reader (h5_read, h5py, HDFArchive, h5dump) decodes transparently.
+  */
+ struct dataset_storage {
+  bool chunked = false;             // false : contiguous. The filters require chunked = true
+  size_t chunk_bytes = 1 << 20;     // target size of a chunk in bytes
+  bool shuffle = false;             // byte shuffle before the compression (better ratio for floating point numbers)
+  int deflate_level = 0;            // 0 : no compression, 1-9 : gzip compression level
+  size_t min_bytes = 1 << 14;       // smaller datasets are contiguous, whatever the policy
+ };
+
+ /// The default : contiguous, uncompressed
+ inline dataset_storage contiguous_storage() { return {}; }
+
+ /// Chunked, shuffled and compressed with deflate
+ inline dataset_storage compressed_storage(int deflate_level = 4, size_t chunk_bytes = 1 << 20) {
+  dataset_storage s;
+  s.chunked = true;
+  s.chunk_bytes = chunk_bytes;
+  s.shuffle = true;
+  s.deflate_level = deflate_level;
+  return s;
+ }
+
+ /**
+  * The chunk shape of a dataset of dimensions dims, with elements of element_size bytes.
+  * The last dimensions are kept whole as long as the chunk is smaller than chunk_bytes, the next one is cut,
+  * the first ones are 1.
+  */
+ std::vector<hsize_t> chunk_shape(std::vector<hsize_t> const &dims, size_t element_size, size_t chunk_bytes);
+
  /**
   *  \brief A local derivative of Group.
   *  Rationale : use ADL for h5_read/h5_write, catch and rethrow exception, add some policy for opening/creating
   */
  class group : public h5_object {
   void _write_triqs_hdf5_data_scheme(const char *a); // impl.
+  dataset_storage _storage;
 
   public:
   group() = default; // for python converter only
@@ -54,6 +93,19 @@ namespace h5 {
   /// Name of the group
   std::string name() const;
 
+  /// The storage policy of the datasets created in this group, and in its subgroups opened or created from it
+  dataset_storage const &storage() const { return _storage; }
+
+  /// Change the storage policy of this group
+  void set_storage(dataset_storage const &s) { _storage = s; }
+
+  /// A copy of the group with another storage policy, e.g. h5_write(g.with_storage(compressed_storage()), "G", G)
+  group with_storage(dataset_storage const &s) const {
+   group r = *this;
+   r._storage = s;
+   return r;
+  }
+
   ///  Write the triqs tag of the group if it is an object.
   template <typename T> void write_triqs_hdf5_data_scheme(T const &obj) {
    _write_triqs_hdf5_data_scheme(get_triqs_hdf5_data_scheme(obj).c_str());
@@ -86,6 +138,7 @@ namespace h5 {
    * \param key The name of the subgroup
    *
    * NB : It unlinks the dataset if it exists.
+   * With the default creation property list pl, the dataset is created according to the storage policy of the group.
    */
   dataset create_dataset(std::string const &key, datatype ty, dataspace sp, hid_t pl = H5P_DEFAULT) const;
 
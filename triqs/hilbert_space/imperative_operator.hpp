@@ -22,6 +22,7 @@
 #include "./fundamental_operator_set.hpp"
 #include "../operators/many_body_operator.hpp"
 #include "./hilbert_space.hpp"
+#include "./state.hpp"
 
 #include <vector>
 #include <utility>
@@ -129,14 +130,111 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
  /**
    The callable object must take one argument convertible to `ScalarType &`
 
+   The matrices precomputed by `compile()` are discarded.
+
    @tparam Lambda Type of the callable object
    @param L Callable object
   */
  template<typename Lambda> void update_coeffs(Lambda L) {
   for(auto & M : all_terms) L(M.coeff);
+  compiled_blocks.clear();
+ }
+
+ /// Precompute the matrices of the operator (UseMap = true)
+ /**
+   The matrices from each subspace of the connection map to its target subspace are computed once,
+   in compressed sparse row format. Applying the operator on a [[state]] with `BasedOnMap = false`
+   (without extra arguments) is then a sparse matrix-vector product, with precomputed signs and target indices.
+   Only for a non-callable `ScalarType`.
+  */
+ template <bool U = UseMap> std14::enable_if_t<U> compile() {
+  compiled_blocks.clear();
+  compiled_blocks.resize(hilbert_map.size());
+  for (size_t n = 0; n < hilbert_map.size(); ++n)
+   if (hilbert_map[n] != -1) compiled_blocks[n] = make_compiled_block((*sub_spaces)[n], (*sub_spaces)[hilbert_map[n]]);
+ }
+
+ /// Precompute the matrix of the operator on a Hilbert space (UseMap = false)
+ /**
+   Same as `compile()`, for the states of `hs`, which must outlive the operator.
+
+   @tparam HS Hilbert space type
+   @param hs Hilbert space of the states the operator is applied to
+  */
+ template <typename HS, bool U = UseMap> std14::enable_if_t<!U> compile(HS const &hs) {
+  compiled_blocks.clear();
+  compiled_blocks.push_back(make_compiled_block(hs, hs));
  }
 
+ /// Are the matrices of the operator precomputed ?
+ bool is_compiled() const { return !compiled_blocks.empty(); }
+
  private:
+ // Matrix of the operator from the states of a space to the states of its target space, by rows (CSR)
+ struct compiled_block_t {
+  void const *source = nullptr; // the space of the initial states
+  std::vector<int> row_start;   // the elements of row j are in [row_start[j], row_start[j+1][
+  std::vector<int> col;
+  std::vector<scalar_t> val;
+ };
+ // UseMap : one block per subspace (empty if it is mapped to nothing), otherwise one block
+ std::vector<compiled_block_t> compiled_blocks;
+
+ template <typename HS1, typename HS2> compiled_block_t make_compiled_block(HS1 const &source, HS2 const &target) const {
+  struct element_t {
+   int row, col;
+   scalar_t val;
+  };
+  std::vector<element_t> elements;
+  for (int i = 0; i < source.size(); ++i)
+   foreach_connection_impl(source, target, i, [&elements, i](int j, scalar_t v) { elements.push_back({j, i, v}); });
+  // by rows, the contributions of the terms to the same element in the order of the terms
+  std::stable_sort(elements.begin(), elements.end(),
+                   [](element_t const &a, element_t const &b) { return a.row < b.row || (a.row == b.row && a.col < b.col); });
+
+  compiled_block_t b;
+  b.source = &source;
+  b.row_start.assign(target.size() + 1, 0);
+  for (auto it = elements.begin(); it != elements.end();) {
+   int row = it->row, col = it->col;
+   scalar_t v = it->val;
+   while (++it != elements.end() && it->row == row && it->col == col) v += it->val;
+   b.col.push_back(col);
+   b.val.push_back(v);
+   ++b.row_start[row + 1];
+  }
+  for (int j = 0; j < target.size(); ++j) b.row_start[j + 1] += b.row_start[j];
+  return b;
+ }
+
+ // The compiled block for the initial state st, or nullptr
+ template <typename StateType> compiled_block_t const *get_compiled_block(StateType const &st, std::true_type use_map) const {
+  auto n = st.get_hilbert().get_index();
+  return ((n >= 0 && size_t(n) < compiled_blocks.size()) ? &compiled_blocks[n] : nullptr);
+ }
+
+ template <typename StateType> compiled_block_t const *get_compiled_block(StateType const &st, std::false_type use_map) const {
+  if (compiled_blocks.empty() || compiled_blocks[0].source != &st.get_hilbert()) return nullptr;
+  return &compiled_blocks[0];
+ }
+
+ // target = M st, for the states based on vectors
+ template <typename HS, typename S>
+ static bool apply_compiled_block(compiled_block_t const &b, state<HS, S, false> const &st, state<HS, S, false> &target) {
+  S const *x = st.amplitudes().data_start();
+  S *y = target.amplitudes().data_start();
+  int const *col = b.col.data();
+  scalar_t const *val = b.val.data();
+  for (int j = 0; j < int(b.row_start.size()) - 1; ++j) {
+   S r = 0;
+   for (int k = b.row_start[j]; k < b.row_start[j + 1]; ++k) r += val[k] * x[col[k]];
+   y[j] = r;
+  }
+  return true;
+ }
+
+ template <typename StateType> static bool apply_compiled_block(compiled_block_t const &, StateType const &, StateType &) { return false; }
+
  template <typename StateType> StateType get_target_st(StateType const &st, std::true_type use_map) const {
   auto n = hilbert_map[st.get_hilbert().get_index()];
   if (n == -1) return StateType{};
@@ -149,8 +247,8 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
 
  static bool parity_number_of_bits(uint64_t v) {
   // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetNaive
-  // v ^= v >> 16;
-  // only ok until 16 orbitals ! assert this or put the >> 16
+  v ^= v >> 32;
+  v ^= v >> 16;
   v ^= v >> 8;
   v ^= v >> 4;
   v ^= v >> 2;
@@ -158,6 +256,17 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
   return v & 0x01;
  }
 
+ // Act with the monomial M on the Fock state f.
+ // Returns false if the result vanishes, otherwise f is the resulting Fock state and minus the sign.
+ static bool act_on_fock_state(one_term_t const &M, fock_state_t &f, bool &minus) {
+  if ((f & M.d_mask) != M.d_mask) return false;
+  fock_state_t f2 = f & ~M.d_mask;
+  if (((f2 ^ M.dag_mask) & M.dag_mask) != M.dag_mask) return false;
+  f = ~(~f2 & ~M.dag_mask);
+  minus = parity_number_of_bits((f2 & M.d_count_mask) ^ (f & M.dag_count_mask));
+  return true;
+ }
+
   // Forward the call to the coefficient
 #ifdef GCC_BUG_41933_WORKAROUND
  template<typename... Args>
@@ -197,6 +306,12 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
  StateType operator()(StateType const &st, Args&&... args) const {
 
   StateType target_st = get_target_st(st, std::integral_constant<bool, UseMap>());
+
+  if (sizeof...(Args) == 0 && !compiled_blocks.empty()) {
+   auto b = get_compiled_block(st, std::integral_constant<bool, UseMap>());
+   if (b && b->source && apply_compiled_block(*b, st, target_st)) return target_st;
+  }
+
   auto const& hs = st.get_hilbert();
 
 #ifdef GCC_BUG_41933_WORKAROUND
@@ -210,12 +325,9 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
 #else
    foreach(st, [M, &target_st,hs,args...](int i, typename StateType::value_type amplitude) {
 #endif
-    fock_state_t f2 = hs.get_fock_state(i);
-    if ((f2 & M.d_mask) != M.d_mask) return;
-    f2 &= ~M.d_mask;
-    if (((f2 ^ M.dag_mask) & M.dag_mask) != M.dag_mask) return;
-    fock_state_t f3 = ~(~f2 & ~M.dag_mask);
-    auto sign_is_minus = parity_number_of_bits((f2 & M.d_count_mask) ^ (f3 & M.dag_count_mask));
+    fock_state_t f3 = hs.get_fock_state(i);
+    bool sign_is_minus;
+    if (!act_on_fock_state(M, f3, sign_is_minus)) return;
     // update state vector in target Hilbert space
     auto ind = target_st.get_hilbert().get_state_index(f3);
 #ifdef GCC_BUG_41933_WORKAROUND
@@ -227,5 +339,38 @@ template <typename HilbertType, typename ScalarType = double, bool UseMap = fals
   }
   return target_st;
  }
+
+ /// Apply a callable object to the action of each monomial on a basis state
+ /**
+   For the `i`-th basis state of `hs`, calls `L(j, value)` for each monomial which does not annihilate it,
+   with `j` the index in `hs` of the resulting basis state and `value` the coefficient of the monomial with its sign.
+   Several monomials can lead to the same `j` : the matrix element is then the sum of their values.
+   No state is built, so the non-vanishing matrix elements of a row are found in O(number of monomials).
+   Only available for `UseMap = false` and a non-callable `ScalarType`.
+
+   @tparam HS Hilbert space type
+   @tparam Lambda Type of the callable object
+   @param hs Hilbert space of both the initial and final basis states
+   @param i Index of the initial basis state
+   @param L Callable object
+  */
+ template <typename HS, typename Lambda, bool U = UseMap>
+ auto foreach_connection(HS const &hs, int i, Lambda L) const
+     -> std14::enable_if_t<!U, decltype(void(L(0, std::declval<scalar_t>() * 1.0)))> {
+  foreach_connection_impl(hs, hs, i, L);
+ }
+
+ private:
+ template <typename HS1, typename HS2, typename Lambda>
+ void foreach_connection_impl(HS1 const &source, HS2 const &target, int i, Lambda L) const {
+  auto f_i = source.get_fock_state(i);
+  for (auto const &M : all_terms) {
+   fock_state_t f = f_i;
+   bool sign_is_minus;
+   if (!act_on_fock_state(M, f, sign_is_minus)) continue;
+   if (!target.has_state(f)) continue;
+   L(target.get_state_index(f), M.coeff * (sign_is_minus ? -1.0 : 1.0));
+  }
+ }
 };
 }}
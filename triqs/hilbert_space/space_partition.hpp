@@ -23,13 +23,29 @@
 
 #include <set>
 #include <map>
+#include <vector>
 #include <utility>
+#include <algorithm>
+#include <type_traits>
 #include <triqs/utility/numeric_ops.hpp>
 #include <boost/pending/disjoint_sets.hpp>
 
 namespace triqs {
 namespace hilbert_space {
 
+namespace details {
+ struct ignore_connection {
+  template <typename... T> void operator()(T &&...) const {}
+ };
+
+ // Does the operator enumerate its matrix elements on basis states, as imperative_operator::foreach_connection ?
+ template <typename OperatorType, typename HilbertSpace, typename = void> struct has_foreach_connection : std::false_type {};
+ template <typename OperatorType, typename HilbertSpace>
+ struct has_foreach_connection<OperatorType, HilbertSpace,
+                               decltype(std::declval<OperatorType const &>().foreach_connection(std::declval<HilbertSpace const &>(), 0,
+                                                                                                ignore_connection{}))> : std::true_type {};
+}
+
 /// Implementation of the automatic partitioning algorithm
 /**
   Partitions a Hilbert space into a set of subspaces invariant under action of a given Hermitian operator (Hamiltonian).
@@ -38,7 +54,10 @@ namespace hilbert_space {
   `Computer Physics Communications 200, March 2016, 274-284 <http://dx.doi.org/10.1016/j.cpc.2015.10.023>`_ (section 4.2).
 
   @tparam StateType Many-body state type, must model [[statevector_concept]]
-  @tparam OperatorType Imperative operator type, must provide `StateType operator()(StateType const&)`
+  @tparam OperatorType Imperative operator type, must provide `StateType operator()(StateType const&)`.
+          If it also provides `foreach_connection(hilbert_space, index, callable)`, as [[imperative_operator]],
+          the matrix elements are enumerated directly from the basis states, in O(dim * number of monomials),
+          instead of acting on a full state for each basis state, in O(dim^2).
  */
 template <typename StateType, typename OperatorType> class space_partition {
 
@@ -71,20 +90,14 @@ template <typename StateType, typename OperatorType> class space_partition {
 
   // Iteration over all initial basis states
   for (index_t i = 0; i < size; ++i) {
-   tmp_state(i) = amplitude_t(1.0);
-   state_t final_state = H(tmp_state);
-
-   // Iterate over non-zero final amplitudes
-   foreach(final_state, [&](index_t f, amplitude_t amplitude) {
-    using triqs::utility::is_zero;
-    if (is_zero(amplitude)) return;
+   // Iterate over non-zero matrix elements
+   foreach_matrix_element(H, i, [&](index_t f, amplitude_t amplitude) {
     auto i_subspace = subspaces.find_set(i);
     auto f_subspace = subspaces.find_set(f);
     if (i_subspace != f_subspace) subspaces.link(i_subspace, f_subspace);
 
     if (store_matrix_elements) matrix_elements[std::make_pair(i, f)] = amplitude;
    });
-   tmp_state(i) = amplitude_t(0.);
   }
 
   _update_index();
@@ -113,16 +126,12 @@ template <typename StateType, typename OperatorType> class space_partition {
 
   // Fill connection multimaps
   for (index_t i = 0; i < size; ++i) {
-   tmp_state(i) = amplitude_t(1.0);
    auto i_subspace = subspaces.find_set(i);
 
    auto fill_conn = [this,i,i_subspace,store_matrix_elements]
                     (operator_t const& op, std::multimap<index_t,index_t> & conn, matrix_element_map_t & elem) {
-    state_t final_state = op(tmp_state);
-    // Iterate over non-zero final amplitudes
-    foreach(final_state, [&](index_t f, amplitude_t amplitude) {
-     using triqs::utility::is_zero;
-     if (is_zero(amplitude)) return;
+    // Iterate over non-zero matrix elements
+    foreach_matrix_element(op, i, [&](index_t f, amplitude_t amplitude) {
      auto f_subspace = subspaces.find_set(f);
      conn.insert({i_subspace,f_subspace});
      if (store_matrix_elements) elem[{i, f}] = amplitude;
@@ -131,8 +140,6 @@ template <typename StateType, typename OperatorType> class space_partition {
 
    fill_conn(Cd,Cd_connections,Cd_elements);
    fill_conn(C,C_connections,C_elements);
-
-   tmp_state(i) = amplitude_t(0.);
   }
 
   // 'Zigzag' traversal algorithm
@@ -221,16 +228,10 @@ template <typename StateType, typename OperatorType> class space_partition {
 
   // Iteration over all initial basis states
   for (index_t i = 0; i < tmp_state.size(); ++i) {
-   state_t initial_state = tmp_state;
-   initial_state(i) = amplitude_t(1.0);
    auto i_subspace = subspaces.find_set(i);
 
-   state_t final_state = op(initial_state);
-
-   // Iterate over non-zero final amplitudes
-   foreach(final_state, [&](index_t f, amplitude_t amplitude) {
-    using triqs::utility::is_zero;
-    if (is_zero(amplitude)) return;
+   // Iterate over non-zero matrix elements
+   foreach_matrix_element(op, i, [&](index_t f, amplitude_t amplitude) {
     auto f_subspace = subspaces.find_set(f);
     if((!diagonal_only) || i_subspace==f_subspace)
       mapping.insert(std::make_pair(representative_to_index[i_subspace],
@@ -242,6 +243,40 @@ template <typename StateType, typename OperatorType> class space_partition {
  }
 
  private:
+ using hilbert_t = typename std::decay<decltype(std::declval<state_t const&>().get_hilbert())>::type;
+
+ // Calls L(f, amplitude) for the non-vanishing matrix elements <f|op|i>, by increasing f
+ template <typename Lambda> void foreach_matrix_element(operator_t const& op, index_t i, Lambda L) {
+  using triqs::utility::is_zero;
+  foreach_matrix_element_impl(op, i, [&L](index_t f, amplitude_t amplitude) {
+   if (!is_zero(amplitude)) L(f, amplitude);
+  }, details::has_foreach_connection<operator_t, hilbert_t>{});
+ }
+
+ // From the terms of the operator acting on the basis state i
+ template <typename Lambda> void foreach_matrix_element_impl(operator_t const& op, index_t i, Lambda L, std::true_type) {
+  connections.clear();
+  op.foreach_connection(tmp_state.get_hilbert(), i,
+                        [this](index_t f, amplitude_t amplitude) { connections.emplace_back(f, amplitude); });
+  // Sum the contributions to the same final state, in the order of the terms
+  std::stable_sort(connections.begin(), connections.end(),
+                   [](std::pair<index_t, amplitude_t> const& a, std::pair<index_t, amplitude_t> const& b) { return a.first < b.first; });
+  for (auto it = connections.begin(); it != connections.end();) {
+   auto f = it->first;
+   amplitude_t amplitude = it->second;
+   while (++it != connections.end() && it->first == f) amplitude += it->second;
+   L(f, amplitude);
+  }
+ }
+
+ // From the action of the operator on the state |i>
+ template <typename Lambda> void foreach_matrix_element_impl(operator_t const& op, index_t i, Lambda L, std::false_type) {
+  tmp_state(i) = amplitude_t(1.0);
+  state_t final_state = op(tmp_state);
+  tmp_state(i) = amplitude_t(0.);
+  foreach(final_state, L);
+ }
+
  void _update_index() {
   auto p = subspaces.parents();
   subspaces.compress_sets(p.begin(), p.end());  // parents are representatives
@@ -256,6 +291,8 @@ template <typename StateType, typename OperatorType> class space_partition {
 
  // Temporary zero state
  mutable state_t tmp_state;
+ // Temporary (final state, amplitude) of the terms of an operator acting on a basis state
+ std::vector<std::pair<index_t, amplitude_t>> connections;
  // Subspaces
  boost::disjoint_sets_with_storage<> subspaces;
  // Matrix elements of the Hamiltonian
@@ -233,6 +233,22 @@ public:
   double operator()() { return DBL_EPSILON+eval()*(1-2*DBL_EPSILON);} 
 
   double eval();
+
+  // The state of the generator
+  friend std::ostream &operator<<(std::ostream &out, RandMT const &g) {
+    out << g.seed_save << ' ' << g.initseed << ' ' << g.left << ' ' << (g.left > 0 ? g.next - g.state : 0); // next is used only if left > 0
+    for (int i = 0; i < N + 1; ++i) out << ' ' << g.state[i];
+    return out;
+  }
+
+  friend std::istream &operator>>(std::istream &in, RandMT &g) {
+    long n;
+    in >> g.seed_save >> g.initseed >> g.left >> n;
+    for (int i = 0; i < N + 1; ++i) in >> g.state[i];
+    if ((n < 0) || (n > N)) in.setstate(std::ios::failbit);
+    else g.next = g.state + n;
+    return in;
+  }
 // inline of this causes a BIG pb with g++ 4.1.2. WHY ?????
 //  inline double operator()() {
 //    return ((double)(randomMT())/0xFFFFFFFFU);
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "./checkpoint_writer.hpp"
+#include "../utility/exceptions.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace triqs {
+namespace mc_tools {
+
+ checkpoint_writer::checkpoint_writer(std::string file_name) : _file_name(std::move(file_name)), th([this]() { loop(); }) {}
+
+ checkpoint_writer::~checkpoint_writer() {
+  {
+   std::lock_guard<std::mutex> lock(mtx);
+   finish = true;
+  }
+  cv.notify_all();
+  th.join(); // the thread writes the pending snapshot before stopping
+ }
+
+ //---------------------------------------------
+
+ void checkpoint_writer::write_file(h5_writer_t const &w) {
+  std::string tmp = _file_name + ".tmp";
+  {
+   std::lock_guard<std::mutex> lock(h5_mutex());
+   h5::file f(tmp, 'w');
+   w(f);
+  }
+  // the file must be on disk before the rename, or a crash could leave an empty checkpoint
+  int fd = ::open(tmp.c_str(), O_RDONLY);
+  if (fd < 0) TRIQS_RUNTIME_ERROR << "checkpoint_writer : cannot open the file " << tmp << " : " << std::strerror(errno);
+  int r = ::fsync(fd);
+  int e = errno;
+  ::close(fd);
+  if (r != 0) TRIQS_RUNTIME_ERROR << "checkpoint_writer : cannot sync the file " << tmp << " : " << std::strerror(e);
+  if (std::rename(tmp.c_str(), _file_name.c_str()) != 0)
+   TRIQS_RUNTIME_ERROR << "checkpoint_writer : cannot rename " << tmp << " into " << _file_name;
+ }
+
+ void checkpoint_writer::loop() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+   cv.wait(lock, [this]() { return bool(pending) || finish; });
+   if (!pending) return; // finish, and nothing more to write
+   h5_writer_t w;
+   std::swap(w, pending);
+   writing = true;
+   lock.unlock();
+   std::exception_ptr err;
+   try {
+    write_file(w);
+   } catch (...) { err = std::current_exception(); }
+   w = nullptr; // frees the snapshot out of the lock
+   lock.lock();
+   writing = false;
+   if (err)
+    error = err;
+   else
+    ++_n_written;
+   cv.notify_all();
+  }
+ }
+
+ //---------------------------------------------
+
+ void checkpoint_writer::rethrow_error() { // called with mtx locked
+  if (!error) return;
+  auto e = error;
+  error = nullptr;
+  std::rethrow_exception(e);
+ }
+
+ void checkpoint_writer::write(h5_writer_t const &w) {
+  wait(); // the background thread uses the same temporary file
+  write_file(w);
+  std::lock_guard<std::mutex> lock(mtx);
+  ++_n_written;
+ }
+
+ void checkpoint_writer::push(h5_writer_t snapshot) {
+  {
+   std::lock_guard<std::mutex> lock(mtx);
+   rethrow_error();
+   std::swap(pending, snapshot); // the snapshot replaced, if any, is freed out of the lock
+  }
+  cv.notify_all();
+ }
+
+ void checkpoint_writer::wait() {
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this]() { return !pending && !writing; });
+  rethrow_error();
+ }
+
+ uint64_t checkpoint_writer::n_written() const {
+  std::lock_guard<std::mutex> lock(mtx);
+  return _n_written;
+ }
+
+ std::mutex &checkpoint_writer::h5_mutex() {
+  static std::mutex m;
+  return m;
+ }
+}
+}
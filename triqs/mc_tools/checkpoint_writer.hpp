@@ -0,0 +1,104 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2016 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/utility/first_include.hpp>
+#include <triqs/h5.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace triqs {
+namespace mc_tools {
+
+ /**
+  * Writes the checkpoints of a Monte Carlo, cf mc_generic::set_checkpoint.
+  *
+  * A checkpoint is written with h5 in a temporary file, synced on disk, then renamed :
+  * the file is always a complete checkpoint.
+  *
+  * write does it in the calling thread. push gives a snapshot of the checkpoint (a function writing a copy of
+  * the data) to a background thread, and returns immediately.
+  * Double buffer : one snapshot is being written, the next one waits. If push is called again before
+  * the writing of the waiting snapshot starts, it replaces it (only the last checkpoint matters).
+  *
+  * Since hdf5 is not thread safe in general, all the writings of checkpoints (of several Monte Carlo running
+  * in different threads, and in the background threads) are serialized by h5_mutex.
+  */
+ class checkpoint_writer {
+  public:
+  /// Writes a checkpoint in the root group of the file
+  using h5_writer_t = std::function<void(h5::group)>;
+
+  private:
+  std::string _file_name;
+  h5_writer_t pending;       // the next snapshot to write
+  bool writing = false;      // is the thread writing a snapshot ?
+  bool finish = false;       // the thread must stop
+  uint64_t _n_written = 0;   // number of checkpoints written
+  std::exception_ptr error;  // the error of the last background write, if any
+  mutable std::mutex mtx;
+  std::condition_variable cv;
+  std::thread th;
+
+  void loop();
+  void rethrow_error();
+  void write_file(h5_writer_t const &w); // h5 write in the temporary file, sync, rename
+
+  public:
+  /// @param file_name The name of the checkpoint file
+  checkpoint_writer(std::string file_name);
+
+  /// Waits for the writing of the last snapshot
+  ~checkpoint_writer();
+
+  checkpoint_writer(checkpoint_writer const &) = delete;
+  checkpoint_writer &operator=(checkpoint_writer const &) = delete;
+
+  /// Writes x in the group name of the checkpoint file, in the calling thread
+  template <typename T> void write(T const &x, std::string const &name) {
+   write(h5_writer_t{[&x, &name](h5::group g) { h5_write(g, name, x); }});
+  }
+
+  /// Writes the checkpoint with w, in the calling thread, after the background writings
+  void write(h5_writer_t const &w);
+
+  /// Gives the next snapshot to write to the background thread, and returns immediately.
+  /// Rethrows the error of a previous background write, if any.
+  void push(h5_writer_t snapshot);
+
+  /// Waits until all snapshots are written. Rethrows the error of a background write, if any.
+  void wait();
+
+  /// The name of the checkpoint file
+  std::string const &file_name() const { return _file_name; }
+
+  /// Number of checkpoints written so far
+  uint64_t n_written() const;
+
+  /// Serializes the calls to hdf5 of the checkpoints of several Monte Carlo running in different threads
+  static std::mutex &h5_mutex();
+ };
+}
+}
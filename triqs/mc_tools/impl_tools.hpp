@@ -22,6 +22,9 @@
 #include <triqs/utility/first_include.hpp>
 #include <triqs/h5.hpp>
 #include <string>
+#include <map>
+#include <functional>
+#include <memory>
 namespace triqs { namespace mc_tools {
 
  // mini concept checking
@@ -40,6 +43,9 @@ namespace triqs { namespace mc_tools {
  template<typename T, typename =void> struct has_collect_result : std::false_type {};
  template<typename T> struct has_collect_result < T, decltype(std::declval<T>().collect_results(std::declval<triqs::mpi::communicator>()))> : std::true_type {};
 
+ template<typename T, typename =void> struct has_merge : std::false_type {};
+ template<typename T> struct has_merge < T, decltype(std::declval<T&>().merge(std::declval<T const &>()))> : std::true_type {};
+
  // ----------------- h5 detection -----------------------
  using h5_rw_lambda_t = std::function<void(h5::group, std::string const &)>;
 
@@ -84,6 +90,32 @@ namespace triqs { namespace mc_tools {
 
 #endif 
 
+ // ----------------- snapshot detection -----------------------
+ // For the checkpoints written in the background (cf mc_generic::set_checkpoint).
+ // An object opts in with a method snapshot() const, which returns a copy of the data written by its h5_write
+ // (e.g. of its accumulators). This copy has a h5_write, which writes the same thing as the h5_write of the object.
+ // The snapshot is taken by the Monte Carlo thread, and written later by another thread.
+ //
+ // make_snapshot(p) returns a function taking the snapshot of *p, as the writer of the copy. It is
+ //  - empty if T has a h5 interface, but no snapshot method : no snapshot is possible;
+ //  - a function returning an empty writer if T has no h5 interface : there is nothing to write.
+ using h5_snapshot_lambda_t = std::function<h5_rw_lambda_t()>;
+
+ template <typename T, typename = void> struct has_snapshot : std::false_type {};
+ template <typename T> struct has_snapshot<T, decltype(void(std::declval<T const &>().snapshot()))> : std::true_type {};
+
+ template <typename T> h5_snapshot_lambda_t make_snapshot_impl(T const *p, std::true_type) {
+  return [p]() -> h5_rw_lambda_t {
+   auto s = std::make_shared<std14::decay_t<decltype(p->snapshot())>>(p->snapshot());
+   return [s](h5::group F, std::string const &Name) { h5_write(F, Name, *s); };
+  };
+ }
+ template <typename T> h5_snapshot_lambda_t make_snapshot_impl(T const *p, std::false_type) {
+  if (make_h5_write(p)) return {};
+  return []() { return h5_rw_lambda_t{}; };
+ }
+ template <typename T> h5_snapshot_lambda_t make_snapshot(T const *p) { return make_snapshot_impl(p, has_snapshot<T>{}); }
+
  // ----------------- collect_statistics detection -----------------------
  using collect_statistics_rw_lambda_t = std::function<void(mpi::communicator)>;
  
@@ -113,6 +145,20 @@ namespace triqs { namespace mc_tools {
  template <typename T> std::function<void(mpi::communicator)> make_collect_statistics(T *p) { return synth_collect_statistics<T>::invoke(p); }
 
 #endif 
+
+ // ----------------- get_acceptance_rates detection -----------------------
+ using acceptance_rates_lambda_t = std::function<std::map<std::string, double>()>;
+
+ template <typename T, typename = void> struct synth_acceptance_rates {
+  static acceptance_rates_lambda_t invoke(T *p) { return {}; }
+ };
+ template <typename T>
+ struct synth_acceptance_rates<T, decltype(void(std::declval<T const>().get_acceptance_rates()))> {
+  static acceptance_rates_lambda_t invoke(T *p) {
+   return [p]() { return p->get_acceptance_rates(); };
+  }
+ };
+ template <typename T> acceptance_rates_lambda_t make_acceptance_rates(T *p) { return synth_acceptance_rates<T>::invoke(p); }
  
  // move_construtible is not in gcc 4.6 std lib
  //template <class T> struct is_move_constructible : std::is_constructible<T, typename std::add_rvalue_reference<T>::type> {};
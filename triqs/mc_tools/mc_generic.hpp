@@ -25,10 +25,14 @@
 #include <triqs/utility/report_stream.hpp>
 #include <triqs/utility/signal_handler.hpp>
 #include <triqs/mpi/base.hpp>
+#include <triqs/h5.hpp>
+#include <chrono>
 #include "./mc_measure_aux_set.hpp"
 #include "./mc_measure_set.hpp"
 #include "./mc_move_set.hpp"
+#include "./static_move_set.hpp"
 #include "./random_generator.hpp"
+#include "./checkpoint_writer.hpp"
 
 namespace triqs {
 namespace mc_tools {
@@ -42,8 +46,12 @@ namespace mc_tools {
   * TBR
   * @include triqs/mc_tools.hpp
   */
+ template <typename MCSignType> class mc_multi_walker;
+
  template <typename MCSignType> class mc_generic {
 
+  friend class mc_multi_walker<MCSignType>;
+
   public:
   /**
     * Constructor
@@ -110,6 +118,34 @@ namespace mc_tools {
    AllMoves.add(std::forward<MoveType>(m), name, proposition_probability);
   }
 
+  /**
+   * Use a static_move_set instead of the moves registered with add_move.
+   *
+   * The Metropolis loop is then compiled for these moves, without any type erasure per step.
+   * The moves of the set must use get_rng() (or another generator) as the moves given to add_move.
+   *
+   * @param ms The set of moves, cf make_static_move_set.
+   */
+  template <typename... Moves> void set_static_move_set(static_move_set<MCSignType, Moves...> ms) {
+   using ms_t = static_move_set<MCSignType, Moves...>;
+   auto p = std::make_shared<ms_t>(std::move(ms));
+   ms_t *q = p.get();
+   static_moves = p;
+   static_cycle = [this, q](uint64_t length_cycle) { return metropolis_cycle(*q, length_cycle); };
+   static_collect_statistics = [q](mpi::communicator const &c) { q->collect_statistics(c); };
+   static_merge_statistics = [this, q](mc_generic const &other) {
+    // the closure type is the same for the same ms_t, i.e. if other has the same kind of static_move_set
+    if (!other.static_merge_statistics ||
+        (other.static_merge_statistics.target_type() != static_merge_statistics.target_type()))
+     TRIQS_RUNTIME_ERROR << "mc_generic : merge_statistics : not the same static_move_set";
+    q->merge_statistics(*static_cast<ms_t const *>(other.static_moves.get()));
+   };
+   static_acceptance_rates = [q]() { return q->get_acceptance_rates(); };
+   static_h5_write = [q](h5::group g, std::string const &name) { h5_write(g, name, *q); };
+   static_h5_read = [q](h5::group g, std::string const &name) { h5_read(g, name, *q); };
+   static_make_snapshot = [q]() { return q->make_snapshot(); };
+  }
+
   /**
    * Register a measure
    *
@@ -143,6 +179,40 @@ namespace mc_tools {
    */
   void set_after_cycle_duty(std::function<void()> f) { after_cycle_duty = f; }
 
+  /**
+   * Writes checkpoints (cf h5_write and resume) during the runs.
+   *
+   * After a cycle, when a checkpoint is due, the Monte Carlo is written as with h5_write in the group "mc"
+   * of the checkpoint file.
+   * If all the moves and measures which have a h5 interface also have a snapshot method (cf make_snapshot in impl_tools),
+   * the Monte Carlo thread only copies their data, which is written on disk by a background thread while the
+   * sampling continues. Otherwise, the checkpoint is written by the thread running the Monte Carlo.
+   * The run waits for the last checkpoint to be on disk before returning.
+   * The file on disk is always a complete checkpoint : after a crash, h5_read it and resume.
+   *
+   * NB : hdf5 is not thread safe in general. During the run, the other threads of the application must not call
+   * hdf5 (or do it under checkpoint_writer::h5_mutex()).
+   *
+   * @param file_name       Name of the checkpoint file (e.g. with the MPI rank, one file per node). "" : no checkpoints
+   * @param every_n_cycles  A checkpoint is written when the cycle number is a multiple of every_n_cycles (0 : never)
+   * @param every_seconds   A checkpoint is written every_seconds seconds after the previous one (0 : never).
+   *                        The time is only checked every 16 cycles.
+   */
+  void set_checkpoint(std::string const &file_name, uint64_t every_n_cycles, double every_seconds = 0) {
+   checkpoint.reset();
+   if (file_name.empty()) return;
+   checkpoint = std::make_shared<checkpoint_writer>(file_name);
+   checkpoint_every_n_cycles = every_n_cycles;
+   checkpoint_every_seconds = every_seconds;
+   last_checkpoint_time = std::chrono::steady_clock::now();
+  }
+
+  /// Number of checkpoints written on disk since set_checkpoint
+  uint64_t get_n_checkpoints() const { return (checkpoint ? checkpoint->n_written() : 0); }
+
+  /// Are the checkpoints written in the background ? Cf set_checkpoint
+  bool checkpoints_in_background() const { return bool(make_checkpoint_snapshot("mc")); }
+
 
   TRIQS_DEPRECATED("start method is deprecated. Use run, cf docs. Will be removed in future releases.")
   int start(MCSignType sign_init, std::function<bool()> stop_callback) {
@@ -169,10 +239,38 @@ namespace mc_tools {
   */
   int warmup_and_accumulate(uint64_t n_warmup_cycles, uint64_t n_accumulation_cycles, uint64_t length_cycle,
                             std::function<bool()> stop_callback) {
-   report << "\nWarming up ..." << std::endl;
-   int status = run(n_warmup_cycles, length_cycle, stop_callback, false);
-   report << "\nAccumulating ..." << std::endl;
-   if (status == 0) status = run(n_accumulation_cycles, length_cycle, stop_callback, true);
+   n_warmup_cycles_done = 0;
+   n_accumulation_cycles_done = 0;
+   total_duration = 0;
+   return resume(n_warmup_cycles, n_accumulation_cycles, length_cycle, stop_callback);
+  }
+
+  /**
+   * Continues a warmup_and_accumulate with the same parameters, which has been stopped
+   * (by stop_callback or a signal), possibly in another process after h5_read of a checkpoint.
+   *
+   * Only the remaining warmup and accumulation cycles are run.
+   * In warmup_and_accumulate and resume, a signal stops the run only at the end of a cycle
+   * (a cycle interrupted in the middle could not be resumed).
+   * With a checkpoint written by h5_write after a stop, and the same moves and measures (which save
+   * their own state, e.g. the configuration, with their h5 interface), the resumed run gives exactly the
+   * same result as the run without interruption.
+   *
+   * @return cf warmup_and_accumulate
+   */
+  int resume(uint64_t n_warmup_cycles, uint64_t n_accumulation_cycles, uint64_t length_cycle,
+             std::function<bool()> stop_callback) {
+   int status = 0;
+   if (n_warmup_cycles_done < n_warmup_cycles) {
+    report << "\nWarming up ..." << std::endl;
+    status = run_and_count(n_warmup_cycles - n_warmup_cycles_done, length_cycle, stop_callback, false, n_warmup_cycles_done);
+   }
+   if ((status == 0) && (n_accumulation_cycles_done < n_accumulation_cycles)) {
+    report << "\nAccumulating ..." << std::endl;
+    if (n_accumulation_cycles_done == 0) nmeasures = 0; // else keep the measures done before the stop
+    status = run_and_count(n_accumulation_cycles - n_accumulation_cycles_done, length_cycle, stop_callback, true,
+                           n_accumulation_cycles_done);
+   }
    // final reporting
    if (status == 1) report << "mc_generic stops because of stop_callback";
    if (status == 2) report << "mc_generic stops because of a signal";
@@ -197,27 +295,64 @@ namespace mc_tools {
    */
   int run(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> stop_callback, bool do_measure = true) {
    if (n_cycles==0) return 0;
-   Timer.start();
+   nmeasures = 0;
+   return run_cycles(n_cycles, length_cycle, stop_callback, do_measure);
+  }
+
+  private:
+  // run, without resetting nmeasures
+  int run_cycles(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> const &stop_callback, bool do_measure) {
+   if (n_cycles == 0) return 0;
    triqs::signal_handler::start();
+   int status = run_impl(n_cycles, length_cycle, stop_callback, do_measure);
+   triqs::signal_handler::stop();
+   wait_checkpoint();
+   return status;
+  }
+
+  // run_cycles, counting the cycles done in n_done (also during the run, for the checkpoints)
+  int run_and_count(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> const &stop_callback, bool do_measure,
+                    uint64_t &n_done) {
+   phase_cycles_done = &n_done;
+   int status = run_cycles(n_cycles, length_cycle, stop_callback, do_measure);
+   phase_cycles_done = nullptr;
+   return status;
+  }
+
+  // Is a checkpoint due after the current cycle ? The clock is read only every checkpoint_clock_period cycles.
+  bool checkpoint_due() {
+   if (!checkpoint) return false;
+   if ((checkpoint_every_n_cycles > 0) && (current_cycle_number % checkpoint_every_n_cycles == 0)) return true;
+   if ((checkpoint_every_seconds <= 0) || (current_cycle_number % checkpoint_clock_period != 0)) return false;
+   std::chrono::duration<double> dt = std::chrono::steady_clock::now() - last_checkpoint_time;
+   return (dt.count() >= checkpoint_every_seconds);
+  }
+
+  // In the background if possible, cf set_checkpoint
+  void write_checkpoint() {
+   auto snapshot = make_checkpoint_snapshot("mc");
+   if (snapshot)
+    checkpoint->push(std::move(snapshot));
+   else
+    checkpoint->write(*this, "mc");
+   last_checkpoint_time = std::chrono::steady_clock::now();
+  }
+
+  // Waits for the checkpoints written in the background
+  void wait_checkpoint() {
+   if (checkpoint) checkpoint->wait();
+  }
+
+  // The Monte Carlo loop of run. The signal handler is started by the caller, and nmeasures is reset by the caller.
+  int run_impl(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> const &stop_callback, bool do_measure) {
+   Timer.start();
    done_percent = 0;
-   nmeasures = 0;
    bool stop_it = false, finished = false;
    int NC = 0;
    for (; !stop_it; ++NC) { // do NOT reinit NC to 0
     // Metropolis loop. Switch here for HeatBath, etc...
-    for (uint64_t k = 1; (k <= length_cycle); k++) {
-     if (triqs::signal_handler::received()) goto _final;
-     double r = AllMoves.attempt();
-     if (RandomGenerator() < std::min(1.0, r)) {
-      if (debug) std::cerr << " Move accepted " << std::endl;
-      sign *= AllMoves.accept();
-      if (debug) std::cerr << " New sign = " << sign << std::endl;
-     } else {
-      if (debug) std::cerr << " Move rejected " << std::endl;
-      AllMoves.reject();
-     }
-     ++config_id;
-    }
+    bool interrupted = (static_cycle ? static_cycle(length_cycle) : metropolis_cycle(AllMoves, length_cycle));
+    if (interrupted) goto _final;
     if (after_cycle_duty) { after_cycle_duty(); }
     if (do_measure) {
      nmeasures++;
@@ -226,6 +361,9 @@ namespace mc_tools {
     }
    // recompute fraction done
    _final:
+    ++current_cycle_number;
+    if (phase_cycles_done) ++*phase_cycles_done;
+    if (!interrupted && checkpoint_due()) write_checkpoint();
     uint64_t dp = uint64_t(floor((NC * 100.0) / (n_cycles - 1)));
     if (dp > done_percent) {
      done_percent = dp;
@@ -236,15 +374,36 @@ namespace mc_tools {
    }
    int status = (finished ? 0 : (triqs::signal_handler::received() ? 2 : 1));
    Timer.stop();
-   triqs::signal_handler::stop();
-   current_cycle_number += NC;
+   total_duration += double(Timer);
    return status;
   }
 
+  // length_cycle Metropolis steps with the moves MS (move_set or static_move_set).
+  // Returns true iif interrupted by a signal. When the cycles are counted (cf resume), the cycle is never interrupted.
+  template <typename MS> bool metropolis_cycle(MS &moves, uint64_t length_cycle) {
+   for (uint64_t k = 1; (k <= length_cycle); k++) {
+    if (!phase_cycles_done && triqs::signal_handler::received()) return true;
+    double r = moves.attempt();
+    if (RandomGenerator() < std::min(1.0, r)) {
+     if (debug) std::cerr << " Move accepted " << std::endl;
+     sign *= moves.accept();
+     if (debug) std::cerr << " New sign = " << sign << std::endl;
+    } else {
+     if (debug) std::cerr << " Move rejected " << std::endl;
+     moves.reject();
+    }
+    ++config_id;
+   }
+   return false;
+  }
+
+  public:
+
   /// Reduce the results of the measures, and reports some statistics
   void collect_results(mpi::communicator const &c) {
    AllMeasures.collect_results(c);
    AllMoves.collect_statistics(c);
+   if (static_collect_statistics) static_collect_statistics(c);
    uint64_t nmeasures_tot = mpi::reduce(nmeasures, c);
 
    report(3) << "[Node " << c.rank() << "] Acceptance rate for all moves:\n" << AllMoves.get_statistics();
@@ -258,13 +417,21 @@ namespace mc_tools {
    *
    * @return map : name_of_the_move -> acceptance rate of this move
    */
-  std::map<std::string, double> get_acceptance_rates() const { return AllMoves.get_acceptance_rates(); }
+  std::map<std::string, double> get_acceptance_rates() const {
+   if (static_acceptance_rates) return static_acceptance_rates();
+   return AllMoves.get_acceptance_rates();
+  }
 
   /**
    * The duration of the last run
    */
   double get_duration() const { return double(Timer); }
 
+  /**
+   * The duration of the warmup_and_accumulate, including the runs before a resume from a checkpoint
+   */
+  double get_total_duration() const { return total_duration; }
+
   /**
    *  The current percents done
    */
@@ -299,34 +466,113 @@ namespace mc_tools {
   bool is_converged() const { return false; }
 
   public:
-  /// HDF5 interface
+  /**
+   * HDF5 interface : a checkpoint of the Monte Carlo, cf resume.
+   *
+   * Writes the moves and measures (those which have a h5 interface), the state of the random generator,
+   * the counters of the moves and of the measures, the progress of the warmup and of the accumulation,
+   * the sign, the configuration number and the duration.
+   */
   friend void h5_write(h5::group g, std::string const &name, mc_generic const &mc) {
    auto gr = g.create_group(name);
    h5_write(gr, "moves", mc.AllMoves);
+   if (mc.static_h5_write) mc.static_h5_write(gr, "static_moves");
    h5_write(gr, "measures", mc.AllMeasures);
-   h5_write(gr, "number_cycle_done", mc.current_cycle_number);
-   h5_write(gr, "number_measure_done", mc.nmeasures);
-   h5_write(gr, "sign", mc.sign);
+   h5_write(gr, mc.get_counters());
   }
 
-  /// HDF5 interface
+  /// HDF5 interface. The moves and measures must have been added as for the run which wrote the checkpoint.
   friend void h5_read(h5::group g, std::string const &name, mc_generic &mc) {
    auto gr = g.open_group(name);
    h5_read(gr, "moves", mc.AllMoves);
+   if (mc.static_h5_read && gr.has_key("static_moves")) mc.static_h5_read(gr, "static_moves");
    h5_read(gr, "measures", mc.AllMeasures);
    h5_read(gr, "number_cycle_done", mc.current_cycle_number);
    h5_read(gr, "number_measure_done", mc.nmeasures);
    h5_read(gr, "sign", mc.sign);
+   if (!gr.has_key("rng")) return; // checkpoint of a previous version
+   h5_read(gr, "rng", mc.RandomGenerator);
+   std::vector<uint64_t> move_counters, measure_counts;
+   h5_read(gr, "move_counters", move_counters);
+   if (mc.AllMoves.set_counters(move_counters) != move_counters.size())
+    TRIQS_RUNTIME_ERROR << "mc_generic : h5_read : the moves are not those of the checkpoint";
+   h5_read(gr, "measure_counts", measure_counts);
+   mc.AllMeasures.set_counts(measure_counts);
+   h5_read(gr, "config_id", mc.config_id);
+   h5_read(gr, "n_warmup_cycles_done", mc.n_warmup_cycles_done);
+   h5_read(gr, "n_accumulation_cycles_done", mc.n_accumulation_cycles_done);
+   h5_read(gr, "duration", mc.total_duration);
   }
 
   private:
+  // The counters and the state of the generator, written by h5_write
+  struct counters_t {
+   uint64_t number_cycle_done, number_measure_done;
+   MCSignType sign;
+   random_generator::snapshot_t rng;
+   std::vector<uint64_t> move_counters, measure_counts;
+   uint64_t config_id, n_warmup_cycles_done, n_accumulation_cycles_done;
+   double duration;
+  };
+
+  counters_t get_counters() const {
+   counters_t c{current_cycle_number, nmeasures, sign, RandomGenerator.snapshot(), {}, AllMeasures.get_counts(), config_id,
+                n_warmup_cycles_done, n_accumulation_cycles_done, total_duration};
+   AllMoves.get_counters(c.move_counters);
+   return c;
+  }
+
+  friend void h5_write(h5::group gr, counters_t const &c) {
+   h5_write(gr, "number_cycle_done", c.number_cycle_done);
+   h5_write(gr, "number_measure_done", c.number_measure_done);
+   h5_write(gr, "sign", c.sign);
+   h5_write(gr, "rng", c.rng);
+   h5_write(gr, "move_counters", c.move_counters);
+   h5_write(gr, "measure_counts", c.measure_counts);
+   h5_write(gr, "config_id", c.config_id);
+   h5_write(gr, "n_warmup_cycles_done", c.n_warmup_cycles_done);
+   h5_write(gr, "n_accumulation_cycles_done", c.n_accumulation_cycles_done);
+   h5_write(gr, "duration", c.duration);
+  }
+
+  // A copy of the checkpoint, which writes it as h5_write in the group name, from any thread.
+  // Empty if one of the moves or measures with a h5 interface has no snapshot method (cf make_snapshot in impl_tools).
+  checkpoint_writer::h5_writer_t make_checkpoint_snapshot(std::string const &name) const {
+   auto moves = AllMoves.make_snapshot(), measures = AllMeasures.make_snapshot();
+   h5_snapshot_lambda_t static_moves = []() { return h5_rw_lambda_t{}; };
+   if (static_make_snapshot) static_moves = static_make_snapshot();
+   if (!moves || !measures || !static_moves) return {};
+   return [name, w_moves = moves(), w_static = static_moves(), w_measures = measures(), c = get_counters()](h5::group g) {
+    auto gr = g.create_group(name);
+    w_moves(gr, "moves");
+    if (w_static) w_static(gr, "static_moves");
+    w_measures(gr, "measures");
+    h5_write(gr, c);
+   };
+  }
+
   random_generator RandomGenerator;
   move_set<MCSignType> AllMoves;
+  std::shared_ptr<void> static_moves;                   // the static_move_set, if any, cf set_static_move_set
+  std::function<bool(uint64_t)> static_cycle;           // the Metropolis loop for the static_move_set
+  std::function<void(mpi::communicator const &)> static_collect_statistics;
+  std::function<void(mc_generic const &)> static_merge_statistics; // adds the statistics of the static_move_set of another walker
+  std::function<std::map<std::string, double>()> static_acceptance_rates;
+  h5_rw_lambda_t static_h5_write, static_h5_read;
+  std::function<h5_snapshot_lambda_t()> static_make_snapshot;
+  std::shared_ptr<checkpoint_writer> checkpoint;                // the writer of the checkpoints, if any
+  static constexpr uint64_t checkpoint_clock_period = 16;       // cf checkpoint_due
+  uint64_t checkpoint_every_n_cycles = 0;
+  double checkpoint_every_seconds = 0;
+  std::chrono::steady_clock::time_point last_checkpoint_time;
   measure_set<MCSignType> AllMeasures;
   std::vector<measure_aux> AllMeasuresAux;
   utility::report_stream report;
   uint64_t length_cycle_bckwd = 0, n_warmup_cycles_bckwd = 0, ncycles_bckwd = 0; // backward compat only. Deprecated
-  uint64_t nmeasures, current_cycle_number = 0;
+  uint64_t nmeasures = 0, current_cycle_number = 0;
+  uint64_t n_warmup_cycles_done = 0, n_accumulation_cycles_done = 0; // progress of warmup_and_accumulate, cf resume
+  uint64_t *phase_cycles_done = nullptr;                               // the counter of the phase running, cf run_and_count
+  double total_duration = 0;
   utility::timer Timer;
   std::function<void()> after_cycle_duty;
   MCSignType sign;
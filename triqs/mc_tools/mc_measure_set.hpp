@@ -23,6 +23,7 @@
 #include <triqs/utility/exceptions.hpp>
 #include <functional>
 #include <map>
+#include <typeinfo>
 #include "./impl_tools.hpp"
 
 namespace triqs { namespace mc_tools {
@@ -34,9 +35,17 @@ namespace triqs { namespace mc_tools {
    std::function<void (MCSignType const & ) > accumulate_;
    std::function<void (mpi::communicator const & )> collect_results_;
    std::function<void(h5::group, std::string const &)> h5_r, h5_w;
+   h5_snapshot_lambda_t snapshot_; // cf make_snapshot in impl_tools
+   std::function<void(void const *)> merge_; // empty if the measure has no merge method
+   std::type_info const *type_;
 
    uint64_t count_;
 
+   template <typename T> static std::function<void(void const *)> make_merge(T *p, std::true_type) {
+    return [p](void const *q) { p->merge(*static_cast<T const *>(q)); };
+   }
+   template <typename T> static std::function<void(void const *)> make_merge(T *, std::false_type) { return {}; }
+
    public:
    template <typename MeasureType> measure(bool, MeasureType &&m) {
     static_assert(std::is_move_constructible<MeasureType>::value, "This measure is not MoveConstructible");
@@ -50,6 +59,9 @@ namespace triqs { namespace mc_tools {
     collect_results_ = [p](mpi::communicator const &c) { p->collect_results(c); };
     h5_r = make_h5_read(p);
     h5_w = make_h5_write(p);
+    snapshot_ = mc_tools::make_snapshot(p);
+    merge_ = make_merge(p, mc_tools::has_merge<m_t>{});
+    type_ = &typeid(m_t);
    }
 
    // 
@@ -62,6 +74,20 @@ namespace triqs { namespace mc_tools {
    void collect_results (mpi::communicator const & c ) { collect_results_(c);}
 
    uint64_t count() const { return count_;}
+   void set_count(uint64_t c) { count_ = c; }
+
+   bool has_merge() const { return bool(merge_); }
+
+   // Adds the accumulated data of m (a measure of the same type, e.g. from another walker) into this one
+   void merge(measure const &m) {
+    if (!merge_) TRIQS_RUNTIME_ERROR << "measure : this measure has no merge method";
+    if (*type_ != *m.type_) TRIQS_RUNTIME_ERROR << "measure : can not merge measures of different types";
+    merge_(m.impl_.get());
+    count_ += m.count_;
+   }
+
+   // Takes the snapshot of the measure, cf make_snapshot in impl_tools. Empty if the measure has no snapshot method.
+   h5_snapshot_lambda_t const &make_snapshot() const { return snapshot_; }
 
    friend void h5_write (h5::group g, std::string const & name, measure const & m){ if (m.h5_w) m.h5_w(g,name);};
    friend void h5_read  (h5::group g, std::string const & name, measure & m)      { if (m.h5_r) m.h5_r(g,name);};
@@ -113,6 +139,52 @@ namespace triqs { namespace mc_tools {
     return res;
    }
 
+   /// Merge in place the measures of ms (e.g. from another walker), which must have the same names and types.
+   void merge(measure_set const &ms) {
+    for (auto &nmp : m_map) {
+     auto it = ms.m_map.find(nmp.first);
+     if (it == ms.m_map.end()) TRIQS_RUNTIME_ERROR << "measure_set : merge : no measure '" << nmp.first << "' to merge";
+     if (!nmp.second.has_merge())
+      TRIQS_RUNTIME_ERROR << "measure_set : merge : measure '" << nmp.first << "' has no merge method";
+     nmp.second.merge(it->second);
+    }
+   }
+
+   /// The number of accumulations of the measures, in the order of names()
+   std::vector<uint64_t> get_counts() const {
+    std::vector<uint64_t> res;
+    for (auto & nmp : m_map) res.push_back(nmp.second.count());
+    return res;
+   }
+
+   /// Restores the counts given by get_counts (for the same measures)
+   void set_counts(std::vector<uint64_t> const &c) {
+    if (c.size() != m_map.size()) TRIQS_RUNTIME_ERROR << "measure_set : set_counts : " << c.size() << " counts for " << m_map.size() << " measures";
+    size_t i = 0;
+    for (auto & nmp : m_map) nmp.second.set_count(c[i++]);
+   }
+
+   /**
+    * Takes the snapshot of all the measures, written as h5_write (cf make_snapshot in impl_tools).
+    * Empty if one of the measures with a h5 interface has no snapshot method.
+    */
+   h5_snapshot_lambda_t make_snapshot() const {
+    std::vector<std::pair<std::string, h5_snapshot_lambda_t>> snap;
+    for (auto & nmp : m_map) {
+     if (!nmp.second.make_snapshot()) return {};
+     snap.emplace_back(nmp.first, nmp.second.make_snapshot());
+    }
+    return [snap]() -> h5_rw_lambda_t {
+     std::vector<std::pair<std::string, h5_rw_lambda_t>> w;
+     for (auto & x : snap) w.emplace_back(x.first, x.second());
+     return [w](h5::group g, std::string const &name) {
+      auto gr = g.create_group(name);
+      for (auto & x : w)
+       if (x.second) x.second(gr, x.first);
+     };
+    };
+   }
+
    // gather result for all measure, on communicator c
    void collect_results (mpi::communicator const & c ) { for (auto & nmp : m_map) nmp.second.collect_results(c); }
 
@@ -45,11 +45,22 @@ namespace mc_tools {
   std::function<void()> reject_;
   std::function<void(mpi::communicator const &)> collect_statistics_;
   std::function<void(h5::group, std::string const &)> h5_r, h5_w;
+  std::function<h5_snapshot_lambda_t()> snapshot_; // cf make_snapshot
+  acceptance_rates_lambda_t sub_acceptance_rates_; // if the move has its own get_acceptance_rates, e.g. static_move_set
 
   uint64_t NProposed, Naccepted;
   double acceptance_rate_;
   bool is_move_set_; // need to remember if the move was a move_set for printing details later.
 
+  // The snapshot of a move is fixed at construction, the one of a move_set depends on the moves added to it
+  template <typename T> static std::function<h5_snapshot_lambda_t()> make_snapshot_maker(T *p) {
+   auto s = mc_tools::make_snapshot(p);
+   return [s]() { return s; };
+  }
+  static std::function<h5_snapshot_lambda_t()> make_snapshot_maker(move_set<MCSignType> *p) {
+   return [p]() { return p->make_snapshot(); };
+  }
+
   public:
   /// Construct from any m modeling MoveType. bool is here to disambiguate with basic copy/move construction.
   template <typename MoveType> move(bool, MoveType &&m) {
@@ -65,8 +76,10 @@ namespace mc_tools {
    accept_ = [p]() { return p->accept(); };
    reject_ = [p]() { p->reject(); };
    collect_statistics_ = make_collect_statistics(p); // cf impl_tools
+   if (!std::is_same<m_t, move_set<MCSignType>>::value) sub_acceptance_rates_ = make_acceptance_rates(p);
    h5_r = make_h5_read(p);
    h5_w = make_h5_write(p);
+   snapshot_ = make_snapshot_maker(p);
    NProposed = 0;
    Naccepted = 0;
    acceptance_rate_ = -1;
@@ -100,8 +113,41 @@ namespace mc_tools {
    if (collect_statistics_) collect_statistics_(c);
   }
 
+  /// The acceptance rates reported by the move itself, if any
+  std::map<std::string, double> sub_acceptance_rates() const {
+   return sub_acceptance_rates_ ? sub_acceptance_rates_() : std::map<std::string, double>{};
+  }
+
   move_set<MCSignType> *as_move_set() const { return is_move_set_ ? static_cast<move_set<MCSignType> *>(impl_.get()) : nullptr; }
 
+  // Add the counters of m (the same move, e.g. from another walker)
+  void merge_statistics(move const &m) {
+   NProposed += m.NProposed;
+   Naccepted += m.Naccepted;
+   auto ms = as_move_set();
+   if (ms) ms->merge_statistics(*m.as_move_set());
+  }
+
+  // Appends the counters of this move, and of its moves if it is a move_set, to v. Cf move_set::get_counters
+  void get_counters(std::vector<uint64_t> &v) const {
+   v.push_back(NProposed);
+   v.push_back(Naccepted);
+   auto ms = as_move_set();
+   if (ms) ms->get_counters(v);
+  }
+
+  // Sets the counters from v, starting at pos. Returns the position after them.
+  size_t set_counters(std::vector<uint64_t> const &v, size_t pos) {
+   if (pos + 2 > v.size()) TRIQS_RUNTIME_ERROR << "move : set_counters : not enough counters";
+   NProposed = v[pos];
+   Naccepted = v[pos + 1];
+   auto ms = as_move_set();
+   return (ms ? ms->set_counters(v, pos + 2) : pos + 2);
+  }
+
+  // Takes the snapshot of the move, cf make_snapshot in impl_tools. Empty if the move has no snapshot method.
+  h5_snapshot_lambda_t make_snapshot() const { return snapshot_(); }
+
   // redirect the h5 call to the object lambda, if it not empty (i.e. if the underlying object can be called with h5_read/write
   friend void h5_write(h5::group g, std::string const &name, move const &m) {
    if (m.h5_w) m.h5_w(g, name);
@@ -232,6 +278,26 @@ namespace mc_tools {
    for (auto &m : move_vec) m.collect_statistics(c);
   }
 
+  /// Add the number of proposed and accepted moves of ms (the same moves, e.g. from another walker)
+  void merge_statistics(move_set const &ms) {
+   if (ms.move_vec.size() != move_vec.size()) TRIQS_RUNTIME_ERROR << "move_set : merge_statistics : not the same moves";
+   for (size_t u = 0; u < move_vec.size(); ++u) move_vec[u].merge_statistics(ms.move_vec[u]);
+  }
+
+  /**
+   * The number of proposed and accepted moves of all moves, including the moves of the sub move_sets, in order.
+   * Appended to v. Cf set_counters.
+   */
+  void get_counters(std::vector<uint64_t> &v) const {
+   for (auto const &m : move_vec) m.get_counters(v);
+  }
+
+  /// Restores the counters given by get_counters (for the same moves), starting at pos. Returns the position after them.
+  size_t set_counters(std::vector<uint64_t> const &v, size_t pos = 0) {
+   for (auto &m : move_vec) pos = m.set_counters(v, pos);
+   return pos;
+  }
+
   /// Acceptance rate of all moves as a map name:string -> acceptance_rate:double
   std::map<std::string, double> get_acceptance_rates() const {
    std::map<std::string, double> r;
@@ -242,6 +308,8 @@ namespace mc_tools {
      auto ar = ms->get_acceptance_rates();
      r.insert(ar.begin(), ar.end());
     }
+    auto sr = move_vec[u].sub_acceptance_rates(); // same for a move reporting its own rates (static_move_set)
+    r.insert(sr.begin(), sr.end());
    }
    return r;
   }
@@ -276,6 +344,28 @@ namespace mc_tools {
 
   public:
   // HDF5 interface
+  /**
+   * Takes the snapshot of all the moves, written as h5_write (cf make_snapshot in impl_tools).
+   * Empty if one of the moves with a h5 interface has no snapshot method.
+   */
+  h5_snapshot_lambda_t make_snapshot() const {
+   std::vector<h5_snapshot_lambda_t> snap;
+   for (auto const &m : move_vec) {
+    snap.push_back(m.make_snapshot());
+    if (!snap.back()) return {};
+   }
+   auto names = names_;
+   return [snap, names]() -> h5_rw_lambda_t {
+    std::vector<h5_rw_lambda_t> w;
+    for (auto const &s : snap) w.push_back(s());
+    return [w, names](h5::group g, std::string const &name) {
+     auto gr = g.create_group(name);
+     for (size_t u = 0; u < w.size(); ++u)
+      if (w[u]) w[u](gr, names[u]);
+    };
+   };
+  }
+
   friend void h5_write(h5::group g, std::string const &name, move_set const &ms) {
    auto gr = g.create_group(name);
    for (size_t u = 0; u < ms.move_vec.size(); ++u) h5_write(gr, ms.names_[u], ms.move_vec[u]);
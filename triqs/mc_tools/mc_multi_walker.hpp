@@ -0,0 +1,134 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2013 by M. Ferrero, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./mc_generic.hpp"
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <memory>
+
+namespace triqs {
+namespace mc_tools {
+
+ /**
+  * \brief Several Monte Carlo walkers, run in parallel on threads in one process.
+  *
+  * Each walker is a full mc_generic, with its own random generator, moves and measures,
+  * which are added to it by the user, using walker(w). The data shared by the walkers
+  * (e.g. the Hamiltonian) are simply read through a reference in the moves/measures.
+  *
+  * The measures must have a method merge(MeasureType const & other), which adds the accumulated data of other
+  * (the same measure on another walker) into this. They are merged in process before the MPI reduction in collect_results.
+  */
+ template <typename MCSignType> class mc_multi_walker {
+
+  public:
+  /**
+    * Constructor
+    *
+    * @param n_walkers       Number of walkers, each run on its own thread.
+    * @param random_name     Name of the random generator (cf doc).
+    * @param random_seed     Seed for the random generator. Walker w uses the stream w of this seed if the generator
+    *                        has streams (philox4x32, cf random_generator::split), random_seed + w otherwise.
+    * @param sign_init       The initial value of the sign (usually 1)
+    * @param verbosity       Verbosity level. Only the walker 0 reports.
+    * @param debug           Debug mode
+    */
+  mc_multi_walker(int n_walkers, std::string random_name, int random_seed, MCSignType sign_init, int verbosity,
+                  bool debug = false) {
+   if (n_walkers < 1) TRIQS_RUNTIME_ERROR << "mc_multi_walker : the number of walkers must be >0";
+   // mc_generic can not be moved (the move_set keeps a pointer to its random generator)
+   for (int w = 0; w < n_walkers; ++w) {
+    bool streams = (w > 0) && walkers[0]->get_rng().has_streams();
+    walkers.emplace_back(new mc_generic<MCSignType>(random_name, (streams ? random_seed : random_seed + w), sign_init,
+                                                    (w == 0 ? verbosity : 0), debug));
+    if (streams) walkers[w]->get_rng() = walkers[0]->get_rng().split(w);
+   }
+  }
+
+  /// Number of walkers
+  int n_walkers() const { return walkers.size(); }
+
+  /// The walker w, to add moves and measures to it
+  mc_generic<MCSignType> &walker(int w) { return *walkers[w]; }
+  mc_generic<MCSignType> const &walker(int w) const { return *walkers[w]; }
+
+  /// Warmup and accumulate. Cf mc_generic. The number of cycles is per walker.
+  int warmup_and_accumulate(uint64_t n_warmup_cycles, uint64_t n_accumulation_cycles, uint64_t length_cycle,
+                            std::function<bool()> stop_callback) {
+   int status = run(n_warmup_cycles, length_cycle, stop_callback, false);
+   if (status == 0) status = run(n_accumulation_cycles, length_cycle, stop_callback, true);
+   return status;
+  }
+
+  /**
+   * Runs all the walkers in parallel, one per thread. Cf mc_generic.
+   * The number of cycles is per walker. stop_callback is called by all threads.
+   *
+   * @return the largest of the status of the walkers (cf mc_generic::run)
+   */
+  int run(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> stop_callback, bool do_measure = true) {
+   if (n_cycles == 0) return 0;
+   int nw = n_walkers();
+   std::vector<int> status(nw, 0);
+   std::vector<std::exception_ptr> errors(nw);
+   auto job = [&](int w) {
+    try {
+     walkers[w]->nmeasures = 0;
+     status[w] = walkers[w]->run_impl(n_cycles, length_cycle, stop_callback, do_measure);
+     walkers[w]->wait_checkpoint();
+    } catch (...) { errors[w] = std::current_exception(); }
+   };
+   triqs::signal_handler::start();
+   std::vector<std::thread> threads;
+   for (int w = 1; w < nw; ++w) threads.emplace_back(job, w);
+   job(0);
+   for (auto &t : threads) t.join();
+   triqs::signal_handler::stop();
+   for (auto &e : errors)
+    if (e) std::rethrow_exception(e);
+   return *std::max_element(status.begin(), status.end());
+  }
+
+  /**
+   * Merges the measures and the move statistics of all walkers into walker 0,
+   * then reduces the results on the communicator, like mc_generic::collect_results.
+   * To be called once, at the end of the run.
+   */
+  void collect_results(mpi::communicator const &c) {
+   auto &w0 = *walkers[0];
+   for (int w = 1; w < n_walkers(); ++w) {
+    w0.AllMeasures.merge(walkers[w]->AllMeasures);
+    w0.AllMoves.merge_statistics(walkers[w]->AllMoves);
+    if (w0.static_merge_statistics) w0.static_merge_statistics(*walkers[w]);
+    w0.nmeasures += walkers[w]->nmeasures;
+   }
+   w0.collect_results(c);
+  }
+
+  /// The acceptance rates of all moves, over all walkers. Valid after collect_results.
+  std::map<std::string, double> get_acceptance_rates() const { return walkers[0]->get_acceptance_rates(); }
+
+  private:
+  std::vector<std::unique_ptr<mc_generic<MCSignType>>> walkers;
+ };
+}
+} // end namespace
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2014 by M. Ferrero, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+namespace triqs {
+namespace mc_tools {
+ namespace RandomGenerators {
+
+  /**
+   * Philox4x32-10 counter based generator (Salmon et al., SC11).
+   *
+   * The n-th block of 4 x 32 bits of the stream s is a bijective function of the counter (n, s), keyed by the seed.
+   * Hence the streams of different stream_id are disjoint, and the blocks can be computed independently, in any order :
+   * fill computes them by lanes of W blocks, a loop the compiler vectorizes.
+   */
+  class philox4x32 {
+   uint32_t key0, key1;
+   uint64_t stream, block = 0; // the counter is (block, stream)
+
+   static constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // multipliers
+   static constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // Weyl sequence of the key
+   static constexpr int W = 64;                                 // blocks computed together (by SIMD lanes)
+
+   // 10 rounds on W blocks. c0..c3 : the counters on input, the random bits on output.
+   void rounds(uint32_t *c0, uint32_t *c1, uint32_t *c2, uint32_t *c3) const {
+    uint32_t k0 = key0, k1 = key1;
+    for (int r = 0; r < 10; ++r) {
+     for (int l = 0; l < W; ++l) {
+      uint64_t p0 = uint64_t(M0) * c0[l], p1 = uint64_t(M1) * c2[l];
+      uint32_t n0 = uint32_t(p1 >> 32) ^ c1[l] ^ k0, n2 = uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+      c1[l] = uint32_t(p1);
+      c3[l] = uint32_t(p0);
+      c0[l] = n0;
+      c2[l] = n2;
+     }
+     k0 += W0;
+     k1 += W1;
+    }
+   }
+
+   public:
+   /**
+    * @param seed      The seed, i.e. the key of the generator
+    * @param stream_id The stream
+    */
+   philox4x32(uint64_t seed, uint64_t stream_id = 0) : key0(uint32_t(seed)), key1(uint32_t(seed >> 32)), stream(stream_id) {}
+
+   /// Fills out[0:n] with doubles in [0,1[ (53 random bits each), and advances the counter.
+   /// For speed, n should be a multiple of 2 W = 128 : the rest of the last W blocks is dropped.
+   void fill(double *out, size_t n) {
+    alignas(64) uint32_t c0[W], c1[W], c2[W], c3[W];
+    for (size_t i = 0; i < n; i += 2 * W, block += W) {
+     for (int l = 0; l < W; ++l) {
+      c0[l] = uint32_t(block + l);
+      c1[l] = uint32_t((block + l) >> 32);
+      c2[l] = uint32_t(stream);
+      c3[l] = uint32_t(stream >> 32);
+     }
+     rounds(c0, c1, c2, c3);
+     // each block gives 2 doubles
+     constexpr double two_m53 = 1.0 / 9007199254740992.0;
+     if (n - i >= 2 * W) {
+      for (int l = 0; l < W; ++l) {
+       out[i + 2 * l] = double((uint64_t(c0[l] >> 5) << 26) | (c1[l] >> 6)) * two_m53;
+       out[i + 2 * l + 1] = double((uint64_t(c2[l] >> 5) << 26) | (c3[l] >> 6)) * two_m53;
+      }
+     } else
+      for (size_t l = 0; l < n - i; ++l) {
+       uint64_t a = (l % 2 == 0 ? c0[l / 2] : c2[l / 2]), b = (l % 2 == 0 ? c1[l / 2] : c3[l / 2]);
+       out[i + l] = double(((a >> 5) << 26) | (b >> 6)) * two_m53;
+      }
+    }
+   }
+
+   /// Returns the 4 x 32 bits of the block n of the stream, without changing the state. For tests.
+   void block_at(uint64_t n, uint32_t *res) const {
+    uint32_t c0[W] = {uint32_t(n)}, c1[W] = {uint32_t(n >> 32)}, c2[W] = {uint32_t(stream)}, c3[W] = {uint32_t(stream >> 32)};
+    rounds(c0, c1, c2, c3);
+    res[0] = c0[0], res[1] = c1[0], res[2] = c2[0], res[3] = c3[0];
+   }
+
+   /// The state of the generator : key and counter
+   friend std::ostream &operator<<(std::ostream &out, philox4x32 const &g) {
+    return out << g.key0 << ' ' << g.key1 << ' ' << g.stream << ' ' << g.block;
+   }
+   friend std::istream &operator>>(std::istream &in, philox4x32 &g) { return in >> g.key0 >> g.key1 >> g.stream >> g.block; }
+  };
+ }
+}
+}
@@ -19,7 +19,9 @@
  *
  ******************************************************************************/
 #include "random_generator.hpp"
+#include <triqs/h5.hpp>
 #include "./MersenneRNG.hpp"
+#include "./philox.hpp"
 #include <boost/random.hpp>
 //#include <boost/random/uniform_int.hpp>
 #include <boost/random/uniform_real.hpp>
@@ -39,23 +41,50 @@
 namespace triqs {
 namespace mc_tools {
 
- random_generator::random_generator(std::string const& RandomGeneratorName, uint32_t seed_) {
-  _name = RandomGeneratorName;
+ namespace {
+
+  // The uniform distribution on [0,1[ of a boost engine, as variate_generator, with the state of the engine
+  template <typename Engine> struct uniform_boost {
+   Engine eng;
+   boost::uniform_real<> dis;
+   double operator()() { return dis(eng); }
+   friend std::ostream &operator<<(std::ostream &out, uniform_boost const &g) { return out << g.eng; }
+   friend std::istream &operator>>(std::istream &in, uniform_boost &g) { return in >> g.eng; }
+  };
+
+  // Fills the buffer by batch
+  struct philox_batch {
+   RandomGenerators::philox4x32 g;
+   void operator()(double *data, size_t n) { g.fill(data, n); }
+   friend std::ostream &operator<<(std::ostream &out, philox_batch const &p) { return out << p.g; }
+   friend std::istream &operator>>(std::istream &in, philox_batch &p) { return in >> p.g; }
+  };
+ }
+
+ random_generator::random_generator(std::string const& RandomGeneratorName, uint32_t seed_, uint64_t stream_id)
+    : _name(RandomGeneratorName), _seed(seed_), _stream_id(stream_id) {
+
+  // counter based generator : the buffer is filled by batch
+  if (RandomGeneratorName == "philox4x32") {
+   using buf_t = utility::buffered_function<double>;
+   gen = buf_t(buf_t::batch_t{}, philox_batch{RandomGenerators::philox4x32(seed_, stream_id)}, 1024);
+   return;
+  }
+
+  if (stream_id != 0) TRIQS_RUNTIME_ERROR << "The random generator " << RandomGeneratorName << " has no streams. Use philox4x32";
 
   if (RandomGeneratorName == "") {
    gen = utility::buffered_function<double>(mc_tools::RandomGenerators::RandMT(seed_));
    return;
   }
 
-  boost::uniform_real<> dis;
-
 #define AS_STRING(X) AS_STRING2(X)
 #define AS_STRING2(X) #X
 
 // now boost random number generators
 #define DRNG(r, data, XX)                                                                                                        \
  if (RandomGeneratorName == AS_STRING(XX)) {                                                                                     \
-  gen = utility::buffered_function<double>(boost::variate_generator<boost::XX, boost::uniform_real<>>(boost::XX(seed_), dis));   \
+  gen = utility::buffered_function<double>(uniform_boost<boost::XX>{boost::XX(seed_), boost::uniform_real<>()});                 \
   return;                                                                                                                        \
  }
 
@@ -66,15 +95,45 @@ namespace mc_tools {
 
  //---------------------------------------------
 
+ std::string random_generator::get_state() const { return gen.get_state(); }
+
+ void random_generator::set_state(std::string const &state) { gen.set_state(state); }
+
+ void h5_write(h5::group g, std::string const &name, random_generator const &r) { h5_write(g, name, r.snapshot()); }
+
+ void h5_write(h5::group g, std::string const &name, random_generator::snapshot_t const &s) {
+  auto gr = g.create_group(name);
+  h5_write(gr, "name", s.name);
+  h5_write(gr, "seed", static_cast<long>(s.seed));
+  h5_write(gr, "stream_id", static_cast<unsigned long long>(s.stream_id));
+  h5_write(gr, "state", s.state);
+ }
+
+ void h5_read(h5::group g, std::string const &name, random_generator &r) {
+  auto gr = g.open_group(name);
+  std::string n, state;
+  long seed;
+  unsigned long long stream_id;
+  h5_read(gr, "name", n);
+  h5_read(gr, "seed", seed);
+  h5_read(gr, "stream_id", stream_id);
+  h5_read(gr, "state", state);
+  r = random_generator(n, seed, stream_id);
+  r.set_state(state);
+ }
+
+ //---------------------------------------------
+
  std::string random_generator_names(std::string const &sep) {
 #define PR(r, sep, p, XX) BOOST_PP_IF(p, +sep +, ) std::string(AS_STRING(XX))
-  return BOOST_PP_SEQ_FOR_EACH_I(PR, sep, RNG_LIST);
+  return BOOST_PP_SEQ_FOR_EACH_I(PR, sep, RNG_LIST) + sep + "philox4x32";
  }
 
  std::vector<std::string> random_generator_names_list() {
   std::vector<std::string> res;
 #define PR2(r, sep, p, XX) res.push_back(AS_STRING(XX));
   BOOST_PP_SEQ_FOR_EACH_I(PR2, sep, RNG_LIST);
+  res.push_back("philox4x32");
   return res;
  }
 }
@@ -22,6 +22,7 @@
 #include <triqs/utility/first_include.hpp>
 #include "../utility/exceptions.hpp"
 #include "../utility/buffered_function.hpp"
+#include "../h5/group.hpp"
 #include "math.h"
 #include <string>
 #include <assert.h>
@@ -39,17 +40,25 @@ namespace mc_tools {
   *
   * The name of the generator is given at construction, and its type is erased in this class.
   * For performance, the call to the generator is bufferized, with chunks of 1000 numbers.
+  *
+  * The counter based generator philox4x32 has independent streams : cf split.
+  *
+  * The state of the generator (engine and buffer) can be saved and restored (get_state/set_state, h5_write/h5_read),
+  * e.g. to restart a Monte Carlo from a checkpoint with exactly the same random numbers.
   */
  class random_generator {
   utility::buffered_function<double> gen;
   std::string _name;
+  uint32_t _seed;
+  uint64_t _stream_id;
 
   public:
   /** Constructor
-   *  @param RandomGeneratorName : Name of a boost generator e.g. mt19937, or "" (another Mersenne Twister).
+   *  @param RandomGeneratorName : Name of a boost generator e.g. mt19937, "philox4x32", or "" (another Mersenne Twister).
    *  @param seed : The seed of the random generator
+   *  @param stream_id : The stream (only for generators with streams, cf split)
    */
-  random_generator(std::string const& RandomGeneratorName, uint32_t seed_);
+  random_generator(std::string const& RandomGeneratorName, uint32_t seed_, uint64_t stream_id = 0);
 
   random_generator() : random_generator("mt19937", 198) {}
 
@@ -64,6 +73,42 @@ namespace mc_tools {
   /// Name of the random generator
   std::string name() const { return _name; }
 
+  /// Does the generator have independent streams (cf split) ?
+  bool has_streams() const { return _name == "philox4x32"; }
+
+  /// The stream of this generator
+  uint64_t stream_id() const { return _stream_id; }
+
+  /**
+   * A new generator, with the same name and seed, on the stream stream_id, starting at its beginning.
+   *
+   * Different streams of the same seed never overlap, e.g. use split(comm.rank()) on each MPI node
+   * or split(rank * n_threads + thread) for each thread, instead of different seeds.
+   * Only for generators with streams, i.e. philox4x32.
+   */
+  random_generator split(uint64_t stream_id) const { return {_name, _seed, stream_id}; }
+
+  /// The state of the generator, as a string
+  std::string get_state() const;
+
+  /// Restores a state given by get_state of a generator with the same name
+  void set_state(std::string const &state);
+
+  /// What h5_write writes : name, seed, stream and state
+  struct snapshot_t {
+   std::string name, state;
+   uint32_t seed;
+   uint64_t stream_id;
+  };
+
+  /// A copy of the state, written by h5_write as the generator itself (cf mc_generic::set_checkpoint)
+  snapshot_t snapshot() const { return {_name, get_state(), _seed, _stream_id}; }
+
+  /// HDF5 interface : name, seed, stream and state. h5_read replaces r by the generator saved, in its state.
+  friend void h5_write(h5::group g, std::string const &name, random_generator const &r);
+  friend void h5_write(h5::group g, std::string const &name, snapshot_t const &s);
+  friend void h5_read(h5::group g, std::string const &name, random_generator &r);
+
   /// Returns a integer in [0,i-1] with flat distribution
   template <typename T> typename std::enable_if<std::is_integral<T>::value, T>::type operator()(T i) {
    return (i == 1 ? 0 : T(floor(i * (gen()))));
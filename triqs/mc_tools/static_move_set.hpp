@@ -0,0 +1,283 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2011-2013 by M. Ferrero, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/utility/first_include.hpp>
+#include <triqs/utility/exceptions.hpp>
+#include <triqs/mpi/base.hpp>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <tuple>
+#include <vector>
+#include "./random_generator.hpp"
+#include "./impl_tools.hpp"
+
+namespace triqs {
+namespace mc_tools {
+
+ /**
+  * Alias table (Walker, Vose) : draws an index in [0,n[ with given (non normalized) weights,
+  * in O(1), with one random number.
+  */
+ class alias_table {
+  std::vector<double> proba;
+  std::vector<size_t> alias;
+
+  public:
+  alias_table() = default;
+
+  /// Weights must be >=0, with a positive sum.
+  alias_table(std::vector<double> const &weights) : proba(weights.size()), alias(weights.size()) {
+   size_t n = weights.size();
+   double sum = 0;
+   for (auto w : weights) {
+    if (!(w >= 0)) TRIQS_RUNTIME_ERROR << "alias_table : weights must be >=0";
+    sum += w;
+   }
+   if (!(sum > 0)) TRIQS_RUNTIME_ERROR << "alias_table : the sum of the weights must be >0";
+   std::vector<size_t> small, large;
+   for (size_t i = 0; i < n; ++i) {
+    proba[i] = weights[i] * n / sum;
+    (proba[i] < 1 ? small : large).push_back(i);
+   }
+   while (!small.empty() && !large.empty()) {
+    size_t s = small.back(), l = large.back();
+    small.pop_back();
+    alias[s] = l;
+    proba[l] -= 1 - proba[s];
+    if (proba[l] < 1) {
+     large.pop_back();
+     small.push_back(l);
+    }
+   }
+   // the remaining ones are 1 up to rounding errors
+   for (auto i : large) { proba[i] = 1; alias[i] = i; }
+   for (auto i : small) { proba[i] = 1; alias[i] = i; }
+  }
+
+  /// Number of indices
+  size_t size() const { return proba.size(); }
+
+  /// Draws an index, from a uniform random number u in [0,1[
+  size_t operator()(double u) const {
+   double x = u * proba.size();
+   size_t i = std::min(size_t(x), proba.size() - 1);
+   return (x - i < proba[i] ? i : alias[i]);
+  }
+ };
+
+ /**
+  * A set of moves, known at compile time, which is itself a move.
+  *
+  * Unlike move_set, the moves are kept by value in a tuple, and called without any type erasure,
+  * and the move is chosen with an alias table, in O(1).
+  * Given to mc_generic with set_static_move_set, the whole Metropolis loop is compiled for these moves.
+  * It can also be added with add_move, like any other move.
+  * The type erased move_set is still to be used when the moves are only known at run time.
+  *
+  * @tparam MCSignType The sign type of the Monte Carlo
+  * @tparam Moves      The types of the moves. They must model the Move concept.
+  */
+ template <typename MCSignType, typename... Moves> class static_move_set {
+  static constexpr size_t N = sizeof...(Moves);
+  static_assert(N > 0, "static_move_set : no move !");
+
+  std::tuple<Moves...> moves;
+  std::array<std::string, N> names_;
+  random_generator *RNG;
+  alias_table selector;
+  size_t current = 0;
+  MCSignType try_sign_ratio;
+  std::array<uint64_t, N> n_proposed, n_accepted;
+  std::array<double, N> acceptance_rates;
+
+  // Calls f(std::get<I>(moves)) for I == i.
+  template <typename R, typename F> R _visit(size_t, F &&f, std::integral_constant<size_t, N - 1>) {
+   return f(std::get<N - 1>(moves));
+  }
+  template <typename R, typename F, size_t I> R _visit(size_t i, F &&f, std::integral_constant<size_t, I>) {
+   if (i == I) return f(std::get<I>(moves));
+   return _visit<R>(i, f, std::integral_constant<size_t, I + 1>{});
+  }
+  template <typename R, typename F> R visit(size_t i, F &&f) { return _visit<R>(i, f, std::integral_constant<size_t, 0>{}); }
+
+  // Calls f(std::get<I>(self.moves), I) for all I. Self : static_move_set, const or not.
+  template <typename Self, typename F, size_t... Is> static void _for_each(Self &self, F &&f, std14::index_sequence<Is...>) {
+   (void)std::initializer_list<int>{(f(std::get<Is>(self.moves), Is), 0)...};
+  }
+  template <typename Self, typename F> static void for_each(Self &self, F &&f) {
+   _for_each(self, f, std14::make_index_sequence<N>{});
+  }
+
+  public:
+  /**
+   * @param R                          The random generator, used to choose the move
+   * @param names                      The names of the moves
+   * @param proposition_probabilities  Probability that the moves are proposed. Precondition : >=0.
+   *                                   NB : they do not need to be normalized.
+   * @param m                          The moves
+   */
+  static_move_set(random_generator &R, std::array<std::string, N> names, std::array<double, N> const &proposition_probabilities,
+                  Moves... m)
+     : moves(std::move(m)...)
+     , names_(std::move(names))
+     , RNG(&R)
+     , selector(std::vector<double>(proposition_probabilities.begin(), proposition_probabilities.end())) {
+   n_proposed.fill(0);
+   n_accepted.fill(0);
+   acceptance_rates.fill(-1);
+  }
+
+  private:
+  // cf move_set
+  bool attempt_treat_infinite_ratio(std::complex<double>, double &) { return true; }
+
+  bool attempt_treat_infinite_ratio(double rate_ratio, double &abs_rate_ratio) {
+   bool is_inf = std::isinf(rate_ratio);
+   if (is_inf) {
+    abs_rate_ratio = 100;
+    try_sign_ratio = (std::signbit(rate_ratio) ? -1 : 1);
+   }
+   return !is_inf;
+  }
+
+  public:
+  /**
+   * Chooses a move and calls its attempt.
+   * Like move_set, returns the abs of the Metropolis ratio, the sign is kept for accept.
+   */
+  double attempt() {
+   current = selector((*RNG)());
+   ++n_proposed[current];
+   MCSignType rate_ratio = visit<MCSignType>(current, [](auto &m) { return MCSignType(m.attempt()); });
+   double abs_rate_ratio;
+   if (attempt_treat_infinite_ratio(rate_ratio, abs_rate_ratio)) {
+    if (!std::isfinite(std::abs(rate_ratio)))
+     TRIQS_RUNTIME_ERROR << "Monte Carlo Error : the rate (" << rate_ratio << ") is not finite in move " << names_[current];
+    abs_rate_ratio = std::abs(rate_ratio);
+    try_sign_ratio = (abs_rate_ratio > 1.e-14 ? rate_ratio / abs_rate_ratio : 1); // keep the sign
+   }
+   return abs_rate_ratio;
+  }
+
+  /// Accepts the move chosen by the last attempt. Returns the sign of its attempt times the sign of its accept.
+  MCSignType accept() {
+   ++n_accepted[current];
+   return try_sign_ratio * visit<MCSignType>(current, [](auto &m) { return MCSignType(m.accept()); });
+  }
+
+  /// Rejects the move chosen by the last attempt
+  void reject() {
+   visit<void>(current, [](auto &m) { m.reject(); });
+  }
+
+  /// The move I
+  template <size_t I> std14::tuple_element_t<I, std::tuple<Moves...>> &get() { return std::get<I>(moves); }
+
+  /// Reduces the acceptance rates of the moves
+  void collect_statistics(mpi::communicator const &c) {
+   for (size_t u = 0; u < N; ++u) {
+    uint64_t nacc_tot = mpi::reduce(n_accepted[u], c);
+    uint64_t nprop_tot = mpi::reduce(n_proposed[u], c);
+    acceptance_rates[u] = nacc_tot / static_cast<double>(nprop_tot);
+   }
+  }
+
+  /// Adds the numbers of proposed and accepted moves of ms (the same moves, e.g. from another walker)
+  void merge_statistics(static_move_set const &ms) {
+   for (size_t u = 0; u < N; ++u) {
+    n_proposed[u] += ms.n_proposed[u];
+    n_accepted[u] += ms.n_accepted[u];
+   }
+  }
+
+  /**
+   * Takes the snapshot of the counters and of the moves, written as h5_write (cf make_snapshot in impl_tools).
+   * Empty if one of the moves with a h5 interface has no snapshot method.
+   */
+  h5_snapshot_lambda_t make_snapshot() const {
+   std::vector<h5_snapshot_lambda_t> snap;
+   bool ok = true;
+   for_each(*this, [&](auto const &m, size_t) {
+    snap.push_back(mc_tools::make_snapshot(&m));
+    ok = ok && bool(snap.back());
+   });
+   if (!ok) return {};
+   auto names = names_;
+   auto const *self = this;
+   return [snap, names, self]() -> h5_rw_lambda_t {
+    std::vector<h5_rw_lambda_t> w;
+    for (auto const &s : snap) w.push_back(s());
+    auto np = self->n_proposed, na = self->n_accepted;
+    return [w, names, np, na](h5::group g, std::string const &name) {
+     auto gr = g.create_group(name);
+     h5_write(gr, "n_proposed", std::vector<uint64_t>(np.begin(), np.end()));
+     h5_write(gr, "n_accepted", std::vector<uint64_t>(na.begin(), na.end()));
+     for (size_t u = 0; u < w.size(); ++u)
+      if (w[u]) w[u](gr, names[u]);
+    };
+   };
+  }
+
+  /// HDF5 interface : the numbers of proposed and accepted moves, and the moves which have a h5 interface
+  friend void h5_write(h5::group g, std::string const &name, static_move_set const &ms) {
+   auto gr = g.create_group(name);
+   h5_write(gr, "n_proposed", std::vector<uint64_t>(ms.n_proposed.begin(), ms.n_proposed.end()));
+   h5_write(gr, "n_accepted", std::vector<uint64_t>(ms.n_accepted.begin(), ms.n_accepted.end()));
+   for_each(ms, [&](auto const &m, size_t u) {
+    auto w = make_h5_write(&m);
+    if (w) w(gr, ms.names_[u]);
+   });
+  }
+
+  friend void h5_read(h5::group g, std::string const &name, static_move_set &ms) {
+   auto gr = g.open_group(name);
+   std::vector<uint64_t> np, na;
+   h5_read(gr, "n_proposed", np);
+   h5_read(gr, "n_accepted", na);
+   if ((np.size() != N) || (na.size() != N)) TRIQS_RUNTIME_ERROR << "static_move_set : h5_read : not the same number of moves";
+   std::copy(np.begin(), np.end(), ms.n_proposed.begin());
+   std::copy(na.begin(), na.end(), ms.n_accepted.begin());
+   for_each(ms, [&](auto &m, size_t u) {
+    auto r = make_h5_read(&m);
+    if (r) r(gr, ms.names_[u]);
+   });
+  }
+
+  /// Acceptance rate of all moves as a map name:string -> acceptance_rate:double. Valid after collect_statistics.
+  std::map<std::string, double> get_acceptance_rates() const {
+   std::map<std::string, double> r;
+   for (size_t u = 0; u < N; ++u) r.insert({names_[u], acceptance_rates[u]});
+   return r;
+  }
+ };
+
+ /// Makes a static_move_set, deducing the types of the moves
+ template <typename MCSignType, typename... Moves>
+ static_move_set<MCSignType, std14::decay_t<Moves>...> make_static_move_set(random_generator &R,
+                                                                           std::array<std::string, sizeof...(Moves)> names,
+                                                                           std::array<double, sizeof...(Moves)> const &probas,
+                                                                           Moves &&... m) {
+  return {R, std::move(names), probas, std::forward<Moves>(m)...};
+ }
+}
+} // end namespace
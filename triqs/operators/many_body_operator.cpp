@@ -21,6 +21,8 @@
 #include "./many_body_operator.hpp"
 #include <triqs/h5.hpp>
 #include <triqs/h5/base.hpp>
+#include <mutex>
+#include <unordered_set>
 
 namespace triqs {
 namespace operators {
@@ -52,6 +54,26 @@ namespace operators {
   return os;
  }
 
+ namespace details {
+  // Hashed with equality only : indices of different operators may not be comparable with <
+  struct indices_hash {
+   size_t operator()(indices_t const& ind) const {
+    size_t h = ind.size();
+    for (auto const& x : ind) h = h * 1000003 ^ apply_visitor([](auto const& u) { return std::hash<std::decay_t<decltype(u)>>{}(u); }, x);
+    return h;
+   }
+  };
+
+  indices_t const* intern_indices(indices_t const& ind) {
+   // The table is deliberately leaked : a static operator may be destroyed after it, and still point to its indices.
+   // It is only accessed under the mutex. The elements of an unordered_set do not move on rehash.
+   static std::mutex mutex;
+   static auto* table = new std::unordered_set<indices_t, indices_hash>;
+   std::lock_guard<std::mutex> lock(mutex);
+   return &*table->insert(ind).first;
+  }
+ }
+
 
  /// ----- h5 support
 
@@ -104,7 +126,7 @@ namespace operators {
    h5_monomial y = {m.second.is_real(), real(m.second), imag(m.second), {0, 0, 0, 0}}; // we want to transform it to an h5_monomial
    int i = 0;
    for (auto const &c_cdag_op : m.first) {       // loop over the C C^+ operators of the monomial
-    long c_number = fops[c_cdag_op.indices] + 1; // the number of the C C^+ op. 0 means "no operators" here, so we shift by 1
+    long c_number = fops[*c_cdag_op.indices] + 1; // the number of the C C^+ op. 0 means "no operators" here, so we shift by 1
     y.op_indices[i++] = (c_cdag_op.dagger ? c_number : -c_number);
    }
    datavec.push_back(y);
@@ -176,10 +198,10 @@ namespace operators {
   auto r_fops = fops.reverse_map(); // a map int -> indices inverting fops[int] -> indices
 
   for (auto const &mon : datavec) {
-   monomial_t monomial;         // vector of canonical_ops_t
+   details::packed_monomial_t monomial; // the C, C^+ with interned indices
    for (int i : mon.op_indices) {                           // loop over the index of the C, C^ ops of the monomial
     if (i == 0) break;                                      // means we have reach the end of the C,  C^+ list
-    monomial.push_back({(i > 0), r_fops[std::abs(i) - 1]}); // add one C, C^+ op to the monomial
+    monomial.push_back({details::intern_indices(r_fops[std::abs(i) - 1]), (i > 0)}); // add one C, C^+ op to the monomial
    }
    real_or_complex s = (mon.is_real ? real_or_complex(mon.re) : real_or_complex(std::complex<double>(mon.re,mon.im)));
    op.monomials.insert({monomial, s}); // add the monomial to the operator
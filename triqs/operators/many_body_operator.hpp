@@ -22,8 +22,12 @@
 #include <triqs/hilbert_space/fundamental_operator_set.hpp>
 
 #include <ostream>
+#include <iterator>
 #include <cmath>
+#include <map>
+#include <unordered_map>
 #include <boost/operators.hpp>
+#include <boost/serialization/split_member.hpp>
 #include <triqs/utility/real_or_complex.hpp>
 #include <triqs/utility/numeric_ops.hpp>
 #include <triqs/h5.hpp>
@@ -78,6 +82,103 @@ namespace operators {
  bool operator<(monomial_t const& m1, monomial_t const& m2);
  std::ostream& operator<<(std::ostream& os, monomial_t const& m);
 
+ //-----------------------------------------------------------------------------------------
+ // Internal representation of the monomials.
+ // The indices are interned : all the operators share a unique copy of each indices_t, so that a canonical
+ // operator is a pointer and a bool, copied without allocation and compared by address for equality.
+ namespace details {
+
+  /// The unique copy of the indices ind. Thread safe (the table is guarded by a mutex).
+  /// The table is deliberately never destroyed, so that the copies outlive all the operators, even static ones.
+  indices_t const* intern_indices(indices_t const& ind);
+
+  struct canonical_op_id {
+   indices_t const* indices;
+   bool dagger;
+   // Same order as canonical_ops_t
+   friend bool operator<(canonical_op_id const& a, canonical_op_id const& b) {
+    if (a.dagger != b.dagger) return (a.dagger > b.dagger);
+    if (a.indices == b.indices) return false;
+    return (a.dagger ? *a.indices < *b.indices : *b.indices < *a.indices);
+   }
+   friend bool operator>(canonical_op_id const& a, canonical_op_id const& b) { return b < a; }
+   friend bool operator==(canonical_op_id const& a, canonical_op_id const& b) {
+    return a.indices == b.indices && a.dagger == b.dagger;
+   }
+   canonical_ops_t to_canonical_ops() const { return {dagger, *indices}; }
+  };
+
+  using packed_monomial_t = std::vector<canonical_op_id>;
+
+  // Same order as monomial_t
+  struct packed_monomial_less {
+   bool operator()(packed_monomial_t const& m1, packed_monomial_t const& m2) const {
+    return m1.size() != m2.size() ? m1.size() < m2.size() : std::lexicographical_compare(m1.begin(), m1.end(), m2.begin(), m2.end());
+   }
+  };
+
+  struct packed_monomial_hash {
+   size_t operator()(packed_monomial_t const& m) const {
+    size_t h = m.size();
+    for (auto const& x : m) h = h * 1000003 ^ (reinterpret_cast<size_t>(x.indices) * 2 + x.dagger);
+    return h;
+   }
+  };
+
+  inline monomial_t unpack(packed_monomial_t const& m) {
+   monomial_t res;
+   res.reserve(m.size());
+   for (auto const& x : m) res.push_back(x.to_canonical_ops());
+   return res;
+  }
+
+  // A canonical operator of a packed monomial, seen as a canonical_ops_t (dagger, indices), without copy
+  struct canonical_op_view {
+   bool dagger;
+   indices_t const& indices;
+   operator canonical_ops_t() const { return {dagger, indices}; }
+  };
+
+  // A packed monomial, seen as a monomial_t : a sequence of canonical_op_view. Unpacks nothing.
+  class monomial_view {
+   packed_monomial_t const* m;
+
+   public:
+   monomial_view(packed_monomial_t const& m) : m(&m) {}
+
+   class const_iterator : public std::iterator<std::forward_iterator_tag, canonical_op_view, long, void, canonical_op_view> {
+    packed_monomial_t::const_iterator it;
+
+    public:
+    const_iterator(packed_monomial_t::const_iterator it) : it(it) {}
+    canonical_op_view operator*() const { return {it->dagger, *it->indices}; }
+    const_iterator& operator++() {
+     ++it;
+     return *this;
+    }
+    bool operator==(const_iterator const& x) const { return it == x.it; }
+    bool operator!=(const_iterator const& x) const { return it != x.it; }
+   };
+
+   size_t size() const { return m->size(); }
+   bool empty() const { return m->empty(); }
+   canonical_op_view operator[](size_t i) const { return {(*m)[i].dagger, *(*m)[i].indices}; }
+   const_iterator begin() const { return m->begin(); }
+   const_iterator end() const { return m->end(); }
+
+   /// The monomial_t (copies the indices)
+   operator monomial_t() const { return unpack(*m); }
+   friend std::ostream& operator<<(std::ostream& os, monomial_view const& m) { return os << monomial_t(m); }
+  };
+
+  inline packed_monomial_t pack(monomial_t const& m) {
+   packed_monomial_t res;
+   res.reserve(m.size());
+   for (auto const& x : m) res.push_back({intern_indices(x.indices), x.dagger});
+   return res;
+  }
+ }
+
  //-----------------------------------------------------------------------------------------
  /**
   * many_body_operator_generic is a general operator in second quantification
@@ -93,10 +194,12 @@ namespace operators {
      boost::dividable<many_body_operator_generic<ScalarType>, ScalarType> {
 
   // Map of all monomials with coefficients
-  using monomials_map_t = std::map<monomial_t, ScalarType>;
+  using monomials_map_t = std::map<details::packed_monomial_t, ScalarType, details::packed_monomial_less>;
 
   monomials_map_t monomials;
 
+  template <typename S> friend class many_body_operator_generic;
+
   friend void h5_write(h5::group g, std::string const& name, many_body_operator const& op);
   friend void h5_write(h5::group g, std::string const& name, many_body_operator const& op,
                        hilbert_space::fundamental_operator_set const& fops);
@@ -127,34 +230,41 @@ namespace operators {
   template <typename S> many_body_operator_generic& operator=(many_body_operator_generic<S> const& x) {
    static_assert(std::is_constructible<scalar_t, S>::value, "Assignment is impossible");
    monomials.clear();
-   for (auto const& y : x.get_monomials()) monomials.insert(std::make_pair(monomial_t{y.first}, scalar_t(y.second)));
+   for (auto const& y : x.monomials) monomials.insert(std::make_pair(y.first, scalar_t(y.second)));
    return *this;
   }
 
-  // internal, for previous operator =
-  monomials_map_t const & get_monomials() const { return monomials;}
+  /**
+   * The monomials with their coefficients. Since the monomials are stored packed (cf details::packed_monomial_t),
+   * this map is built on each call : prefer iterating on the operator.
+   */
+  std::map<monomial_t, scalar_t> get_monomials() const {
+   std::map<monomial_t, scalar_t> r;
+   for (auto const& x : monomials) r.insert({details::unpack(x.first), x.second});
+   return r;
+  }
 
   /// Make a minimal fundamental_operator_set with all the canonical operators of this
   hilbert_space::fundamental_operator_set make_fundamental_operator_set() const {
    hilbert_space::fundamental_operator_set fops;
    for (auto const& m : monomials)        // for all monomials of the operator
     for (auto const& c_cdag_op : m.first) // loop over the C C^+ operators of the monomial
-     fops.insert_from_indices_t(c_cdag_op.indices);
+     fops.insert_from_indices_t(*c_cdag_op.indices);
    return fops;
   }
 
   // factory for c, cdag
   static many_body_operator_generic make_canonical(bool is_dag, indices_t indices) {
    many_body_operator_generic res;
-   auto m = monomial_t{canonical_ops_t{is_dag, indices}};
+   auto m = details::packed_monomial_t{{details::intern_indices(indices), is_dag}};
    res.monomials.insert({m, scalar_t(1.0)});
    return res;
   }
 
   // We use utility::dressed_iterator to dress iterators
-  // _cdress is a simple struct of refs to dress the iterators (Cf doc)
+  // _cdress dresses the iterators (Cf doc). The monomial is a view of the packed one : nothing is copied on dereference.
   struct _cdress {
-   monomial_t const& monomial;
+   details::monomial_view monomial;
    scalar_t coef;
    _cdress(typename monomials_map_t::const_iterator _it) : monomial(_it->first), coef(_it->second) {}
    operator std::pair<std::vector<std::pair<bool,indices_t>>,scalar_t>() {
@@ -188,7 +298,7 @@ namespace operators {
    if (is_zero(alpha)) return *this;
    bool is_new_monomial;
    typename monomials_map_t::iterator it;
-   std::tie(it, is_new_monomial) = monomials.insert(std::make_pair(monomial_t(0), alpha));
+   std::tie(it, is_new_monomial) = monomials.insert(std::make_pair(details::packed_monomial_t{}, alpha));
    if (!is_new_monomial) {
     it->second += alpha;
     erase_zero_monomial(monomials, it);
@@ -241,32 +351,42 @@ namespace operators {
   }
 
   many_body_operator_generic& operator*=(many_body_operator_generic const& op) {
-   monomials_map_t tmp_map; // product will be stored here
+   // Large products are accumulated in a hash map, then sorted
+   if (monomials.size() * op.monomials.size() > 64)
+    multiply_into<std::unordered_map<details::packed_monomial_t, ScalarType, details::packed_monomial_hash>>(op);
+   else
+    multiply_into<monomials_map_t>(op);
+   return *this;
+  }
+
+  private:
+  template <typename MapType> void multiply_into(many_body_operator_generic const& op) {
+   MapType tmp_map; // product will be stored here
+   details::packed_monomial_t product_m;
    for (auto const& m : monomials)
     for (auto const& op_m : op.monomials) {
      // prepare an unnormalized product
-     monomial_t product_m;
-     product_m.reserve(m.first.size() + op_m.first.size());
-     for (auto const& op : m.first) product_m.push_back(op);
-     for (auto const& op : op_m.first) product_m.push_back(op);
-     // std::copy(m.first.begin(), m.first.end(), std::back_inserter(product_m));
-     // std::copy(op_m.first.begin(), op_m.first.end(), std::back_inserter(product_m));
+     product_m.clear();
+     product_m.insert(product_m.end(), m.first.begin(), m.first.end());
+     product_m.insert(product_m.end(), op_m.first.begin(), op_m.first.end());
      normalize_and_insert(product_m, m.second * op_m.second, tmp_map);
     }
-   std::swap(monomials, tmp_map);
-   return *this;
+   monomials = monomials_map_t(std::make_move_iterator(tmp_map.begin()), std::make_move_iterator(tmp_map.end()));
   }
 
+  public:
+
   // implementation details of dagger
   //
   private:
 
-  static canonical_ops_t _dagger(canonical_ops_t const& cop) {
-   return {!cop.dagger, cop.indices};
+  static details::canonical_op_id _dagger(details::canonical_op_id const& cop) {
+   return {cop.indices, !cop.dagger};
   }
 
-  static monomial_t _dagger(monomial_t const& m) {
-   monomial_t res;
+  static details::packed_monomial_t _dagger(details::packed_monomial_t const& m) {
+   details::packed_monomial_t res;
+   res.reserve(m.size());
    for (auto it = m.rbegin(); it != m.rend(); ++it) res.push_back(_dagger(*it));
    return res;
   }
@@ -276,7 +396,7 @@ namespace operators {
   friend many_body_operator_generic dagger(many_body_operator_generic const& op) {
    many_body_operator_generic res;
    using triqs::utility::conj;
-   for (auto const& x : op) res.monomials.insert({_dagger(x.monomial), conj(x.coef)});
+   for (auto const& x : op.monomials) res.monomials.insert({_dagger(x.first), conj(x.second)});
    return res;
   }
 
@@ -285,9 +405,9 @@ namespace operators {
    many_body_operator_generic res;
    using triqs::utility::real;
    using triqs::utility::is_zero;
-   for (auto const& x : op) {
-    auto c = real(x.coef);
-    if(!is_zero(c)) res.monomials.insert({x.monomial, c});
+   for (auto const& x : op.monomials) {
+    auto c = real(x.second);
+    if(!is_zero(c)) res.monomials.insert({x.first, c});
    }
    return res;
   }
@@ -297,20 +417,31 @@ namespace operators {
    many_body_operator_generic res;
    using triqs::utility::imag;
    using triqs::utility::is_zero;
-   for (auto const& x : op) {
-    auto c = imag(x.coef);
-    if(!is_zero(c)) res.monomials.insert({x.monomial, c});
+   for (auto const& x : op.monomials) {
+    auto c = imag(x.second);
+    if(!is_zero(c)) res.monomials.insert({x.first, c});
    }
    return res;
   }
 
-  // Boost.Serialization
+  // Boost.Serialization : same archive as a std::map<monomial_t, ScalarType>
   friend class boost::serialization::access;
-  template <class Archive> void serialize(Archive& ar, const unsigned int version) { ar& monomials; }
+  template <class Archive> void save(Archive& ar, const unsigned int version) const {
+   std::map<monomial_t, ScalarType> m;
+   for (auto const& x : monomials) m.insert({details::unpack(x.first), x.second});
+   ar << m;
+  }
+  template <class Archive> void load(Archive& ar, const unsigned int version) {
+   std::map<monomial_t, ScalarType> m;
+   ar >> m;
+   monomials.clear();
+   for (auto const& x : m) monomials.insert({details::pack(x.first), x.second});
+  }
+  BOOST_SERIALIZATION_SPLIT_MEMBER();
 
   private:
   // Normalize a monomial and insert into a map
-  static void normalize_and_insert(monomial_t& m, scalar_t coeff, monomials_map_t& target) {
+  template <typename MapType> static void normalize_and_insert(details::packed_monomial_t& m, scalar_t coeff, MapType& target) {
    // The normalization is done by employing a simple bubble sort algorithms.
    // Apart from sorting elements this function keeps track of the sign and
    // recursively calls itself if a permutation of two operators produces a new
@@ -320,16 +451,13 @@ namespace operators {
     do {
      is_swapped = false;
      for (std::size_t n = 1; n < m.size(); ++n) {
-      canonical_ops_t& prev_index = m[n - 1];
-      canonical_ops_t& cur_index = m[n];
+      auto& prev_index = m[n - 1];
+      auto& cur_index = m[n];
       if (prev_index == cur_index) return; // The monomial is effectively zero
       if (prev_index > cur_index) {
        // Are we swapping C and C^+ with the same indices?
-       // A bit ugly ...
-       canonical_ops_t cur_index_flipped_type(cur_index);
-       cur_index_flipped_type.dagger = !cur_index_flipped_type.dagger;
-       if (prev_index == cur_index_flipped_type) {
-        monomial_t new_m;
+       if (prev_index.indices == cur_index.indices) {
+        details::packed_monomial_t new_m;
         new_m.reserve(m.size() - 2);
         std::copy(m.begin(), m.begin() + n - 1, std::back_inserter(new_m));
         std::copy(m.begin() + n + 1, m.end(), std::back_inserter(new_m));
@@ -345,7 +473,7 @@ namespace operators {
 
    // Insert the result
    bool is_new_monomial;
-   typename monomials_map_t::iterator it;
+   typename MapType::iterator it;
    std::tie(it, is_new_monomial) = target.insert(std::make_pair(m, coeff));
    if (!is_new_monomial) {
     it->second += coeff;
@@ -354,7 +482,7 @@ namespace operators {
   }
 
   // Erase a monomial with a close-to-zero coefficient.
-  static void erase_zero_monomial(monomials_map_t& m, typename monomials_map_t::iterator& it) {
+  template <typename MapType> static void erase_zero_monomial(MapType& m, typename MapType::iterator& it) {
    using triqs::utility::is_zero;
    if (is_zero(it->second)) m.erase(it);
   }
@@ -366,7 +494,7 @@ namespace operators {
     for (auto const& m : op.monomials) {
      os << (print_plus ? " + " : "") << m.second;
      if (m.first.size()) os << "*";
-     os << m.first;
+     for (auto const& c : m.first) os << "C" << c.to_canonical_ops();
      print_plus = true;
     }
    } else
@@ -20,8 +20,11 @@
  ******************************************************************************/
 #pragma once
 #include "./first_include.hpp"
+#include "./exceptions.hpp"
 #include <vector>
 #include <functional>
+#include <sstream>
+#include <limits>
 
 namespace triqs {
 namespace utility {
@@ -33,9 +36,45 @@ namespace utility {
   *  - do not pay the indirection cost at each call, but once every size call.
   *  - erase the function type
   * It is a semi-regular type.
+  *
+  * If the function can be written to/read from a stream (operator << and >>, like the boost random engines),
+  * the state of the buffered_function can be saved and restored, cf get_state/set_state.
   */
  template <typename R> struct buffered_function {
 
+  private:
+  enum class op_t { refill, save, load };
+
+  // Does f have the stream operators ?
+  template <typename F, typename = void> struct is_streamable : std::false_type {};
+  template <typename F>
+  struct is_streamable<F, decltype(void(std::declval<std::ostream &>() << std::declval<F const &>()),
+                                   void(std::declval<std::istream &>() >> std::declval<F &>()))> : std::true_type {};
+
+  template <typename F> static void save_load(F &f, op_t op, std::iostream &s, std::true_type) {
+   if (op == op_t::save)
+    s << f;
+   else
+    s >> f;
+  }
+  template <typename F> static void save_load(F &, op_t, std::iostream &, std::false_type) {
+   TRIQS_RUNTIME_ERROR << "buffered_function : the state of this function can not be saved";
+  }
+
+  // Makes the implementation from the refill of the buffer with f.
+  template <typename F, typename Refill> void make_impl(F f, Refill r) {
+   impl = [f, r](buffered_function *bf, op_t op, std::iostream *s) mutable { // mutable : f is modified
+    if (op == op_t::refill) {
+     r(f, bf->buffer);
+     bf->index = 0;
+    } else
+     save_load(f, op, *s, is_streamable<F>{});
+   };
+   impl(this, op_t::refill, nullptr); // first filling of the buffer
+  }
+
+  public:
+
   /// Default constructor : no function bufferized. () will throw in this state
   buffered_function() = default;
 
@@ -46,30 +85,71 @@ namespace utility {
    * @param size : size of the buffer [optional]
    */
   template <typename Function> buffered_function(Function f, size_t size = 1000) : buffer(size) {
-   refill = [f](buffered_function *bf) mutable { // without the mutable, the () of the lambda object is const, hence f
-    for (auto &x : bf->buffer) x = f();
-    bf->index = 0;
-   };
-   refill(this); // first filling of the buffer
+   make_impl(std::move(f), [](Function &g, std::vector<R> &buf) {
+    for (auto &x : buf) x = g();
+   });
+  }
+
+  /// Tag for the batch constructor
+  struct batch_t {};
+
+  /** Constructor from a batch function, which fills the whole buffer in one call.
+   *
+   * @tparam BatchFunction : type of the function, called as f(R * data, size_t n) to fill data[0:n]
+   * @param f : function to bufferize
+   * @param size : size of the buffer [optional]
+   */
+  template <typename BatchFunction> buffered_function(batch_t, BatchFunction f, size_t size = 1000) : buffer(size) {
+   make_impl(std::move(f), [](BatchFunction &g, std::vector<R> &buf) { g(buf.data(), buf.size()); });
   }
 
   /// Returns the next element. Refills the buffer if necessary.
   R operator()() {
-   if (index > buffer.size() - 1) refill(this);
+   if (index > buffer.size() - 1) impl(this, op_t::refill, nullptr);
    return buffer[index++];
   }
 
   /// Returns the future next element, without increasing the index. Refills the buffer if necessary.
   R preview() {
-   if (index > buffer.size() - 1) refill(this);
+   if (index > buffer.size() - 1) impl(this, op_t::refill, nullptr);
    return buffer[index];
   }
 
+  /**
+   * The state of the function and of the buffer, as a string.
+   * A buffered_function of the same function (type and size of the buffer), with this state, gives the same sequence.
+   * Throws if the function has no stream operators.
+   */
+  std::string get_state() const {
+   std::stringstream s;
+   s.precision(std::numeric_limits<R>::max_digits10); // exact round trip of floating values
+   s << buffer.size() << ' ' << index;
+   for (size_t i = index; i < buffer.size(); ++i) s << ' ' << buffer[i];
+   s << ' ';
+   impl(const_cast<buffered_function *>(this), op_t::save, &s); // NB : save does not modify this
+   s << ' ';                                                     // some engines (boost::mt19937) read past their state
+   return s.str();
+  }
+
+  /// Restores a state given by get_state.
+  void set_state(std::string const &state) {
+   std::stringstream s(state);
+   size_t size, idx;
+   s >> size >> idx;
+   if (!s || (size != buffer.size()) || (idx > size))
+    TRIQS_RUNTIME_ERROR << "buffered_function : set_state : the state does not match this buffered_function";
+   for (size_t i = idx; i < size; ++i) s >> buffer[i];
+   impl(this, op_t::load, &s);
+   if (!s) TRIQS_RUNTIME_ERROR << "buffered_function : set_state : the state is invalid";
+   index = idx;
+  }
+
   private:
   size_t index;
   std::vector<R> buffer;
-  std::function<void(buffered_function *)> refill; // this refills the buffer and reset index of a buffered_function.
-  // NB : cannot capture this in refill because we want the object to be copyable and movable
+  // refills the buffer and reset index of a buffered_function, or saves/loads the state of the function.
+  // NB : cannot capture this in impl because we want the object to be copyable and movable
+  std::function<void(buffered_function *, op_t, std::iostream *)> impl;
  };
 }
 }
@@ -98,6 +98,26 @@ namespace utility {
    cyclicArray[1] = x;
   }
  };
+
+ /*
+   The Legendre polynomials at n points at once : p[l * n + k] = P_l(x[k]) for 0 <= l < n_l.
+   Same recurrence as legendre_generator, but each step is a loop over the points, which is vectorized.
+   The projections on the P_l, e.g. the transforms imtime <-> Legendre or the accumulation of the
+   Legendre coefficients of a batch of Monte Carlo samples, are then matrix products with p, seen as
+   a (n_l, n) row major matrix.
+ */
+ inline void legendre_basis(double const *x, long n, int n_l, double *p) {
+  if (n_l > 0)
+   for (long k = 0; k < n; ++k) p[k] = 1.0;
+  if (n_l > 1)
+   for (long k = 0; k < n; ++k) p[n + k] = x[k];
+  for (int l = 2; l < n_l; ++l) {
+   double a = (2 * l - 1) / double(l), b = (l - 1) / double(l);
+   double *p0 = p + l * n;
+   double const *p1 = p0 - n, *p2 = p1 - n;
+   for (long k = 0; k < n; ++k) p0[k] = a * x[k] * p1[k] - b * p2[k];
+  }
+ }
 }
 };
 
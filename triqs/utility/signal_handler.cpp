@@ -21,19 +21,27 @@
 #include "signal_handler.hpp"
 #include <signal.h>
 #include <string.h>
-#include <vector>
+#include <atomic>
 #include <iostream>
 namespace triqs {
 namespace signal_handler {
 
  namespace {
 
-  std::vector<int> signals_list;
+  // The signals received. slot runs while other threads (e.g. the walkers of mc_multi_walker) call received() :
+  // the list is a fixed array, and its size a lock free atomic, which is all received() reads.
+  static_assert(ATOMIC_INT_LOCK_FREE == 2, "signal_handler needs a lock free std::atomic<int>");
+  const int max_signals = 64;
+  int signals_list[max_signals];
+  std::atomic<int> n_signals{0};
   bool initialized = false;
 
   void slot(int signal) {
    std::cerr << "TRIQS : Received signal " << signal << std::endl;
-   signals_list.push_back(signal);
+   int n = n_signals.load();
+   if (n == max_signals) return;
+   signals_list[n] = signal;
+   n_signals.store(n + 1);
   }
  }
 
@@ -53,19 +61,20 @@ namespace signal_handler {
  }
 
  void stop() {
-  signals_list.clear();
+  n_signals.store(0);
   initialized = false;
  }
 
  bool received(bool pop_) {
   //if (!initialized) start();
-  bool r = signals_list.size() != 0;
+  bool r = n_signals.load() != 0;
   if (r && pop_) pop();
   return r;
  }
 
- int last() { return signals_list.back(); }
- void pop() { return signals_list.pop_back(); }
+ int last() { return signals_list[n_signals.load() - 1]; }
+ void pop() {
+  if (n_signals.load() > 0) n_signals.fetch_sub(1);
+ }
 }
 }
-
@@ -30,6 +30,7 @@ namespace signal_handler {
  void stop();
  
  /// A signal has been received. If pop, and there is a signal, pop it.
+ /// Without pop, it can be called by several threads at the same time.
  bool received(bool pop = false);
 
  /// Last received.
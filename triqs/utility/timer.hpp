@@ -35,7 +35,7 @@ public:
   timer():running(false) {}
   void start() { running= true; Clock1 = clock();}
   void stop() { Clock2 = clock(); running = false;}
-  operator double() const {return  (Clock2 - Clock1)/CLOCKS_PER_SEC;}  
+  operator double() const {return  double(Clock2 - Clock1)/CLOCKS_PER_SEC;}  
   };
 }
 }